@@ -0,0 +1,212 @@
+#include "BatchRunner.h"
+#include "ImageFile.h"
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+struct WorkQueue {
+    mutex lock;
+    deque<size_t> jobs;
+};
+
+// Own work comes off the back, stolen work off the front
+bool pop_job(vector<unique_ptr<WorkQueue>>& queues, size_t self, size_t& job) {
+    {
+        WorkQueue& own = *queues[self];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.jobs.empty()) {
+            job = own.jobs.back();
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues.size(); i++) {
+        WorkQueue& victim = *queues[(self + i) % queues.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.jobs.empty()) {
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t parse_number(const string& text, uint64_t max, const string& key, int line) {
+    char* end = nullptr;
+    uint64_t value = strtoull(text.c_str(), &end, 0);
+    if (text.empty() || *end != '\0' || value > max) {
+        throw runtime_error("manifest line " + to_string(line) + ": bad value for " + key + ": " + text);
+    }
+    return value;
+}
+
+shared_ptr<const vector<uint8_t>> read_image(const string& path) {
+    MappedFile file(path);
+    if (file.size() > 65536) {
+        throw runtime_error("image " + path + " is larger than 64KB");
+    }
+    return make_shared<vector<uint8_t>>(file.data(), file.data() + file.size());
+}
+
+} // namespace
+
+BatchRunner::BatchRunner(unsigned threads) : threads(threads) {
+    if (this->threads == 0) {
+        this->threads = max(1u, thread::hardware_concurrency());
+    }
+}
+
+BatchResult BatchRunner::run_job(const BatchJob& job, const MemoryImage* image) {
+    unique_ptr<CPU65C02> cpu(new CPU65C02(false));
+    if (image) {
+        cpu->load_image(*image);
+    } else if (job.image) {
+        cpu->load_program(job.image->data(), job.image->size(), job.load_address);
+    }
+    cpu->reset();
+    CPU65C02::Registers regs = {};
+    regs.PC = job.PC == BatchJob::RESET_VECTOR ? cpu->get_PC() : job.PC;
+    regs.A = job.A;
+    regs.X = job.X;
+    regs.Y = job.Y;
+    regs.S = job.S;
+    regs.set_P(job.P);
+    cpu->set_registers(regs);
+
+    BatchResult result;
+    result.name = job.name;
+    result.reason = cpu->run_cycles(job.max_cycles);
+    result.regs = cpu->get_registers();
+    result.cycles = cpu->get_cycles();
+    result.memory_digest = memory_digest(*cpu);
+    return result;
+}
+
+vector<BatchResult> BatchRunner::run(const vector<BatchJob>& jobs) {
+    vector<BatchResult> results(jobs.size());
+    if (jobs.empty()) {
+        return results;
+    }
+
+    // Deal contiguous runs of jobs to each queue; neighbouring manifest
+    // lines tend to share an image, which then stays warm in one core's cache.
+    size_t worker_count = min<size_t>(threads, jobs.size());
+    vector<unique_ptr<WorkQueue>> queues;
+    for (size_t i = 0; i < worker_count; i++) {
+        queues.emplace_back(new WorkQueue);
+    }
+    for (size_t i = 0; i < jobs.size(); i++) {
+        queues[i * worker_count / jobs.size()]->jobs.push_back(i);
+    }
+
+    // One MemoryImage per distinct program and load address; every job
+    // running it maps the same read-only pages.
+    map<pair<const vector<uint8_t>*, uint16_t>, shared_ptr<MemoryImage>> images;
+    vector<const MemoryImage*> job_images(jobs.size(), nullptr);
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (!jobs[i].image) {
+            continue;
+        }
+        shared_ptr<MemoryImage>& image = images[make_pair(jobs[i].image.get(), jobs[i].load_address)];
+        if (!image) {
+            image = make_shared<MemoryImage>(jobs[i].image->data(), jobs[i].image->size(), jobs[i].load_address);
+        }
+        job_images[i] = image.get();
+    }
+
+    auto worker = [&](size_t self) {
+        size_t job;
+        while (pop_job(queues, self, job)) {
+            results[job] = run_job(jobs[job], job_images[job]);
+        }
+    };
+    vector<thread> pool;
+    for (size_t i = 1; i < worker_count; i++) {
+        pool.emplace_back(worker, i);
+    }
+    worker(0);
+    for (thread& t : pool) {
+        t.join();
+    }
+    return results;
+}
+
+vector<BatchJob> load_manifest(istream& in, const string& base_dir) {
+    vector<BatchJob> jobs;
+    map<string, shared_ptr<const vector<uint8_t>>> images;
+    string text;
+    int line = 0;
+    while (getline(in, text)) {
+        line++;
+        text = text.substr(0, text.find('#'));
+        istringstream fields(text);
+        string field;
+        BatchJob job;
+        bool any = false;
+        while (fields >> field) {
+            any = true;
+            size_t eq = field.find('=');
+            if (eq == string::npos) {
+                throw runtime_error("manifest line " + to_string(line) + ": expected key=value, got " + field);
+            }
+            string key = field.substr(0, eq);
+            string value = field.substr(eq + 1);
+            if (key == "name") {
+                job.name = value;
+            } else if (key == "image") {
+                string path = base_dir.empty() || value[0] == '/' ? value : base_dir + "/" + value;
+                auto cached = images.find(path);
+                if (cached == images.end()) {
+                    cached = images.emplace(path, read_image(path)).first;
+                }
+                job.image = cached->second;
+                if (job.name.empty()) {
+                    job.name = value;
+                }
+            } else if (key == "load") {
+                job.load_address = parse_number(value, 0xFFFF, key, line);
+            } else if (key == "pc") {
+                job.PC = parse_number(value, 0xFFFF, key, line);
+            } else if (key == "a") {
+                job.A = parse_number(value, 0xFF, key, line);
+            } else if (key == "x") {
+                job.X = parse_number(value, 0xFF, key, line);
+            } else if (key == "y") {
+                job.Y = parse_number(value, 0xFF, key, line);
+            } else if (key == "s") {
+                job.S = parse_number(value, 0xFF, key, line);
+            } else if (key == "p") {
+                job.P = parse_number(value, 0xFF, key, line);
+            } else if (key == "cycles") {
+                job.max_cycles = parse_number(value, UINT64_MAX, key, line);
+            } else {
+                throw runtime_error("manifest line " + to_string(line) + ": unknown key " + key);
+            }
+        }
+        if (!any) {
+            continue;
+        }
+        if (!job.image) {
+            throw runtime_error("manifest line " + to_string(line) + ": missing image=");
+        }
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+uint64_t memory_digest(CPU65C02& cpu) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (uint32_t addr = 0; addr < 65536; addr++) {
+        hash = (hash ^ cpu.get_RAM(addr)) * 0x100000001b3ULL;
+    }
+    return hash;
+}
@@ -0,0 +1,62 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include "CPU65C02.h"
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One program to run: an image, where to load it and the starting registers
+struct BatchJob {
+    static const uint32_t RESET_VECTOR = 0x10000; // PC: start where $FFFC points
+
+    std::string name;
+    std::shared_ptr<const std::vector<uint8_t>> image; // Shared between jobs using the same file
+    uint16_t load_address = 0;
+    uint32_t PC = RESET_VECTOR;
+    uint8_t A = 0, X = 0, Y = 0, S = 0xFF, P = 0;
+    uint64_t max_cycles = 1000000000;
+};
+
+// Final state of a job once its CPU stopped
+struct BatchResult {
+    std::string name;
+    CPU65C02::StopReason reason = CPU65C02::StopReason::Budget;
+    CPU65C02::Registers regs = {};
+    uint64_t cycles = 0;
+    uint64_t memory_digest = 0; // FNV-1a over the full 64KB address space
+};
+
+// Runs independent jobs on a pool of worker threads. Each worker owns a
+// deque of job indices and steals from the others once its own runs dry, so
+// a few long programs do not leave the remaining cores idle.
+class BatchRunner {
+public:
+    explicit BatchRunner(unsigned threads = 0); // 0 = one per hardware thread
+    unsigned get_threads() const { return threads; }
+
+    // Results are returned in job order
+    std::vector<BatchResult> run(const std::vector<BatchJob>& jobs);
+
+    // Run one job. With an image the CPU maps its pages instead of copying
+    // job.image in, so jobs sharing a program share its memory too.
+    static BatchResult run_job(const BatchJob& job, const MemoryImage* image = nullptr);
+
+private:
+    unsigned threads;
+};
+
+// Parse a manifest with one job per line of key=value fields:
+//
+//   name=boot image=rom.bin load=0x8000 pc=0x8000 a=0 x=0 y=0 s=0xFF p=0 cycles=1000000
+//
+// Only image= is required. Numbers accept decimal or 0x-prefixed hex, image
+// paths are relative to base_dir, and '#' starts a comment. Throws
+// std::runtime_error on malformed lines or unreadable images.
+std::vector<BatchJob> load_manifest(std::istream& in, const std::string& base_dir);
+
+uint64_t memory_digest(CPU65C02& cpu);
+
+#endif // BATCH_RUNNER_H
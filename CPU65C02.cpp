@@ -1,4 +1,7 @@
 #include "CPU65C02.h"
+#include "Jit.h"
+#include "Profiler.h"
+#include "TraceRecorder.h"
 #include <algorithm>
 #include <cstdio>
 #include <iomanip>
@@ -7,14 +10,6 @@
 using namespace std;
 
 
-uint8_t CPU65C02::fetch_byte() {
-    return RAM[PC++];
-}
-
-uint8_t CPU65C02::fetch_byte(uint16_t addr) {
-    return RAM[addr];
-}
-
 
 void CPU65C02::debug_print(const char* message) {
     #ifdef DEBUG
@@ -29,247 +24,88 @@ uint16_t CPU65C02::fetch_word() {
     return (high_byte << 8) | low_byte;  // 6502 is little-endian
 }
 
-void CPU65C02::update_flags(uint8_t value) {
-    // Update Zero flag
-    if (value == 0) {
-        status |= 0x02;  // Set Zero flag
-    } else {
-        status &= ~0x02; // Clear Zero flag
-    }
-    
-    // Update Negative flag
-    if (value & 0x80) {
-        status |= 0x80;  // Set Negative flag
-    } else {
-        status &= ~0x80; // Clear Negative flag
+
+// Every table below has one entry per row of the opcode map. The map must
+// therefore list all 256 opcodes in order, or a table would be short and an
+// opcode would dispatch to a null handler.
+static constexpr uint8_t opcode_rows[] = {
+    #define OPCODE(op, fn, bytes, cycles) op,
+    #include "CPU65C02_opcodes.def"
+};
+
+static constexpr bool opcode_map_complete() {
+    for (unsigned op = 0; op < 256; op++) {
+        if (opcode_rows[op] != op) {
+            return false;
+        }
     }
+    return true;
+}
+
+static_assert(sizeof(opcode_rows) == 256 && opcode_map_complete(),
+              "CPU65C02_opcodes.def must have one row per opcode, in order");
+
+// Instruction lengths, base cycle counts and block terminators, from the
+// opcode map
+static const uint8_t instruction_bytes[256] = {
+    #define OPCODE(op, fn, bytes, cycles) bytes,
+    #include "CPU65C02_opcodes.def"
+};
+
+static const uint8_t instruction_cycles[256] = {
+    #define OPCODE(op, fn, bytes, base) base,
+    #include "CPU65C02_opcodes.def"
+};
+
+static const bool ends_block[256] = {
+    #define OPCODE(op, fn, bytes, cycles) false,
+    #define JUMP(op, fn, bytes, cycles) true,
+    #include "CPU65C02_opcodes.def"
+};
+
+// Executions before the Jit engine translates a block, unless set otherwise
+static const uint32_t JIT_THRESHOLD = 16;
+
+// Dispatch tables, constant-initialized from the opcode map
+template <class Trace>
+constexpr CPU65C02::OpCodeFn CPU65C02::opcode_tables[256] = {
+    #define OPCODE(op, fn, bytes, cycles) &CPU65C02::fn<Trace>,
+    #include "CPU65C02_opcodes.def"
+};
+
+template <class Trace>
+constexpr CPU65C02::DecodedFn CPU65C02::decoded_tables[256] = {
+    #define OPCODE(op, fn, bytes, cycles) &CPU65C02::call_decoded<&CPU65C02::fn<Decoded<Trace>>>,
+    #include "CPU65C02_opcodes.def"
+};
+
+CPU65C02::CPU65C02(bool debug_mode)
+    : debug(debug_mode),
+      opcode_table(debug_mode ? opcode_tables<DebugTrace> : opcode_tables<NoTrace>),
+      irq_lines(0), nmi_pending(false), waiting(false), brk_stops(true),
+      decoded_table(debug_mode ? decoded_tables<DebugTrace> : decoded_tables<NoTrace>),
+      stale_pages(), code_stale(false), running_blocks(false), code_generation(1),
+      jit_threshold(JIT_THRESHOLD), jit_exit(nullptr),
+      recorder(nullptr), profiler(nullptr), watch_hit(), breakpoint_resume(NO_BREAKPOINT) {
+    memory.set_watcher(this);
+    scheduler.set_watcher(this);
+    set_engine(Engine::Switch);
+    reset();
 }
 
-CPU65C02::CPU65C02(bool debug_mode) : debug(debug_mode) {
-    reset();
-    // Simple instruction set with real opcodes
-    // LDA series
-    opcode_table[0xA9] = &CPU65C02::LDA_IMM;   // LDA Immediate
-    opcode_table[0xA5] = &CPU65C02::LDA_ZP; // LDA Zero Page
-    opcode_table[0xB5] = &CPU65C02::LDA_ZP_X; // LDA Zero Page, X
-    opcode_table[0xAD] = &CPU65C02::LDA_ABS; // LDA Absolute
-    opcode_table[0xBD] = &CPU65C02::LDA_ABS_X; // LDA Absolute, X
-    opcode_table[0xB9] = &CPU65C02::LDA_ABS_Y; // LDA Absolute, Y
-    opcode_table[0xA1] = &CPU65C02::LDA_PRE_IND_X; // LDA Indirect, X
-    opcode_table[0xB1] = &CPU65C02::LDA_POST_IND_Y; // LDA Indirect, Y
-    opcode_table[0xB2] = &CPU65C02::LDA_IND; // LDA Indirect
-
-    // LDX series
-    opcode_table[0xA2] = &CPU65C02::LDX_IMM;  // LDX Immediate
-    opcode_table[0xA6] = &CPU65C02::LDX_ZP;  // LDX Zero Page
-    opcode_table[0xB6] = &CPU65C02::LDX_ZP_Y;  // LDX Zero Page, Y
-    opcode_table[0xAE] = &CPU65C02::LDX_ABS;  // LDX Absolute
-    opcode_table[0xBE] = &CPU65C02::LDX_ABS_Y;  // LDX Absolute, Y
-
-    // LDY series
-    opcode_table[0xA0] = &CPU65C02::LDY_IMM;  // LDY Immediate
-    opcode_table[0xA4] = &CPU65C02::LDY_ZP;  // LDY Zero Page
-    opcode_table[0xB4] = &CPU65C02::LDY_ZP_X;  // LDY Zero Page, X
-    opcode_table[0xAC] = &CPU65C02::LDY_ABS;  // LDY Absolute
-    opcode_table[0xBC] = &CPU65C02::LDY_ABS_X;  // LDY Absolute, X
-
-    // STA series
-    opcode_table[0x85] = &CPU65C02::STA_ZP;  // STA Zero Page
-    opcode_table[0x95] = &CPU65C02::STA_ZP_X;  // STA Zero Page, X
-    opcode_table[0x8D] = &CPU65C02::STA_ABS;  // STA Absolute
-    opcode_table[0x9D] = &CPU65C02::STA_ABS_X;  // STA Absolute, X
-    opcode_table[0x99] = &CPU65C02::STA_ABS_Y;  // STA Absolute, Y
-    opcode_table[0x81] = &CPU65C02::STA_PRE_IND_X;  // STA Indirect, X
-    opcode_table[0x91] = &CPU65C02::STA_POST_IND_Y;  // STA Indirect, Y
-    opcode_table[0x92] = &CPU65C02::STA_IND;  // STA Indirect
-
-    // STX series
-    opcode_table[0x86] = &CPU65C02::STX_ZP;  // STX Zero Page
-    opcode_table[0x96] = &CPU65C02::STX_ZP_Y;  // STX Zero Page, Y
-    opcode_table[0x8E] = &CPU65C02::STX_ABS;  // STX Absolute
-
-    // STY series
-    opcode_table[0x84] = &CPU65C02::STY_ZP;  // STY Zero Page
-    opcode_table[0x94] = &CPU65C02::STY_ZP_X;  // STY Zero Page, X
-    opcode_table[0x8C] = &CPU65C02::STY_ABS;  // STY Absolute
-    opcode_table[0x4C] = &CPU65C02::JMP;  // JMP Absolute
-    opcode_table[0x00] = &CPU65C02::BRK;  // BRK
-    opcode_table[0xEA] = &CPU65C02::NOP;  // NOP
-    opcode_table[0x40] = &CPU65C02::RTI;  // RTI
-
-    // ADC series
-    opcode_table[0x69] = &CPU65C02::ADC_IMM;   // ADC Immediate
-    opcode_table[0x65] = &CPU65C02::ADC_ZP;    // ADC Zero Page
-    opcode_table[0x75] = &CPU65C02::ADC_ZP_X;  // ADC Zero Page, X
-    opcode_table[0x6D] = &CPU65C02::ADC_ABS;   // ADC Absolute
-    opcode_table[0x7D] = &CPU65C02::ADC_ABS_X; // ADC Absolute, X
-    opcode_table[0x79] = &CPU65C02::ADC_ABS_Y; // ADC Absolute, Y
-    opcode_table[0x61] = &CPU65C02::ADC_PRE_IND_X;  // ADC Indirect, X
-    opcode_table[0x71] = &CPU65C02::ADC_POST_IND_Y; // ADC Indirect, Y
-    opcode_table[0x72] = &CPU65C02::ADC_IND;   // ADC Indirect
-
-    // SBC series
-    opcode_table[0xE9] = &CPU65C02::SBC_IMM;   // SBC Immediate
-    opcode_table[0xE5] = &CPU65C02::SBC_ZP;    // SBC Zero Page
-    opcode_table[0xF5] = &CPU65C02::SBC_ZP_X;  // SBC Zero Page, X
-    opcode_table[0xED] = &CPU65C02::SBC_ABS;   // SBC Absolute
-    opcode_table[0xFD] = &CPU65C02::SBC_ABS_X; // SBC Absolute, X
-    opcode_table[0xF9] = &CPU65C02::SBC_ABS_Y; // SBC Absolute, Y
-    opcode_table[0xE1] = &CPU65C02::SBC_PRE_IND_X;  // SBC Indirect, X
-    opcode_table[0xF1] = &CPU65C02::SBC_POST_IND_Y; // SBC Indirect, Y
-    opcode_table[0xF2] = &CPU65C02::SBC_IND;   // SBC Indirect
-
-    // INC series
-    opcode_table[0xE6] = &CPU65C02::INC_ZP;    // INC Zero Page
-    opcode_table[0xF6] = &CPU65C02::INC_ZP_X;  // INC Zero Page, X
-    opcode_table[0xEE] = &CPU65C02::INC_ABS;   // INC Absolute
-    opcode_table[0xFE] = &CPU65C02::INC_ABS_X; // INC Absolute, X
-
-    // INX/INY
-    opcode_table[0xE8] = &CPU65C02::INX;       // INX
-    opcode_table[0xC8] = &CPU65C02::INY;       // INY
-
-    // DEC series
-    opcode_table[0xC6] = &CPU65C02::DEC_ZP;    // DEC Zero Page
-    opcode_table[0xD6] = &CPU65C02::DEC_ZP_X;  // DEC Zero Page, X
-    opcode_table[0xCE] = &CPU65C02::DEC_ABS;   // DEC Absolute
-    opcode_table[0xDE] = &CPU65C02::DEC_ABS_X; // DEC Absolute, X
-
-    // DEX/DEY
-    opcode_table[0xCA] = &CPU65C02::DEX;       // DEX
-    opcode_table[0x88] = &CPU65C02::DEY;       // DEY
-
-    // AND series
-    opcode_table[0x29] = &CPU65C02::AND_IMM;   // AND Immediate
-    opcode_table[0x25] = &CPU65C02::AND_ZP;    // AND Zero Page
-    opcode_table[0x35] = &CPU65C02::AND_ZP_X;  // AND Zero Page, X
-    opcode_table[0x2D] = &CPU65C02::AND_ABS;   // AND Absolute
-    opcode_table[0x3D] = &CPU65C02::AND_ABS_X; // AND Absolute, X
-    opcode_table[0x39] = &CPU65C02::AND_ABS_Y; // AND Absolute, Y
-    opcode_table[0x21] = &CPU65C02::AND_PRE_IND_X;  // AND Indirect, X
-    opcode_table[0x31] = &CPU65C02::AND_POST_IND_Y; // AND Indirect, Y
-    opcode_table[0x32] = &CPU65C02::AND_IND;   // AND Indirect
-
-    // ORA series
-    opcode_table[0x09] = &CPU65C02::ORA_IMM;   // ORA Immediate
-    opcode_table[0x05] = &CPU65C02::ORA_ZP;    // ORA Zero Page
-    opcode_table[0x15] = &CPU65C02::ORA_ZP_X;  // ORA Zero Page, X
-    opcode_table[0x0D] = &CPU65C02::ORA_ABS;   // ORA Absolute
-    opcode_table[0x1D] = &CPU65C02::ORA_ABS_X; // ORA Absolute, X
-    opcode_table[0x19] = &CPU65C02::ORA_ABS_Y; // ORA Absolute, Y
-    opcode_table[0x01] = &CPU65C02::ORA_PRE_IND_X;  // ORA Indirect, X
-    opcode_table[0x11] = &CPU65C02::ORA_POST_IND_Y; // ORA Indirect, Y
-    opcode_table[0x12] = &CPU65C02::ORA_IND;   // ORA Indirect
-
-    // EOR series
-    opcode_table[0x49] = &CPU65C02::EOR_IMM;   // EOR Immediate
-    opcode_table[0x45] = &CPU65C02::EOR_ZP;    // EOR Zero Page
-    opcode_table[0x55] = &CPU65C02::EOR_ZP_X;  // EOR Zero Page, X
-    opcode_table[0x4D] = &CPU65C02::EOR_ABS;   // EOR Absolute
-    opcode_table[0x5D] = &CPU65C02::EOR_ABS_X; // EOR Absolute, X
-    opcode_table[0x59] = &CPU65C02::EOR_ABS_Y; // EOR Absolute, Y
-    opcode_table[0x41] = &CPU65C02::EOR_PRE_IND_X;  // EOR Indirect, X
-    opcode_table[0x51] = &CPU65C02::EOR_POST_IND_Y; // EOR Indirect, Y
-    opcode_table[0x52] = &CPU65C02::EOR_IND;   // EOR Indirect
-
-    // ASL series
-    opcode_table[0x0A] = &CPU65C02::ASL_ACC;   // ASL Accumulator
-    opcode_table[0x06] = &CPU65C02::ASL_ZP;    // ASL Zero Page
-    opcode_table[0x16] = &CPU65C02::ASL_ZP_X;  // ASL Zero Page, X
-    opcode_table[0x0E] = &CPU65C02::ASL_ABS;   // ASL Absolute
-    opcode_table[0x1E] = &CPU65C02::ASL_ABS_X; // ASL Absolute, X
-
-    // LSR series
-    opcode_table[0x4A] = &CPU65C02::LSR_ACC;   // LSR Accumulator
-    opcode_table[0x46] = &CPU65C02::LSR_ZP;    // LSR Zero Page
-    opcode_table[0x56] = &CPU65C02::LSR_ZP_X;  // LSR Zero Page, X
-    opcode_table[0x4E] = &CPU65C02::LSR_ABS;   // LSR Absolute
-    opcode_table[0x5E] = &CPU65C02::LSR_ABS_X; // LSR Absolute, X
-
-    // ROL series
-    opcode_table[0x2A] = &CPU65C02::ROL_ACC;   // ROL Accumulator
-    opcode_table[0x26] = &CPU65C02::ROL_ZP;    // ROL Zero Page
-    opcode_table[0x36] = &CPU65C02::ROL_ZP_X;  // ROL Zero Page, X
-    opcode_table[0x2E] = &CPU65C02::ROL_ABS;   // ROL Absolute
-    opcode_table[0x3E] = &CPU65C02::ROL_ABS_X; // ROL Absolute, X
-
-    // ROR series
-    opcode_table[0x6A] = &CPU65C02::ROR_ACC;   // ROR Accumulator
-    opcode_table[0x66] = &CPU65C02::ROR_ZP;    // ROR Zero Page
-    opcode_table[0x76] = &CPU65C02::ROR_ZP_X;  // ROR Zero Page, X
-    opcode_table[0x6E] = &CPU65C02::ROR_ABS;   // ROR Absolute
-    opcode_table[0x7E] = &CPU65C02::ROR_ABS_X; // ROR Absolute, X
-
-    // Stack Operations
-    opcode_table[0x48] = &CPU65C02::PHA;  // PHA
-    opcode_table[0x08] = &CPU65C02::PHP;  // PHP
-    opcode_table[0x68] = &CPU65C02::PLA;  // PLA
-    opcode_table[0x28] = &CPU65C02::PLP;  // PLP
-    opcode_table[0xBA] = &CPU65C02::TSX;  // TSX
-    opcode_table[0x9A] = &CPU65C02::TXS;  // TXS
-
-    // Branch Instructions
-    opcode_table[0x90] = &CPU65C02::BCC;  // BCC
-    opcode_table[0xB0] = &CPU65C02::BCS;  // BCS
-    opcode_table[0xF0] = &CPU65C02::BEQ;  // BEQ
-    opcode_table[0xD0] = &CPU65C02::BNE;  // BNE
-    opcode_table[0x30] = &CPU65C02::BMI;  // BMI
-    opcode_table[0x10] = &CPU65C02::BPL;  // BPL
-    opcode_table[0x50] = &CPU65C02::BVC;  // BVC
-    opcode_table[0x70] = &CPU65C02::BVS;  // BVS
-
-    // Status Flag Operations
-    opcode_table[0x18] = &CPU65C02::CLC;  // CLC
-    opcode_table[0x38] = &CPU65C02::SEC;  // SEC
-    opcode_table[0xD8] = &CPU65C02::CLD;  // CLD
-    opcode_table[0xF8] = &CPU65C02::SED;  // SED
-    opcode_table[0x58] = &CPU65C02::CLI;  // CLI
-    opcode_table[0x78] = &CPU65C02::SEI;  // SEI
-    opcode_table[0xB8] = &CPU65C02::CLV;  // CLV
-
-    // Comparison Operations
-    opcode_table[0xC9] = &CPU65C02::CMP_IMM;   // CMP Immediate
-    opcode_table[0xC5] = &CPU65C02::CMP_ZP;    // CMP Zero Page
-    opcode_table[0xD5] = &CPU65C02::CMP_ZP_X;  // CMP Zero Page, X
-    opcode_table[0xCD] = &CPU65C02::CMP_ABS;   // CMP Absolute
-    opcode_table[0xDD] = &CPU65C02::CMP_ABS_X; // CMP Absolute, X
-    opcode_table[0xD9] = &CPU65C02::CMP_ABS_Y; // CMP Absolute, Y
-    opcode_table[0xC1] = &CPU65C02::CMP_PRE_IND_X;  // CMP Indirect, X
-    opcode_table[0xD1] = &CPU65C02::CMP_POST_IND_Y; // CMP Indirect, Y
-    opcode_table[0xD2] = &CPU65C02::CMP_IND;   // CMP Indirect
-
-    opcode_table[0xE0] = &CPU65C02::CPX_IMM;   // CPX Immediate
-    opcode_table[0xE4] = &CPU65C02::CPX_ZP;    // CPX Zero Page
-    opcode_table[0xEC] = &CPU65C02::CPX_ABS;   // CPX Absolute
-
-    opcode_table[0xC0] = &CPU65C02::CPY_IMM;   // CPY Immediate
-    opcode_table[0xC4] = &CPU65C02::CPY_ZP;    // CPY Zero Page
-    opcode_table[0xCC] = &CPU65C02::CPY_ABS;   // CPY Absolute
-
-    // Additional 65C02-specific instructions
-    opcode_table[0x80] = &CPU65C02::BRA;       // BRA
-    opcode_table[0xDA] = &CPU65C02::PHX;       // PHX
-    opcode_table[0x5A] = &CPU65C02::PHY;       // PHY
-    opcode_table[0xFA] = &CPU65C02::PLX;       // PLX
-    opcode_table[0x7A] = &CPU65C02::PLY;       // PLY
-    opcode_table[0x64] = &CPU65C02::STZ_ZP;    // STZ Zero Page
-    opcode_table[0x74] = &CPU65C02::STZ_ZP_X;  // STZ Zero Page, X
-    opcode_table[0x9C] = &CPU65C02::STZ_ABS;   // STZ Absolute
-    opcode_table[0x9E] = &CPU65C02::STZ_ABS_X; // STZ Absolute, X
-    opcode_table[0x14] = &CPU65C02::TRB_ZP;    // TRB Zero Page
-    opcode_table[0x1C] = &CPU65C02::TRB_ABS;   // TRB Absolute
-    opcode_table[0x04] = &CPU65C02::TSB_ZP;    // TSB Zero Page
-    opcode_table[0x0C] = &CPU65C02::TSB_ABS;   // TSB Absolute
+CPU65C02::~CPU65C02() {
 }
 
+// The IRQ lines belong to the devices driving them, so they survive a reset
 void CPU65C02::reset() {
-    A = 0;
-    X = 0;
-    Y = 0;
-    P = 0;
-    S = 0;
-    PC = 0;
-    status = 0;
+    regs.A = 0;
+    regs.X = 0;
+    regs.Y = 0;
+    regs.S = 0xFF;
+    regs.set_P(0x04);  // Interrupts disabled, binary mode
+    regs.PC = fetch_byte(0xFFFC) | (fetch_byte(0xFFFD) << 8);
+    nmi_pending = false;
+    waiting = false;
     cycles = 0;  // Reset cycle counter
 }
 
@@ -277,1584 +113,2649 @@ void CPU65C02::reset_cycles() {
     cycles = 0;
 }
 
-void CPU65C02::load_program(uint8_t* program, size_t size) {
-    memcpy(RAM, program, size);
+void CPU65C02::load_program(const uint8_t* program, size_t size, uint16_t address) {
+    memory.load(program, size, address);
+}
+
+void CPU65C02::load_image(const MemoryImage& image) {
+    memory.map(image);
+}
+
+CPU65C02::Snapshot CPU65C02::snapshot() {
+    Snapshot s;
+    s.regs = regs;
+    s.cycles = cycles;
+    s.irq_lines = irq_lines;
+    s.nmi_pending = nmi_pending;
+    s.waiting = waiting;
+    s.memory = memory.snapshot();
+    return s;
+}
+
+void CPU65C02::restore(const Snapshot& s) {
+    regs = s.regs;
+    cycles = s.cycles;
+    irq_lines = s.irq_lines;
+    nmi_pending = s.nmi_pending;
+    waiting = s.waiting;
+    memory.restore(s.memory);
+}
+
+
+void CPU65C02::set_registers(const Registers& r) {
+    regs = r;
+    regs.status &= 0x3C;
+    regs.flag_n &= 0x80;
+    regs.flag_z = regs.flag_z != 0;
+    regs.flag_c = regs.flag_c != 0;
+    regs.flag_v &= 0x80;
 }
 
+void CPU65C02::set_engine(Engine e) {
+    #if !CPU65C02_COMPUTED_GOTO
+    if (e == Engine::Threaded) e = Engine::Switch;  // Needs GCC/Clang labels-as-values
+    #endif
+    #if !CPU65C02_JIT
+    if (e == Engine::Jit) e = Engine::Block;  // Needs x86-64 Linux
+    #endif
+    engine = e;
+}
 
 void CPU65C02::execute() {
     debug_print("Starting program execution");
-    bool running = true;
-    while (running && PC < 65535) {
-        uint8_t opcode = RAM[PC];
-        if (opcode == 0x00) {  // BRK instruction
-            running = false;
-            cout << "BRK - Program terminated" << endl;
+    StopReason reason = debug ? run<DebugTrace, false>(UINT64_MAX, 0)
+                              : run<NoTrace, false>(UINT64_MAX, 0);
+    if (reason == StopReason::Brk) {
+        cout << "BRK - Program terminated" << endl;
+    } else if (reason == StopReason::Halt) {
+        cout << "Halted at $" << hex << regs.PC << " - Program terminated" << endl;
+    } else if (reason == StopReason::Wait) {
+        cout << "Waiting for an interrupt at $" << hex << regs.PC << endl;
+    } else if (reason == StopReason::Breakpoint) {
+        cout << "Breakpoint at $" << hex << regs.PC << endl;
+    } else if (reason == StopReason::Watchpoint) {
+        cout << (watch_hit.write ? "Wrote $" : "Read $") << hex << (int)watch_hit.value << " at $"
+             << watch_hit.address << " - stopped at $" << regs.PC << endl;
+    }
+    debug_print("Program execution completed");
+}
+
+CPU65C02::StopReason CPU65C02::run_cycles(uint64_t n) {
+    uint64_t deadline = n > UINT64_MAX - cycles ? UINT64_MAX : cycles + n;
+    return debug ? run<DebugTrace, false>(deadline, 0) : run<NoTrace, false>(deadline, 0);
+}
+
+CPU65C02::StopReason CPU65C02::run_instructions(uint64_t n) {
+    return debug ? run<DebugTrace, true>(UINT64_MAX, n) : run<NoTrace, true>(UINT64_MAX, n);
+}
+
+void CPU65C02::request_stop(StopReason reason) {
+    stop_reason = reason;
+    deadline = 0;  // Fails the run loop's deadline compare after this instruction
+}
+
+void CPU65C02::assert_irq(uint8_t source) {
+    irq_lines |= source;
+    poll_interrupts();
+}
+
+void CPU65C02::release_irq(uint8_t source) {
+    irq_lines &= ~source;
+}
+
+void CPU65C02::nmi() {
+    nmi_pending = true;
+    poll_interrupts();
+}
+
+// A device event is now due before the run loop's deadline
+void CPU65C02::next_event_changed(uint64_t time) {
+    deadline = min(deadline, time);
+}
+
+// The deadline for carrying on the current run: the end of the budget or
+// the next device event, or right away if an interrupt is waiting
+void CPU65C02::restore_deadline() {
+    deadline = min(cycle_limit, scheduler.next_time());
+    poll_interrupts();
+}
+
+// Called whenever an interrupt may have become takeable: a line was raised
+// or I was cleared. Lowering the deadline gets the run loop back to run(),
+// which takes it.
+void CPU65C02::poll_interrupts() {
+    if (interrupt_ready()) {
+        deadline = 0;
+    }
+}
+
+const char* CPU65C02::stop_reason_name(StopReason reason) {
+    switch (reason) {
+    case StopReason::Budget: return "budget";
+    case StopReason::Brk: return "brk";
+    case StopReason::Halt: return "halt";
+    case StopReason::Wait: return "wait";
+    case StopReason::Breakpoint: return "breakpoint";
+    case StopReason::Watchpoint: return "watchpoint";
+    }
+    return "unknown";
+}
+
+const char* CPU65C02::engine_name(Engine e) {
+    switch (e) {
+    case Engine::Table: return "table";
+    case Engine::Switch: return "switch";
+    case Engine::Threaded: return "threaded";
+    case Engine::Block: return "block";
+    case Engine::Jit: return "jit";
+    }
+    return "unknown";
+}
+
+// Memory is about to change bytes some cached blocks were decoded from. The
+// block being run may be one of them, so the blocks are only dropped at the
+// next instruction boundary; lowering the deadline gets the block loop there.
+// Breakpoints put every engine in the block loop, so it is tested rather
+// than the engine.
+void CPU65C02::page_written(unsigned page) {
+    stale_pages[page] = true;
+    stale_pages[(page - 1) & 0xFF] = true;  // Blocks starting there can run into this page
+    code_stale = true;
+    if (running_blocks) {
+        deadline = 0;
+    }
+}
+
+void CPU65C02::add_breakpoint(uint16_t pc, StopCondition condition) {
+    breakpoints[pc] = condition;
+    page_written(pc >> 8);  // Rebuild the blocks that may hold pc
+    deadline = 0;  // Back to run(), which picks the core
+}
+
+void CPU65C02::remove_breakpoint(uint16_t pc) {
+    if (breakpoints.erase(pc)) {
+        page_written(pc >> 8);
+        deadline = 0;
+    }
+}
+
+void CPU65C02::clear_breakpoints() {
+    while (!breakpoints.empty()) {
+        remove_breakpoint(breakpoints.begin()->first);
+    }
+}
+
+void CPU65C02::add_watchpoint(uint16_t first, uint16_t last, bool reads, bool writes, StopCondition condition) {
+    watchpoints.push_back(Watchpoint{ first, last, reads, writes, condition });
+    memory.trap(first, last, reads, writes);
+}
+
+void CPU65C02::clear_watchpoints() {
+    watchpoints.clear();
+    memory.clear_traps();
+}
+
+// Memory trapped an access for some watchpoint; it takes effect once the
+// instruction has finished, like any other request_stop()
+void CPU65C02::access_trapped(uint16_t addr, uint8_t value, bool write) {
+    for (const Watchpoint& w : watchpoints) {
+        if (addr < w.first || addr > w.last || !(write ? w.writes : w.reads)) {
+            continue;
+        }
+        watch_hit.address = addr;
+        watch_hit.value = value;
+        watch_hit.write = write;
+        if (!w.condition || w.condition(*this)) {
+            request_stop(StopReason::Watchpoint);
+            return;
+        }
+    }
+}
+
+// At a breakpoint's PC: whether to stop there, which is not the case for
+// the breakpoint the last run stopped on nor when its condition fails
+bool CPU65C02::breakpoint_stops() {
+    if (breakpoint_resume == regs.PC) {
+        breakpoint_resume = NO_BREAKPOINT;
+        return false;
+    }
+    auto it = breakpoints.find(regs.PC);
+    if (it == breakpoints.end() || (it->second && !it->second(*this))) {
+        return false;
+    }
+    breakpoint_resume = regs.PC;
+    request_stop(StopReason::Breakpoint);
+    return true;
+}
+
+// The block cache entry of an instruction with a breakpoint. Its block holds
+// nothing else and leaves PC on the instruction, which is run from memory
+// unless the breakpoint stops the run.
+void CPU65C02::breakpoint_trap() {
+    if (breakpoint_stops()) {
+        return;
+    }
+    uint8_t op = fetch_byte();
+    cycles += instruction_cycles[op];
+    (this->*opcode_table[op])();
+}
+
+void CPU65C02::flush_stale_code() {
+    for (unsigned p = 0; p < 256; p++) {
+        if (stale_pages[p]) {
+            code_pages[p].reset();
+            stale_pages[p] = false;
+        }
+    }
+    code_stale = false;
+    code_generation++;
+}
+
+// Called when the block loop finds its budget spent: carry on if that was
+// only page_written() asking for the cache to be flushed. A spent
+// instruction count leaves the deadline alone, and always ends the run.
+bool CPU65C02::resume_after_code_write() {
+    if (!code_stale || stop_reason != StopReason::Budget || cycles < deadline) {
+        return false;
+    }
+    flush_stale_code();
+    restore_deadline();
+    return true;
+}
+
+CPU65C02::Block* CPU65C02::find_block(uint16_t address) {
+    CodePage* code = code_pages[address >> 8].get();
+    if (code && code->blocks[address & 0xFF]) {
+        return code->blocks[address & 0xFF].get();
+    }
+    return build_block(address);
+}
+
+// Decode from address up to the first instruction other than a conditional
+// branch that may change PC, or the first one starting on another page.
+// Returns null when the first instruction touches an I/O page; that code is
+// left to the interpreter. An instruction with a breakpoint is a block of
+// its own, with breakpoint_trap() in place of its handler.
+CPU65C02::Block* CPU65C02::build_block(uint16_t address) {
+    unique_ptr<Block> block(new Block());
+    block->address = address;
+    uint16_t pc = address;
+    for (;;) {
+        bool breakpoint = has_breakpoint(pc);
+        if (breakpoint && pc != address) {
+            break;
+        }
+        uint8_t op = memory.peek(pc);
+        unsigned bytes = instruction_bytes[op];
+        if (memory.is_io(pc >> 8) || memory.is_io((uint16_t)(pc + bytes - 1) >> 8)) {
+            break;
+        }
+        DecodedOp decoded;
+        decoded.handler = decoded_table[op];
+        decoded.operand = 0;
+        for (unsigned i = bytes - 1; i > 0; i--) {
+            decoded.operand = (decoded.operand << 8) | memory.peek(pc + i);
+        }
+        decoded.next_pc = pc + bytes;
+        decoded.opcode = op;
+        decoded.cycles = instruction_cycles[op];
+        if (breakpoint) {
+            decoded.handler = &call_decoded<&CPU65C02::breakpoint_trap>;
+            decoded.next_pc = pc;
+            decoded.cycles = 0;
+        }
+        block->ops.push_back(decoded);
+        memory.watch(pc, bytes);
+        pc += bytes;
+        if (breakpoint || (ends_block[op] && !conditional_branch(op)) || (pc >> 8) != (address >> 8)) {
             break;
         }
+    }
+    if (block->ops.empty()) {
+        return nullptr;
+    }
+    unique_ptr<CodePage>& code = code_pages[address >> 8];
+    if (!code) {
+        code.reset(new CodePage());
+    }
+    code->blocks[address & 0xFF] = move(block);
+    return code->blocks[address & 0xFF].get();
+}
+
+// Returns false if the translation buffer had to be emptied, which drops
+// every block, this one included
+bool CPU65C02::translate(Block& block) {
+    if (!jit) {
+        jit.reset(new Jit());
+    }
+    if (jit->compile(*this, block)) {
+        return true;
+    }
+    jit->clear();
+    fill(stale_pages, stale_pages + 256, true);
+    flush_stale_code();
+    return false;
+}
+
+// Let from's native code jump straight into to's next time it ends at to
+void CPU65C02::link_block(Block& from, const Block& to) {
+    BlockLink& link = from.links[to.address == from.ops[from.native_ops - 1].next_pc ? 1 : 0];
+    link.pc = to.address;
+    link.generation = code_generation;
+    link.body = to.native_body;
+}
+
+// Device events and interrupts are handled here, between calls into the
+// core, so the cores never test for them: the core runs to the next event's
+// cycle count, and raising an interrupt lowers the deadline so the core
+// returns at the next instruction boundary. The instruction countdown wraps
+// once it is spent.
+template <class Trace, bool CountInstructions>
+CPU65C02::StopReason CPU65C02::run(uint64_t cycle_deadline, uint64_t instructions) {
+    cycle_limit = cycle_deadline;
+    stop_reason = StopReason::Budget;
+    if (breakpoint_resume != regs.PC) {
+        breakpoint_resume = NO_BREAKPOINT;  // Moved off the breakpoint since
+    }
+    while (stop_reason == StopReason::Budget && cycles < cycle_limit &&
+           !(CountInstructions && instructions == UINT64_MAX)) {
+        scheduler.run_due(cycles);
+        if (waiting) {
+            if (!nmi_pending && !irq_lines) {
+                // Nothing happens until the next event, so skip to it
+                if (scheduler.empty()) {
+                    stop_reason = StopReason::Wait;
+                    break;
+                }
+                cycles = min(scheduler.next_time(), cycle_limit);
+                continue;
+            }
+            waiting = false;  // Any interrupt ends WAI, even an IRQ masked by I
+        }
+        if (nmi_pending) {
+            nmi_pending = false;
+            enter_interrupt<Trace>(0xFFFA);
+        } else if (irq_lines && !(regs.status & 0x04)) {
+            enter_interrupt<Trace>(0xFFFE);
+        }
+        restore_deadline();
+        if (stop_reason != StopReason::Budget) {
+            break;  // A device event or the interrupt's pushes hit a stop
+        }
+        run_core<Trace, CountInstructions>(instructions);
+        running_blocks = false;
+    }
+    return stop_reason;
+}
+
+template <class Trace, bool CountInstructions>
+void CPU65C02::run_core(uint64_t& instructions) {
+    if (recorder || profiler) {
+        run_instrumented<Trace, CountInstructions>(instructions);
+        return;
+    }
+    if (!breakpoints.empty() && engine != Engine::Jit) {
+        run_block<Trace, CountInstructions>(instructions);  // Breakpoints live in the block cache
+        return;
+    }
+    switch (engine) {
+    case Engine::Jit:
+        run_jit<Trace, CountInstructions>(instructions);
+        break;
+    case Engine::Block:
+        run_block<Trace, CountInstructions>(instructions);
+        break;
+    case Engine::Threaded:
+        run_threaded<Trace, CountInstructions>(instructions);
+        break;
+    case Engine::Switch:
+        run_switch<Trace, CountInstructions>(instructions);
+        break;
+    default:
+        run_table<Trace, CountInstructions>(instructions);
+        break;
+    }
+}
+
+// Every core checks the same condition between instructions: one compare of
+// the cycle counter against the deadline, plus an instruction countdown when
+// the budget is given in instructions. Handlers that need to stop the run
+// (BRK, STP) go through request_stop(), which clears the deadline; WAI and
+// interrupts clear it to get back to run().
+//
+// Every core also charges the base cycle count from the opcode map before
+// running a handler; handlers only add the page-cross and branch penalties.
+#define CPU65C02_BUDGET_SPENT() \
+    (cycles >= deadline || (CountInstructions && instructions-- == 0))
+
+// Reference core: one indirect call through opcode_table per instruction
+template <class Trace, bool CountInstructions>
+void CPU65C02::run_table(uint64_t& instructions) {
+    while (!CPU65C02_BUDGET_SPENT()) {
         #ifdef DEBUG
-            cout << "PC: " << hex << (int)PC << endl;
+            cout << "PC: " << hex << (int)regs.PC << endl;
         #endif
-        #ifdef SINGLE_STEP
-            input();
-        #endif  
         debug_print("Fetching next instruction");
-        (this->*opcode_table[RAM[PC++]])();
+        uint8_t op = fetch_byte();
+        cycles += instruction_cycles[op];
+        (this->*opcode_table[op])();
     }
-    debug_print("Program execution completed");
 }
 
-void CPU65C02::input() {
-    cout << "\nPress Enter to continue...";
-    cin.get();
+// Portable core: the handlers are expanded into one switch so the compiler
+// can inline them, leaving a single jump-table branch per instruction.
+template <class Trace, bool CountInstructions>
+void CPU65C02::run_switch(uint64_t& instructions) {
+    while (!CPU65C02_BUDGET_SPENT()) {
+        switch (fetch_byte()) {
+        #define OPCODE(op, fn, bytes, base) case op: cycles += base; fn<Trace>(); break;
+        #include "CPU65C02_opcodes.def"
+        }
+    }
 }
 
+// Threaded core: every handler body ends with its own indirect jump to the
+// next one, which gives the branch predictor one history slot per opcode
+// instead of a single shared dispatch branch.
+template <class Trace, bool CountInstructions>
+void CPU65C02::run_threaded(uint64_t& instructions) {
+#if CPU65C02_COMPUTED_GOTO
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wpedantic"
+    static void* const dispatch[256] = {
+        #define OPCODE(op, fn, bytes, cycles) &&op_##op,
+        #include "CPU65C02_opcodes.def"
+    };
+    #define NEXT() \
+        if (CPU65C02_BUDGET_SPENT()) return; \
+        goto *dispatch[fetch_byte()]
+
+    NEXT();
+    #define OPCODE(op, fn, bytes, base) op_##op: cycles += base; fn<Trace>(); NEXT();
+    #include "CPU65C02_opcodes.def"
+
+    #undef NEXT
+    #pragma GCC diagnostic pop
+#else
+    run_switch<Trace, CountInstructions>(instructions);
+#endif
+}
+
+// Run one block through its decoded handlers, or one instruction through
+// opcode_table when there is no block (code on an I/O page). Returns false
+// once the run is over.
+template <class Trace, bool CountInstructions>
+bool CPU65C02::run_decoded(const Block* block, uint64_t& instructions) {
+    if (!block) {
+        if (CPU65C02_BUDGET_SPENT()) {
+            return resume_after_code_write();
+        }
+        if (has_breakpoint(regs.PC)) {
+            breakpoint_trap();
+            return true;
+        }
+        uint8_t op = fetch_byte();
+        cycles += instruction_cycles[op];
+        (this->*opcode_table[op])();
+        return true;
+    }
+    for (const DecodedOp& op : block->ops) {
+        if (CPU65C02_BUDGET_SPENT()) {
+            return resume_after_code_write();  // The cache was flushed: look the block up again
+        }
+        regs.PC = op.next_pc;
+        decoded_operand = op.operand;
+        cycles += op.cycles;
+        op.handler(*this);
+        if (regs.PC != op.next_pc) {
+            return true;  // A taken branch leaves the block
+        }
+    }
+    return true;
+}
+
+// Block core: runs pre-decoded blocks from the block cache, so the opcode
+// and operands of each instruction are fetched from memory once per decode
+// rather than once per execution.
+template <class Trace, bool CountInstructions>
+void CPU65C02::run_block(uint64_t& instructions) {
+    running_blocks = true;
+    for (;;) {
+        if (code_stale) {
+            flush_stale_code();
+        }
+        if (!run_decoded<Trace, CountInstructions>(find_block(regs.PC), instructions)) {
+            return;
+        }
+    }
+}
+
+// JIT core: the block core, plus translation of blocks that have run
+// jit_threshold times. Translated blocks run linked to each other until the
+// deadline passes or one ends somewhere new; this loop then links it to the
+// block found there. Traced and instruction-counted runs use the block core.
+template <class Trace, bool CountInstructions>
+void CPU65C02::run_jit(uint64_t& instructions) {
+#if CPU65C02_JIT
+    if constexpr (Trace::enabled || CountInstructions) {
+        run_block<Trace, CountInstructions>(instructions);
+    } else {
+        running_blocks = true;
+        Block* from = nullptr;
+        for (;;) {
+            if (code_stale) {
+                flush_stale_code();
+                from = nullptr;
+            }
+            Block* block = find_block(regs.PC);
+            if (block && !block->native && ++block->runs >= jit_threshold && !translate(*block)) {
+                from = nullptr;
+                continue;
+            }
+            if (!block || !block->native) {
+                from = nullptr;
+                if (!run_decoded<Trace, CountInstructions>(block, instructions)) {
+                    return;
+                }
+                continue;
+            }
+            if (from) {
+                link_block(*from, *block);
+            }
+            if (CPU65C02_BUDGET_SPENT()) {
+                if (!resume_after_code_write()) {
+                    return;
+                }
+                from = nullptr;
+                continue;
+            }
+            jit_exit = nullptr;
+            block->native(this);
+            from = jit_exit;
+        }
+    }
+#else
+    run_block<Trace, CountInstructions>(instructions);
+#endif
+}
+
+// Instrumented core for tracing and profiling: the switch core, with the
+// registers captured before each instruction and handed to the recorder and
+// profiler once it has run. BRK and STP stop the run without taking any
+// cycles, so they are not counted. This core looks at every instruction
+// anyway, so it checks for breakpoints itself.
+template <class Trace, bool CountInstructions>
+void CPU65C02::run_instrumented(uint64_t& instructions) {
+    while (!CPU65C02_BUDGET_SPENT()) {
+        if (has_breakpoint(regs.PC) && breakpoint_stops()) {
+            return;
+        }
+        TraceRecord record;
+        record.pc = regs.PC;
+        record.opcode = memory.peek(regs.PC);
+        record.operand[0] = memory.peek(regs.PC + 1);
+        record.operand[1] = memory.peek(regs.PC + 2);
+        record.A = regs.A;
+        record.X = regs.X;
+        record.Y = regs.Y;
+        record.S = regs.S;
+        record.P = regs.P();
+        record.kind = TRACE_INSTRUCTION;
+        uint64_t before = cycles;
+        switch (fetch_byte()) {
+        #define OPCODE(op, fn, bytes, base) case op: cycles += base; fn<Trace>(); break;
+        #include "CPU65C02_opcodes.def"
+        }
+        if (cycles != before) {
+            record.cycles = cycles - before;
+            if (recorder) {
+                recorder->append(record);
+            }
+            if (profiler) {
+                profiler->count(record.pc, record.opcode, record.operand[0], record.operand[1], record.cycles);
+            }
+        }
+    }
+}
+
+#undef CPU65C02_BUDGET_SPENT
+
 void CPU65C02::print_registers() {
-    if (debug) cout << "A: $" << hex << (int)A << ", X: $" << (int)X << ", Y: $" << (int)Y << ", P: $" << (int)P << ", S: $" << (int)S << ", PC: $" << PC << endl;
+    cout << "A: $" << hex << (int)regs.A << ", X: $" << (int)regs.X << ", Y: $" << (int)regs.Y << ", P: $" << (int)regs.P() << ", S: $" << (int)regs.S << ", PC: $" << regs.PC << endl;
 }
 
 // LDA instructions implementation
+template <class Trace>
 void CPU65C02::LDA_ZP() {
-    uint8_t addr = fetch_byte();
-    A = RAM[addr];
-    update_flags(A);
-    cycles += 3;  // LDA ZP takes 3 cycles
-    if (debug) cout << "LDA $" << hex << (int)addr << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>();
+    regs.A = fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "LDA $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDA_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    A = RAM[addr];
-    update_flags(A);
-    cycles += 4;  // LDA ZP,X takes 4 cycles
-    if (debug) cout << "LDA $" << hex << (int)addr << ",X" << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    regs.A = fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "LDA $" << hex << (int)addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDA_IMM() {
     debug_print("Executing LDA_IMM");
-    A = fetch_byte();
-    update_flags(A);
-    cycles += 2;  // LDA IMM takes 2 cycles
-    if (debug) cout << "LDA #$" << hex << (int)A << endl;
-    print_registers();
+    regs.A = fetch_operand<Trace>();
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "LDA #$" << hex << (int)regs.A << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDA_ABS() {
-    uint16_t addr = fetch_word();
-    A = RAM[addr];
-    update_flags(A);
-    cycles += 4;  // LDA ABS takes 4 cycles
-    if (debug) cout << "LDA $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    regs.A = fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "LDA $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDA_ABS_Y() {
-    uint16_t addr = fetch_word();
-    A = fetch_byte(addr + Y);
-    update_flags(A);
-    cycles += 4;  // LDA ABS,Y takes 4 cycles (5 if page boundary crossed)
-    if (debug) cout << "LDA $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    cycles += page_crossed(addr, addr + regs.Y);
+    regs.A = fetch_byte(addr + regs.Y);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "LDA $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDA_ABS_X() {
-    uint16_t addr = fetch_word();
-    A = fetch_byte(addr + X);
-    update_flags(A);
-    cycles += 4;  // LDA ABS,X takes 4 cycles (5 if page boundary crossed)
-    if (debug) cout << "LDA $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    cycles += page_crossed(addr, addr + regs.X);
+    regs.A = fetch_byte(addr + regs.X);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "LDA $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDA_PRE_IND_X() {
-    uint8_t addr = fetch_byte() + X;
-    A = fetch_byte(addr) + (fetch_byte(addr + 1) << 8);
-    update_flags(A);
-    cycles += 6;  // LDA (ZP,X) takes 6 cycles
-    if (debug) cout << "LDA ($" << hex << (int)addr << ",X)" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>() + regs.X;
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    regs.A = fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "LDA ($" << hex << (int)zp_addr << ",X)" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDA_POST_IND_Y() {
-    uint8_t pre_zp_addr = fetch_byte();
-    uint16_t base = fetch_byte(pre_zp_addr) + (fetch_byte(pre_zp_addr + 1) << 8);
-    A = fetch_byte(base + Y);
-    update_flags(A);
-    cycles += 5;  // LDA (ZP),Y takes 5 cycles (6 if page boundary crossed)
-    if (debug)cout << "LDA ($" << hex << (int)pre_zp_addr << "),Y" << endl;
-    print_registers();
+    uint8_t pre_zp_addr = fetch_operand<Trace>();
+    uint16_t base = fetch_byte(pre_zp_addr) + (fetch_byte((uint8_t)(pre_zp_addr + 1)) << 8);
+    cycles += page_crossed(base, base + regs.Y);
+    regs.A = fetch_byte(base + regs.Y);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "LDA ($" << hex << (int)pre_zp_addr << "),Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDA_IND() {
-    uint8_t addr = fetch_byte();
-    A = fetch_byte(addr) + (fetch_byte(addr + 1) << 8);
-    update_flags(A);
-    cycles += 5;  // LDA (ZP) takes 5 cycles
-    if (debug) cout << "LDA ($" << hex << (int)addr << ")" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    regs.A = fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "LDA ($" << hex << (int)zp_addr << ")" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // LDX instructions implementation
+template <class Trace>
 void CPU65C02::LDX_IMM() {
-    X = fetch_byte();
-    update_flags(X);
-    if (debug) cout << "LDX #$" << hex << (int)X << endl;
-    print_registers();
+    regs.X = fetch_operand<Trace>();
+    update_flags(regs.X);
+    if constexpr (Trace::enabled) cout << "LDX #$" << hex << (int)regs.X << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDX_ZP() {
-    uint8_t addr = fetch_byte();
-    X = RAM[addr];
-    update_flags(X);
-    if (debug) cout << "LDX $" << hex << (int)addr << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>();
+    regs.X = fetch_byte(addr);
+    update_flags(regs.X);
+    if constexpr (Trace::enabled) cout << "LDX $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDX_ZP_Y() {
-    uint8_t zp_addr = fetch_byte() + Y;
-    X = fetch_byte(zp_addr);
-    update_flags(X);
-    if (debug) cout << "LDX $" << hex << (int)zp_addr << ",Y" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>() + regs.Y;
+    regs.X = fetch_byte(zp_addr);
+    update_flags(regs.X);
+    if constexpr (Trace::enabled) cout << "LDX $" << hex << (int)zp_addr << ",Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDX_ABS() {
-    uint16_t addr = fetch_word();
-    X = fetch_byte(addr);
-    update_flags(X);
-    if (debug)cout << "LDX $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    regs.X = fetch_byte(addr);
+    update_flags(regs.X);
+    if constexpr (Trace::enabled) cout << "LDX $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDX_ABS_Y() {
-    uint16_t addr = fetch_word();
-    X = fetch_byte(addr + Y);
-    update_flags(X);
-    if (debug) cout << "LDX $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    cycles += page_crossed(addr, addr + regs.Y);
+    regs.X = fetch_byte(addr + regs.Y);
+    update_flags(regs.X);
+    if constexpr (Trace::enabled) cout << "LDX $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // LDY instructions implementation
+template <class Trace>
 void CPU65C02::LDY_IMM() {
-    Y = fetch_byte();
-    update_flags(Y);
-    if (debug) cout << "LDY #$" << hex << (int)Y << endl;
-    print_registers();
+    regs.Y = fetch_operand<Trace>();
+    update_flags(regs.Y);
+    if constexpr (Trace::enabled) cout << "LDY #$" << hex << (int)regs.Y << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDY_ZP() {
-    uint8_t addr = fetch_byte();
-    Y = RAM[addr];
-    update_flags(Y);
-    if (debug) cout << "LDY $" << hex << (int)addr << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>();
+    regs.Y = fetch_byte(addr);
+    update_flags(regs.Y);
+    if constexpr (Trace::enabled) cout << "LDY $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDY_ZP_X() {
-    uint8_t zp_addr = fetch_byte() + X;
-    Y = fetch_byte(zp_addr);
-    update_flags(Y);
-    if (debug) cout << "LDY $" << hex << (int)zp_addr << ",X" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>() + regs.X;
+    regs.Y = fetch_byte(zp_addr);
+    update_flags(regs.Y);
+    if constexpr (Trace::enabled) cout << "LDY $" << hex << (int)zp_addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDY_ABS() {
-    uint16_t addr = fetch_word();
-    Y = fetch_byte(addr);
-    update_flags(Y);
-    if (debug) cout << "LDY $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    regs.Y = fetch_byte(addr);
+    update_flags(regs.Y);
+    if constexpr (Trace::enabled) cout << "LDY $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LDY_ABS_X() {
-    uint16_t addr = fetch_word();
-    Y = fetch_byte(addr + X);
-    update_flags(Y);
-    if (debug) cout << "LDY $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    cycles += page_crossed(addr, addr + regs.X);
+    regs.Y = fetch_byte(addr + regs.X);
+    update_flags(regs.Y);
+    if constexpr (Trace::enabled) cout << "LDY $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // STA instructions implementation
+template <class Trace>
 void CPU65C02::STA_ZP() {
     debug_print("Executing STA_ZP");
-    uint8_t addr = fetch_byte();
-    RAM[addr] = A;
-    cycles += 3;  // STA ZP takes 3 cycles
-    if (debug) cout << "STA $" << hex << (int)addr << endl;
+    uint8_t addr = fetch_operand<Trace>();
+    store_byte(addr, regs.A);
+    if constexpr (Trace::enabled) cout << "STA $" << hex << (int)addr << endl;
     debug_print("Stored value in memory");
 }
 
+template <class Trace>
 void CPU65C02::STA_ZP_X() {
-    uint16_t addr = (fetch_byte() + X) & 0xFF;
-    RAM[addr] = A;
-    cycles += 4;  // STA ZP,X takes 4 cycles
-    if (debug) cout << "STA $" << hex << (int)addr << ",X" << endl;
+    uint16_t addr = (fetch_operand<Trace>() + regs.X) & 0xFF;
+    store_byte(addr, regs.A);
+    if constexpr (Trace::enabled) cout << "STA $" << hex << (int)addr << ",X" << endl;
 }
 
+template <class Trace>
 void CPU65C02::STA_ABS() {
-    uint16_t addr = fetch_word();
-    RAM[addr] = A;
-    cycles += 4;  // STA ABS takes 4 cycles
-    if (debug) cout << "STA $" << hex << setw(4) << setfill('0') << addr << endl;
+    uint16_t addr = fetch_operand_word<Trace>();
+    store_byte(addr, regs.A);
+    if constexpr (Trace::enabled) cout << "STA $" << hex << setw(4) << setfill('0') << addr << endl;
 }
 
+template <class Trace>
 void CPU65C02::STA_ABS_X() {
-    uint16_t addr = fetch_word();
-    RAM[addr + X] = A;
-    cycles += 5;  // STA ABS,X takes 5 cycles
-    cout << "STA $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    uint16_t addr = fetch_operand_word<Trace>();
+    store_byte(addr + regs.X, regs.A);
+    if constexpr (Trace::enabled) cout << "STA $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
 }
 
+template <class Trace>
 void CPU65C02::STA_ABS_Y() {
-    uint16_t addr = fetch_word();
-    RAM[addr + Y] = A;
-    cycles += 5;  // STA ABS,Y takes 5 cycles
-    if (debug) cout << "STA $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
+    uint16_t addr = fetch_operand_word<Trace>();
+    store_byte(addr + regs.Y, regs.A);
+    if constexpr (Trace::enabled) cout << "STA $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
 }
 
+template <class Trace>
 void CPU65C02::STA_PRE_IND_X() {
-    uint8_t zp_addr = fetch_byte() + X;
-    uint16_t base = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    RAM[base] = A;
-    cycles += 6;  // STA (ZP,X) takes 6 cycles
-    if (debug) cout << "STA ($" << hex << (int)zp_addr << ",X)" << endl;
+    uint8_t zp_addr = fetch_operand<Trace>() + regs.X;
+    uint16_t base = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    store_byte(base, regs.A);
+    if constexpr (Trace::enabled) cout << "STA ($" << hex << (int)zp_addr << ",X)" << endl;
 }
 
+template <class Trace>
 void CPU65C02::STA_POST_IND_Y() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t base = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    RAM[base + Y] = A;
-    cycles += 6;  // STA (ZP),Y takes 6 cycles
-    if (debug) cout << "STA ($" << hex << (int)zp_addr << "),Y" << endl;
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t base = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    store_byte(base + regs.Y, regs.A);
+    if constexpr (Trace::enabled) cout << "STA ($" << hex << (int)zp_addr << "),Y" << endl;
 }
 
+template <class Trace>
 void CPU65C02::STA_IND() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t base = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    RAM[base] = A;
-    cycles += 5;  // STA (ZP) takes 5 cycles
-    if (debug) cout << "STA ($" << hex << (int)zp_addr << ")" << endl;
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t base = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    store_byte(base, regs.A);
+    if constexpr (Trace::enabled) cout << "STA ($" << hex << (int)zp_addr << ")" << endl;
 }
 
 // STX instructions implementation
+template <class Trace>
 void CPU65C02::STX_ZP() {
-    uint8_t addr = fetch_byte();
-    RAM[addr] = X;
-    if (debug) cout << "STX $" << hex << (int)addr << endl;
+    uint8_t addr = fetch_operand<Trace>();
+    store_byte(addr, regs.X);
+    if constexpr (Trace::enabled) cout << "STX $" << hex << (int)addr << endl;
 }
 
+template <class Trace>
 void CPU65C02::STX_ZP_Y() {
-    uint8_t zp_addr = fetch_byte() + Y;
-    RAM[zp_addr] = X;
-    if (debug) cout << "STX $" << hex << (int)zp_addr << ",Y" << endl;
+    uint8_t zp_addr = fetch_operand<Trace>() + regs.Y;
+    store_byte(zp_addr, regs.X);
+    if constexpr (Trace::enabled) cout << "STX $" << hex << (int)zp_addr << ",Y" << endl;
 }
 
+template <class Trace>
 void CPU65C02::STX_ABS() {
-    uint16_t addr = fetch_word();
-    RAM[addr] = X;
-    if (debug) cout << "STX $" << hex << setw(4) << setfill('0') << addr << endl;
+    uint16_t addr = fetch_operand_word<Trace>();
+    store_byte(addr, regs.X);
+    if constexpr (Trace::enabled) cout << "STX $" << hex << setw(4) << setfill('0') << addr << endl;
 }
 
 // STY instructions implementation
+template <class Trace>
 void CPU65C02::STY_ZP() {
-    uint8_t addr = fetch_byte();
-    RAM[addr] = Y;
-    if (debug) cout << "STY $" << hex << (int)addr << endl;
+    uint8_t addr = fetch_operand<Trace>();
+    store_byte(addr, regs.Y);
+    if constexpr (Trace::enabled) cout << "STY $" << hex << (int)addr << endl;
 }
 
+template <class Trace>
 void CPU65C02::STY_ZP_X() {
-    uint8_t zp_addr = fetch_byte() + X;
-    RAM[zp_addr] = Y;
-    if (debug) cout << "STY $" << hex << (int)zp_addr << ",X" << endl;
+    uint8_t zp_addr = fetch_operand<Trace>() + regs.X;
+    store_byte(zp_addr, regs.Y);
+    if constexpr (Trace::enabled) cout << "STY $" << hex << (int)zp_addr << ",X" << endl;
 }
 
+template <class Trace>
 void CPU65C02::STY_ABS() {
-    uint16_t addr = fetch_word();
-    RAM[addr] = Y;
-    if (debug) cout << "STY $" << hex << setw(4) << setfill('0') << addr << endl;
+    uint16_t addr = fetch_operand_word<Trace>();
+    store_byte(addr, regs.Y);
+    if constexpr (Trace::enabled) cout << "STY $" << hex << setw(4) << setfill('0') << addr << endl;
+}
+
+// Jumps and subroutines implementation
+template <class Trace>
+void CPU65C02::JMP_ABS() {
+    regs.PC = fetch_operand_word<Trace>();
+    if constexpr (Trace::enabled) cout << "JMP $" << hex << setw(4) << setfill('0') << regs.PC << endl;
+}
+
+// The 65C02 reads the pointer's high byte from the next address even across
+// a page boundary, unlike the NMOS 6502
+template <class Trace>
+void CPU65C02::JMP_ABS_IND() {
+    uint16_t addr = fetch_operand_word<Trace>();
+    regs.PC = fetch_byte(addr) | (fetch_byte(addr + 1) << 8);
+    if constexpr (Trace::enabled) cout << "JMP ($" << hex << setw(4) << setfill('0') << addr << ")" << endl;
+}
+
+template <class Trace>
+void CPU65C02::JMP_ABS_IND_X() {
+    uint16_t addr = fetch_operand_word<Trace>() + regs.X;
+    regs.PC = fetch_byte(addr) | (fetch_byte(addr + 1) << 8);
+    if constexpr (Trace::enabled) cout << "JMP ($" << hex << setw(4) << setfill('0') << (uint16_t)(addr - regs.X) << ",X)" << endl;
+}
+
+// JSR pushes the address of its own last byte; RTS pulls it and adds one
+template <class Trace>
+void CPU65C02::JSR_ABS() {
+    uint16_t target = fetch_operand_word<Trace>();
+    uint16_t return_addr = regs.PC - 1;
+    push(return_addr >> 8);
+    push(return_addr & 0xFF);
+    regs.PC = target;
+    if constexpr (Trace::enabled) cout << "JSR $" << hex << setw(4) << setfill('0') << regs.PC << endl;
+}
+
+template <class Trace>
+void CPU65C02::RTS() {
+    uint16_t low = pull();
+    uint16_t high = pull();
+    regs.PC = ((high << 8) | low) + 1;
+    if constexpr (Trace::enabled) cout << "RTS to $" << hex << setw(4) << setfill('0') << regs.PC << endl;
+}
+
+template <class Trace>
+void CPU65C02::RTI() {
+    regs.set_P(pull());
+    uint16_t low = pull();
+    uint16_t high = pull();
+    regs.PC = (high << 8) | low;
+    poll_interrupts();  // The pulled P may unmask a pending IRQ
+    if constexpr (Trace::enabled) cout << "RTI to $" << hex << setw(4) << setfill('0') << regs.PC << endl;
 }
 
 // Other instructions implementation
-void CPU65C02::JMP() {
-    PC = fetch_byte();
-    cycles += 3;  // JMP takes 3 cycles
-    if (debug) cout << "JMP $" << hex << (int)PC << endl;
+// Push PC and P and jump through vector, for IRQ, NMI and BRK. Like every
+// 65C02, and unlike the NMOS 6502, this clears D as well as setting I.
+template <class Trace>
+void CPU65C02::take_interrupt(uint16_t vector, uint8_t pushed_status) {
+    push(regs.PC >> 8);
+    push(regs.PC & 0xFF);
+    push(pushed_status);
+    regs.status = (regs.status | 0x04) & ~0x08;
+    regs.PC = fetch_byte(vector) | (fetch_byte(vector + 1) << 8);
+    cycles += 7;
+    if constexpr (Trace::enabled) cout << "Interrupt through $" << hex << vector << " to $" << regs.PC << endl;
+}
+
+// IRQ or NMI entry, between instructions. The instrumented core never sees
+// it, so it is handed to the recorder and profiler here.
+template <class Trace>
+void CPU65C02::enter_interrupt(uint16_t vector) {
+    if (recorder || profiler) {
+        Registers before = regs;
+        uint64_t start = cycles;
+        take_interrupt<Trace>(vector, (regs.P() | 0x20) & ~0x10);
+        record_interrupt(vector, before, cycles - start);
+    } else {
+        take_interrupt<Trace>(vector, (regs.P() | 0x20) & ~0x10);
+    }
+}
+
+void CPU65C02::record_interrupt(uint16_t vector, const Registers& before, unsigned entry_cycles) {
+    TraceRecord record;
+    record.pc = before.PC;
+    record.opcode = vector & 0xFF;
+    record.operand[0] = regs.PC & 0xFF;
+    record.operand[1] = regs.PC >> 8;
+    record.A = before.A;
+    record.X = before.X;
+    record.Y = before.Y;
+    record.S = before.S;
+    record.P = before.P();
+    record.cycles = entry_cycles;
+    record.kind = TRACE_INTERRUPT;
+    if (recorder) {
+        recorder->append(record);
+    }
+    if (profiler) {
+        profiler->interrupt(record.pc, regs.PC, record.cycles);
+    }
 }
 
+// The opcode map gives BRK no cycles, as by default it ends the program:
+// PC is left on the opcode and the run loop stops. As an interrupt it skips
+// its signature byte and pushes P with B set.
+template <class Trace>
 void CPU65C02::BRK() {
-    cycles += 7;  // BRK takes 7 cycles
-    if (debug) cout << "BRK" << endl;
+    if (brk_stops) {
+        regs.PC--;
+        request_stop(StopReason::Brk);
+    } else {
+        regs.PC++;
+        take_interrupt<Trace>(0xFFFE, regs.P() | 0x30);
+    }
+    if constexpr (Trace::enabled) cout << "BRK" << endl;
+}
+
+// Only a reset restarts the CPU from STP, so it ends the run the way BRK
+// does
+template <class Trace>
+void CPU65C02::STP() {
+    regs.PC--;
+    request_stop(StopReason::Halt);
+    if constexpr (Trace::enabled) cout << "STP" << endl;
 }
 
+// run() does the waiting, ending the run with StopReason::Wait until an
+// interrupt is raised
+template <class Trace>
+void CPU65C02::WAI() {
+    waiting = true;
+    deadline = 0;
+    if constexpr (Trace::enabled) cout << "WAI" << endl;
+}
+
+template <class Trace>
 void CPU65C02::NOP() {
-    cycles += 2;  // NOP takes 2 cycles
-    if (debug) cout << "NOP" << endl;
+    if constexpr (Trace::enabled) cout << "NOP" << endl;
 }
 
-void CPU65C02::RTI() {
-    cycles += 6;  // RTI takes 6 cycles
-    if (debug) cout << "RTI" << endl;
-    PC = 0;
+template <class Trace>
+void CPU65C02::NOP_IMM() {
+    fetch_operand<Trace>();
+    if constexpr (Trace::enabled) cout << "NOP #" << endl;
+}
+
+template <class Trace>
+void CPU65C02::NOP_ZP() {
+    fetch_operand<Trace>();
+    if constexpr (Trace::enabled) cout << "NOP zp" << endl;
+}
+
+template <class Trace>
+void CPU65C02::NOP_ZP_X() {
+    fetch_operand<Trace>();
+    if constexpr (Trace::enabled) cout << "NOP zp,X" << endl;
+}
+
+template <class Trace>
+void CPU65C02::NOP_ABS() {
+    fetch_operand_word<Trace>();
+    if constexpr (Trace::enabled) cout << "NOP abs" << endl;
+}
+
+// Decimal-mode ADC and SBC results for every carry in, accumulator and
+// operand, as the 65C02 computes them (including for invalid BCD digits).
+// Each entry is the result in bits 0-7, C in bit 8 and V in bit 15.
+namespace {
+
+struct BcdTables {
+    uint16_t add[2][256][256];
+    uint16_t sub[2][256][256];
+
+    BcdTables() {
+        for (int c = 0; c < 2; c++) {
+            for (int a = 0; a < 256; a++) {
+                for (int m = 0; m < 256; m++) {
+                    add[c][a][m] = decimal_add(a, m, c);
+                    sub[c][a][m] = decimal_subtract(a, m, c);
+                }
+            }
+        }
+    }
+
+    // V comes from the signed sum of the high nibbles plus the adjusted low
+    // digit, before the high digit is adjusted; C from the adjusted sum
+    static uint16_t decimal_add(int a, int m, int c) {
+        int low = (a & 0x0F) + (m & 0x0F) + c;
+        if (low >= 0x0A) {
+            low = ((low + 0x06) & 0x0F) + 0x10;
+        }
+        int sum = (a & 0xF0) + (m & 0xF0) + low;
+        int signed_sum = (int8_t)(a & 0xF0) + (int8_t)(m & 0xF0) + low;
+        bool overflow = signed_sum < -128 || signed_sum > 127;
+        if (sum >= 0xA0) {
+            sum += 0x60;
+        }
+        return (sum & 0xFF) | (sum >= 0x100 ? 0x100 : 0) | (overflow ? 0x8000 : 0);
+    }
+
+    // C and V are those of the binary subtraction
+    static uint16_t decimal_subtract(int a, int m, int c) {
+        int low = (a & 0x0F) - (m & 0x0F) + c - 1;
+        int difference = a - m + c - 1;
+        bool overflow = ((a ^ m) & (a ^ difference) & 0x80) != 0;
+        bool carry = difference >= 0;
+        if (difference < 0) {
+            difference -= 0x60;
+        }
+        if (low < 0) {
+            difference -= 0x06;
+        }
+        return (difference & 0xFF) | (carry ? 0x100 : 0) | (overflow ? 0x8000 : 0);
+    }
+};
+
+const BcdTables bcd_tables;
+
+} // namespace
+
+// Shared by every ADC and SBC. In binary mode V is set when both inputs
+// have the same sign and the result has the other one; SBC adds the
+// operand's complement. Decimal mode looks the result up and, as on the
+// 65C02, sets N and Z from it and takes one extra cycle.
+void CPU65C02::add_with_carry(uint8_t operand) {
+    if (regs.status & 0x08) {
+        uint16_t entry = bcd_tables.add[regs.flag_c][regs.A][operand];
+        regs.A = entry;
+        regs.flag_c = (entry >> 8) & 1;
+        regs.flag_v = (entry >> 8) & 0x80;
+        cycles++;
+    } else {
+        unsigned sum = regs.A + operand + regs.flag_c;
+        regs.flag_v = (regs.A ^ sum) & (operand ^ sum);
+        regs.flag_c = sum >> 8;
+        regs.A = sum;
+    }
+    update_flags(regs.A);
+}
+
+void CPU65C02::subtract_with_borrow(uint8_t operand) {
+    if (regs.status & 0x08) {
+        uint16_t entry = bcd_tables.sub[regs.flag_c][regs.A][operand];
+        regs.A = entry;
+        regs.flag_c = (entry >> 8) & 1;
+        regs.flag_v = (entry >> 8) & 0x80;
+        cycles++;
+    } else {
+        uint8_t complement = ~operand;
+        unsigned sum = regs.A + complement + regs.flag_c;
+        regs.flag_v = (regs.A ^ sum) & (complement ^ sum);
+        regs.flag_c = sum >> 8;
+        regs.A = sum;
+    }
+    update_flags(regs.A);
 }
 
 // ADC implementations
+template <class Trace>
 void CPU65C02::ADC_IMM() {
     debug_print("Executing ADC_IMM");
-    uint8_t operand = fetch_byte();
-    uint16_t result = A + operand + (status & 0x01); // Add with carry
-    status = (status & ~0x01) | (result > 0xFF); // Set carry if result > 255
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 2;  // ADC IMM takes 2 cycles
-    if (debug) cout << "ADC #$" << hex << (int)operand << endl;
-    print_registers();
+    uint8_t operand = fetch_operand<Trace>();
+    add_with_carry(operand);
+    if constexpr (Trace::enabled) cout << "ADC #$" << hex << (int)operand << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ADC_ZP() {
-    uint8_t addr = fetch_byte();
-    uint8_t operand = RAM[addr];
-    uint16_t result = A + operand + (status & 0x01);
-    status = (status & ~0x01) | (result > 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 3;  // ADC ZP takes 3 cycles
-    if (debug) cout << "ADC $" << hex << (int)addr << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    add_with_carry(operand);
+    if constexpr (Trace::enabled) cout << "ADC $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ADC_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    uint8_t operand = RAM[addr];
-    uint16_t result = A + operand + (status & 0x01);
-    status = (status & ~0x01) | (result > 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 4;  // ADC ZP,X takes 4 cycles
-    if (debug) cout << "ADC $" << hex << (int)addr << ",X" << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    uint8_t operand = fetch_byte(addr);
+    add_with_carry(operand);
+    if constexpr (Trace::enabled) cout << "ADC $" << hex << (int)addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ADC_ABS() {
-    uint16_t addr = fetch_word();
-    uint8_t operand = RAM[addr];
-    uint16_t result = A + operand + (status & 0x01);
-    status = (status & ~0x01) | (result > 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 4;  // ADC ABS takes 4 cycles
-    if (debug) cout << "ADC $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    add_with_carry(operand);
+    if constexpr (Trace::enabled) cout << "ADC $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ADC_ABS_X() {
-    uint16_t addr = fetch_word() + X;
-    uint8_t operand = RAM[addr];
-    uint16_t result = A + operand + (status & 0x01);
-    status = (status & ~0x01) | (result > 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 4;  // ADC ABS,X takes 4 cycles (5 if page boundary crossed)
-    if (debug) cout << "ADC $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.X;
+    cycles += page_crossed(base, addr);
+    uint8_t operand = fetch_byte(addr);
+    add_with_carry(operand);
+    if constexpr (Trace::enabled) cout << "ADC $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ADC_ABS_Y() {
-    uint16_t addr = fetch_word() + Y;
-    uint8_t operand = RAM[addr];
-    uint16_t result = A + operand + (status & 0x01);
-    status = (status & ~0x01) | (result > 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 4;  // ADC ABS,Y takes 4 cycles (5 if page boundary crossed)
-    if (debug) cout << "ADC $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.Y;
+    cycles += page_crossed(base, addr);
+    uint8_t operand = fetch_byte(addr);
+    add_with_carry(operand);
+    if constexpr (Trace::enabled) cout << "ADC $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ADC_PRE_IND_X() {
-    uint8_t zp_addr = fetch_byte() + X;
-    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    uint8_t operand = RAM[addr];
-    uint16_t result = A + operand + (status & 0x01);
-    status = (status & ~0x01) | (result > 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    if (debug) cout << "ADC ($" << hex << (int)zp_addr << ",X)" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>() + regs.X;
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    uint8_t operand = fetch_byte(addr);
+    add_with_carry(operand);
+    if constexpr (Trace::enabled) cout << "ADC ($" << hex << (int)zp_addr << ",X)" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ADC_POST_IND_Y() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t base = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    uint8_t operand = RAM[base + Y];
-    uint16_t result = A + operand + (status & 0x01);
-    status = (status & ~0x01) | (result > 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    if (debug) cout << "ADC ($" << hex << (int)zp_addr << "),Y" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t base = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    cycles += page_crossed(base, base + regs.Y);
+    uint8_t operand = fetch_byte(base + regs.Y);
+    add_with_carry(operand);
+    if constexpr (Trace::enabled) cout << "ADC ($" << hex << (int)zp_addr << "),Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ADC_IND() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    uint8_t operand = RAM[addr];
-    uint16_t result = A + operand + (status & 0x01);
-    status = (status & ~0x01) | (result > 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    if (debug) cout << "ADC ($" << hex << (int)zp_addr << ")" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    uint8_t operand = fetch_byte(addr);
+    add_with_carry(operand);
+    if constexpr (Trace::enabled) cout << "ADC ($" << hex << (int)zp_addr << ")" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // SBC implementations
+template <class Trace>
 void CPU65C02::SBC_IMM() {
     debug_print("Executing SBC_IMM");
-    uint8_t operand = fetch_byte();
-    uint16_t result = A - operand - !(status & 0x01); // Subtract with borrow
-    status = (status & ~0x01) | (result <= 0xFF); // Set carry if result >= 0
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 2;  // SBC IMM takes 2 cycles
-    if (debug) cout << "SBC #$" << hex << (int)operand << endl;
-    print_registers();
+    uint8_t operand = fetch_operand<Trace>();
+    subtract_with_borrow(operand);
+    if constexpr (Trace::enabled) cout << "SBC #$" << hex << (int)operand << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::SBC_ZP() {
-    uint8_t addr = fetch_byte();
-    uint8_t operand = RAM[addr];
-    uint16_t result = A - operand - !(status & 0x01);
-    status = (status & ~0x01) | (result <= 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 3;  // SBC ZP takes 3 cycles
-    if (debug) cout << "SBC $" << hex << (int)addr << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    subtract_with_borrow(operand);
+    if constexpr (Trace::enabled) cout << "SBC $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::SBC_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    uint8_t operand = RAM[addr];
-    uint16_t result = A - operand - !(status & 0x01);
-    status = (status & ~0x01) | (result <= 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 4;  // SBC ZP,X takes 4 cycles
-    if (debug) cout << "SBC $" << hex << (int)addr << ",X" << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    uint8_t operand = fetch_byte(addr);
+    subtract_with_borrow(operand);
+    if constexpr (Trace::enabled) cout << "SBC $" << hex << (int)addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::SBC_ABS() {
-    uint16_t addr = fetch_word();
-    uint8_t operand = RAM[addr];
-    uint16_t result = A - operand - !(status & 0x01);
-    status = (status & ~0x01) | (result <= 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 4;  // SBC ABS takes 4 cycles
-    if (debug) cout << "SBC $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    subtract_with_borrow(operand);
+    if constexpr (Trace::enabled) cout << "SBC $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::SBC_ABS_X() {
-    uint16_t addr = fetch_word() + X;
-    uint8_t operand = RAM[addr];
-    uint16_t result = A - operand - !(status & 0x01);
-    status = (status & ~0x01) | (result <= 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 4;  // SBC ABS,X takes 4 cycles (5 if page boundary crossed)
-    if (debug) cout << "SBC $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.X;
+    cycles += page_crossed(base, addr);
+    uint8_t operand = fetch_byte(addr);
+    subtract_with_borrow(operand);
+    if constexpr (Trace::enabled) cout << "SBC $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::SBC_ABS_Y() {
-    uint16_t addr = fetch_word() + Y;
-    uint8_t operand = RAM[addr];
-    uint16_t result = A - operand - !(status & 0x01);
-    status = (status & ~0x01) | (result <= 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 4;  // SBC ABS,Y takes 4 cycles (5 if page boundary crossed)
-    if (debug)cout << "SBC $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.Y;
+    cycles += page_crossed(base, addr);
+    uint8_t operand = fetch_byte(addr);
+    subtract_with_borrow(operand);
+    if constexpr (Trace::enabled) cout << "SBC $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::SBC_PRE_IND_X() {
-    uint8_t zp_addr = fetch_byte() + X;
-    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    uint8_t operand = RAM[addr];
-    uint16_t result = A - operand - !(status & 0x01);
-    status = (status & ~0x01) | (result <= 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 6;  // SBC (ZP,X) takes 6 cycles
-    if (debug) cout << "SBC ($" << hex << (int)zp_addr << ",X)" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>() + regs.X;
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    uint8_t operand = fetch_byte(addr);
+    subtract_with_borrow(operand);
+    if constexpr (Trace::enabled) cout << "SBC ($" << hex << (int)zp_addr << ",X)" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::SBC_POST_IND_Y() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t base = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    uint8_t operand = RAM[base + Y];
-    uint16_t result = A - operand - !(status & 0x01);
-    status = (status & ~0x01) | (result <= 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 5;  // SBC (ZP),Y takes 5 cycles (6 if page boundary crossed)
-    if (debug) cout << "SBC ($" << hex << (int)zp_addr << "),Y" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t base = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    cycles += page_crossed(base, base + regs.Y);
+    uint8_t operand = fetch_byte(base + regs.Y);
+    subtract_with_borrow(operand);
+    if constexpr (Trace::enabled) cout << "SBC ($" << hex << (int)zp_addr << "),Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::SBC_IND() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    uint8_t operand = RAM[addr];
-    uint16_t result = A - operand - !(status & 0x01);
-    status = (status & ~0x01) | (result <= 0xFF);
-    A = result & 0xFF;
-    update_flags(A);
-    cycles += 5;  // SBC (ZP) takes 5 cycles
-    if (debug) cout << "SBC ($" << hex << (int)zp_addr << ")" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    uint8_t operand = fetch_byte(addr);
+    subtract_with_borrow(operand);
+    if constexpr (Trace::enabled) cout << "SBC ($" << hex << (int)zp_addr << ")" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // INC implementations
+template <class Trace>
 void CPU65C02::INC_ZP() {
-    uint8_t addr = fetch_byte();
-    RAM[addr]++;
-    update_flags(RAM[addr]);
-    cycles += 5;  // INC ZP takes 5 cycles
-    if (debug) cout << "INC $" << hex << (int)addr << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t value = fetch_byte(addr) + 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "INC $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::INC_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    RAM[addr]++;
-    update_flags(RAM[addr]);
-    cycles += 6;  // INC ZP,X takes 6 cycles
-    if (debug) cout << "INC $" << hex << (int)addr << ",X" << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    uint8_t value = fetch_byte(addr) + 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "INC $" << hex << (int)addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::INC_ABS() {
-    uint16_t addr = fetch_word();
-    RAM[addr]++;
-    update_flags(RAM[addr]);
-    cycles += 6;  // INC ABS takes 6 cycles
-    if (debug) cout << "INC $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    uint8_t value = fetch_byte(addr) + 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "INC $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::INC_ABS_X() {
-    uint16_t addr = fetch_word() + X;
-    RAM[addr]++;
-    update_flags(RAM[addr]);
-    cycles += 7;  // INC ABS,X takes 7 cycles
-    if (debug) cout << "INC $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>() + regs.X;
+    uint8_t value = fetch_byte(addr) + 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "INC $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::INX() {
-    X++;
-    update_flags(X);
-    cycles += 2;  // INX takes 2 cycles
-    if (debug) cout << "INX" << endl;
-    print_registers();
+    regs.X++;
+    update_flags(regs.X);
+    if constexpr (Trace::enabled) cout << "INX" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::INY() {
-    Y++;
-    update_flags(Y);
-    cycles += 2;  // INY takes 2 cycles
-    if (debug) cout << "INY" << endl;
-    print_registers();
+    regs.Y++;
+    update_flags(regs.Y);
+    if constexpr (Trace::enabled) cout << "INY" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // DEC implementations
+template <class Trace>
 void CPU65C02::DEC_ZP() {
-    uint8_t addr = fetch_byte();
-    RAM[addr]--;
-    update_flags(RAM[addr]);
-    cycles += 5;  // DEC ZP takes 5 cycles
-    if (debug) cout << "DEC $" << hex << (int)addr << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t value = fetch_byte(addr) - 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "DEC $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::DEC_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    RAM[addr]--;
-    update_flags(RAM[addr]);
-    cycles += 6;  // DEC ZP,X takes 6 cycles
-    if (debug) cout << "DEC $" << hex << (int)addr << ",X" << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    uint8_t value = fetch_byte(addr) - 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "DEC $" << hex << (int)addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::DEC_ABS() {
-    uint16_t addr = fetch_word();
-    RAM[addr]--;
-    update_flags(RAM[addr]);
-    cycles += 6;  // DEC ABS takes 6 cycles
-    if (debug) cout << "DEC $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    uint8_t value = fetch_byte(addr) - 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "DEC $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::DEC_ABS_X() {
-    uint16_t addr = fetch_word() + X;
-    RAM[addr]--;
-    update_flags(RAM[addr]);
-    cycles += 7;  // DEC ABS,X takes 7 cycles
-    if (debug) cout << "DEC $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>() + regs.X;
+    uint8_t value = fetch_byte(addr) - 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "DEC $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::DEX() {
-    X--;
-    update_flags(X);
-    cycles += 2;  // DEX takes 2 cycles
-    if (debug) cout << "DEX" << endl;
-    print_registers();
+    regs.X--;
+    update_flags(regs.X);
+    if constexpr (Trace::enabled) cout << "DEX" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::DEY() {
-    Y--;
-    update_flags(Y);
-    cycles += 2;  // DEY takes 2 cycles
-    if (debug) cout << "DEY" << endl;
-    print_registers();
+    regs.Y--;
+    update_flags(regs.Y);
+    if constexpr (Trace::enabled) cout << "DEY" << endl;
+    if constexpr (Trace::enabled) print_registers();
+}
+
+template <class Trace>
+void CPU65C02::INC_ACC() {
+    regs.A++;
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "INC A" << endl;
+    if constexpr (Trace::enabled) print_registers();
+}
+
+template <class Trace>
+void CPU65C02::DEC_ACC() {
+    regs.A--;
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "DEC A" << endl;
+    if constexpr (Trace::enabled) print_registers();
+}
+
+// BIT implementations. BIT #imm only changes Z.
+template <class Trace>
+void CPU65C02::BIT_IMM() {
+    uint8_t operand = fetch_operand<Trace>();
+    regs.flag_z = regs.A & operand;
+    if constexpr (Trace::enabled) cout << "BIT #$" << hex << (int)operand << endl;
+}
+
+template <class Trace>
+void CPU65C02::BIT_ZP() {
+    uint8_t addr = fetch_operand<Trace>();
+    bit_test(fetch_byte(addr));
+    if constexpr (Trace::enabled) cout << "BIT $" << hex << (int)addr << endl;
+}
+
+template <class Trace>
+void CPU65C02::BIT_ZP_X() {
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    bit_test(fetch_byte(addr));
+    if constexpr (Trace::enabled) cout << "BIT $" << hex << (int)addr << ",X" << endl;
+}
+
+template <class Trace>
+void CPU65C02::BIT_ABS() {
+    uint16_t addr = fetch_operand_word<Trace>();
+    bit_test(fetch_byte(addr));
+    if constexpr (Trace::enabled) cout << "BIT $" << hex << setw(4) << setfill('0') << addr << endl;
+}
+
+template <class Trace>
+void CPU65C02::BIT_ABS_X() {
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.X;
+    cycles += page_crossed(base, addr);
+    bit_test(fetch_byte(addr));
+    if constexpr (Trace::enabled) cout << "BIT $" << hex << setw(4) << setfill('0') << base << ",X" << endl;
+}
+
+// Register transfers implementation
+template <class Trace>
+void CPU65C02::TAX() {
+    regs.X = regs.A;
+    update_flags(regs.X);
+    if constexpr (Trace::enabled) cout << "TAX" << endl;
+    if constexpr (Trace::enabled) print_registers();
+}
+
+template <class Trace>
+void CPU65C02::TAY() {
+    regs.Y = regs.A;
+    update_flags(regs.Y);
+    if constexpr (Trace::enabled) cout << "TAY" << endl;
+    if constexpr (Trace::enabled) print_registers();
+}
+
+template <class Trace>
+void CPU65C02::TXA() {
+    regs.A = regs.X;
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "TXA" << endl;
+    if constexpr (Trace::enabled) print_registers();
+}
+
+template <class Trace>
+void CPU65C02::TYA() {
+    regs.A = regs.Y;
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "TYA" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // AND implementations
+template <class Trace>
 void CPU65C02::AND_IMM() {
-    uint8_t operand = fetch_byte();
-    A &= operand;
-    update_flags(A);
-    cycles += 2;  // AND IMM takes 2 cycles
-    if (debug) cout << "AND #$" << hex << (int)operand << endl;
-    print_registers();
+    uint8_t operand = fetch_operand<Trace>();
+    regs.A &= operand;
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "AND #$" << hex << (int)operand << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::AND_ZP() {
-    uint8_t addr = fetch_byte();
-    A &= RAM[addr];
-    update_flags(A);
-    cycles += 3;  // AND ZP takes 3 cycles
-    if (debug) cout << "AND $" << hex << (int)addr << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>();
+    regs.A &= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "AND $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::AND_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    A &= RAM[addr];
-    update_flags(A);
-    cycles += 4;  // AND ZP,X takes 4 cycles
-    if (debug) cout << "AND $" << hex << (int)addr << ",X" << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    regs.A &= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "AND $" << hex << (int)addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::AND_ABS() {
-    uint16_t addr = fetch_word();
-    A &= RAM[addr];
-    update_flags(A);
-    cycles += 4;  // AND ABS takes 4 cycles
-    if (debug) cout << "AND $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    regs.A &= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "AND $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::AND_ABS_X() {
-    uint16_t addr = fetch_word() + X;
-    A &= RAM[addr];
-    update_flags(A);
-    cycles += 4;  // AND ABS,X takes 4 cycles (5 if page boundary crossed)
-    if (debug) cout << "AND $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.X;
+    cycles += page_crossed(base, addr);
+    regs.A &= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "AND $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::AND_ABS_Y() {
-    uint16_t addr = fetch_word() + Y;
-    A &= RAM[addr];
-    update_flags(A);
-    cycles += 4;  // AND ABS,Y takes 4 cycles (5 if page boundary crossed)
-    if (debug) cout << "AND $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.Y;
+    cycles += page_crossed(base, addr);
+    regs.A &= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "AND $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::AND_PRE_IND_X() {
-    uint8_t zp_addr = fetch_byte() + X;
-    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    A &= RAM[addr];
-    update_flags(A);
-    cycles += 6;  // AND (ZP,X) takes 6 cycles
-    if (debug) cout << "AND ($" << hex << (int)zp_addr << ",X)" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>() + regs.X;
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    regs.A &= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "AND ($" << hex << (int)zp_addr << ",X)" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::AND_POST_IND_Y() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t base = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    A &= RAM[base + Y];
-    update_flags(A);
-    cycles += 5;  // AND (ZP),Y takes 5 cycles (6 if page boundary crossed)
-    if (debug) cout << "AND ($" << hex << (int)zp_addr << "),Y" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t base = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    cycles += page_crossed(base, base + regs.Y);
+    regs.A &= fetch_byte(base + regs.Y);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "AND ($" << hex << (int)zp_addr << "),Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::AND_IND() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    A &= RAM[addr];
-    update_flags(A);
-    cycles += 5;  // AND (ZP) takes 5 cycles
-    if (debug) cout << "AND ($" << hex << (int)zp_addr << ")" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    regs.A &= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "AND ($" << hex << (int)zp_addr << ")" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // ORA implementations
+template <class Trace>
 void CPU65C02::ORA_IMM() {
-    uint8_t operand = fetch_byte();
-    A |= operand;
-    update_flags(A);
-    cycles += 2;  // ORA IMM takes 2 cycles
-    if (debug)cout << "ORA #$" << hex << (int)operand << endl;
-    print_registers();
+    uint8_t operand = fetch_operand<Trace>();
+    regs.A |= operand;
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "ORA #$" << hex << (int)operand << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ORA_ZP() {
-    uint8_t addr = fetch_byte();
-    A |= RAM[addr];
-    update_flags(A);
-    cycles += 3;  // ORA ZP takes 3 cycles
-    if (debug) cout << "ORA $" << hex << (int)addr << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>();
+    regs.A |= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "ORA $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ORA_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    A |= RAM[addr];
-    update_flags(A);
-    cycles += 4;  // ORA ZP,X takes 4 cycles
-    if (debug) cout << "ORA $" << hex << (int)addr << ",X" << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    regs.A |= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "ORA $" << hex << (int)addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ORA_ABS() {
-    uint16_t addr = fetch_word();
-    A |= RAM[addr];
-    update_flags(A);
-    cycles += 4;  // ORA ABS takes 4 cycles
-    if (debug) cout << "ORA $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    regs.A |= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "ORA $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ORA_ABS_X() {
-    uint16_t addr = fetch_word() + X;
-    A |= RAM[addr];
-    update_flags(A);
-    cycles += 4;  // ORA ABS,X takes 4 cycles (5 if page boundary crossed)
-    if (debug) cout << "ORA $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.X;
+    cycles += page_crossed(base, addr);
+    regs.A |= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "ORA $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ORA_ABS_Y() {
-    uint16_t addr = fetch_word() + Y;
-    A |= RAM[addr];
-    update_flags(A);
-    cycles += 4;  // ORA ABS,Y takes 4 cycles (5 if page boundary crossed)
-    if (debug) cout << "ORA $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.Y;
+    cycles += page_crossed(base, addr);
+    regs.A |= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "ORA $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ORA_PRE_IND_X() {
-    uint8_t zp_addr = fetch_byte() + X;
-    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    A |= RAM[addr];
-    update_flags(A);
-    cycles += 6;  // ORA (ZP,X) takes 6 cycles
-    if (debug) cout << "ORA ($" << hex << (int)zp_addr << ",X)" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>() + regs.X;
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    regs.A |= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "ORA ($" << hex << (int)zp_addr << ",X)" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ORA_POST_IND_Y() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t base = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    A |= RAM[base + Y];
-    update_flags(A);
-    cycles += 5;  // ORA (ZP),Y takes 5 cycles (6 if page boundary crossed)
-    if (debug) cout << "ORA ($" << hex << (int)zp_addr << "),Y" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t base = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    cycles += page_crossed(base, base + regs.Y);
+    regs.A |= fetch_byte(base + regs.Y);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "ORA ($" << hex << (int)zp_addr << "),Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ORA_IND() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    A |= RAM[addr];
-    update_flags(A);
-    cycles += 5;  // ORA (ZP) takes 5 cycles
-    if (debug) cout << "ORA ($" << hex << (int)zp_addr << ")" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    regs.A |= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "ORA ($" << hex << (int)zp_addr << ")" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // EOR implementations
+template <class Trace>
 void CPU65C02::EOR_IMM() {
-    uint8_t operand = fetch_byte();
-    A ^= operand;
-    update_flags(A);
-    cycles += 2;  // EOR IMM takes 2 cycles
-    if (debug) cout << "EOR #$" << hex << (int)operand << endl;
-    print_registers();
+    uint8_t operand = fetch_operand<Trace>();
+    regs.A ^= operand;
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "EOR #$" << hex << (int)operand << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::EOR_ZP() {
-    uint8_t addr = fetch_byte();
-    A ^= RAM[addr];
-    update_flags(A);
-    cycles += 3;  // EOR ZP takes 3 cycles
-    if (debug) cout << "EOR $" << hex << (int)addr << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>();
+    regs.A ^= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "EOR $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::EOR_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    A ^= RAM[addr];
-    update_flags(A);
-    cycles += 4;  // EOR ZP,X takes 4 cycles
-    if (debug) cout << "EOR $" << hex << (int)addr << ",X" << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    regs.A ^= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "EOR $" << hex << (int)addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::EOR_ABS() {
-    uint16_t addr = fetch_word();
-    A ^= RAM[addr];
-    update_flags(A);
-    cycles += 4;  // EOR ABS takes 4 cycles
-    if (debug) cout << "EOR $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    regs.A ^= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "EOR $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::EOR_ABS_X() {
-    uint16_t addr = fetch_word() + X;
-    A ^= RAM[addr];
-    update_flags(A);
-    cycles += 4;  // EOR ABS,X takes 4 cycles (5 if page boundary crossed)
-    if (debug) cout << "EOR $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.X;
+    cycles += page_crossed(base, addr);
+    regs.A ^= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "EOR $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::EOR_ABS_Y() {
-    uint16_t addr = fetch_word() + Y;
-    A ^= RAM[addr];
-    update_flags(A);
-    cycles += 4;  // EOR ABS,Y takes 4 cycles (5 if page boundary crossed)
-    if (debug) cout << "EOR $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.Y;
+    cycles += page_crossed(base, addr);
+    regs.A ^= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "EOR $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::EOR_PRE_IND_X() {
-    uint8_t zp_addr = fetch_byte() + X;
-    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    A ^= RAM[addr];
-    update_flags(A);
-    cycles += 6;  // EOR (ZP,X) takes 6 cycles
-    if (debug) cout << "EOR ($" << hex << (int)zp_addr << ",X)" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>() + regs.X;
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    regs.A ^= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "EOR ($" << hex << (int)zp_addr << ",X)" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::EOR_POST_IND_Y() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t base = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    A ^= RAM[base + Y];
-    update_flags(A);
-    cycles += 5;  // EOR (ZP),Y takes 5 cycles (6 if page boundary crossed)
-    if (debug) cout << "EOR ($" << hex << (int)zp_addr << "),Y" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t base = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    cycles += page_crossed(base, base + regs.Y);
+    regs.A ^= fetch_byte(base + regs.Y);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "EOR ($" << hex << (int)zp_addr << "),Y" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::EOR_IND() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    A ^= RAM[addr];
-    update_flags(A);
-    cycles += 5;  // EOR (ZP) takes 5 cycles
-    if (debug) cout << "EOR ($" << hex << (int)zp_addr << ")" << endl;
-    print_registers();
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    regs.A ^= fetch_byte(addr);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "EOR ($" << hex << (int)zp_addr << ")" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // ASL implementations
+template <class Trace>
 void CPU65C02::ASL_ACC() {
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (A & 0x80) >> 7;
-    A = (A << 1) | old_carry;
-    update_flags(A);
-    cycles += 2;  // ASL A takes 2 cycles
-    if (debug) cout << "ASL A" << endl;
-    print_registers();
+    regs.flag_c = (regs.A & 0x80) >> 7;
+    regs.A = regs.A << 1;
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "ASL A" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ASL_ZP() {
-    uint8_t addr = fetch_byte();
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x80) >> 7;
-    RAM[addr] = (RAM[addr] << 1) | old_carry;
-    update_flags(RAM[addr]);
-    if (debug) cout << "ASL $" << hex << (int)addr << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t value = fetch_byte(addr);
+    regs.flag_c = (value & 0x80) >> 7;
+    value = value << 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "ASL $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ASL_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x80) >> 7;
-    RAM[addr] = (RAM[addr] << 1) | old_carry;
-    update_flags(RAM[addr]);
-    if (debug) cout << "ASL $" << hex << (int)addr << ",X" << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    uint8_t value = fetch_byte(addr);
+    regs.flag_c = (value & 0x80) >> 7;
+    value = value << 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "ASL $" << hex << (int)addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ASL_ABS() {
-    uint16_t addr = fetch_word();
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x80) >> 7;
-    RAM[addr] = (RAM[addr] << 1) | old_carry;
-    update_flags(RAM[addr]);
-    if (debug) cout << "ASL $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    uint8_t value = fetch_byte(addr);
+    regs.flag_c = (value & 0x80) >> 7;
+    value = value << 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "ASL $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ASL_ABS_X() {
-    uint16_t addr = fetch_word() + X;
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x80) >> 7;
-    RAM[addr] = (RAM[addr] << 1) | old_carry;
-    update_flags(RAM[addr]);
-    if (debug) cout << "ASL $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.X;
+    cycles += page_crossed(base, addr);
+    uint8_t value = fetch_byte(addr);
+    regs.flag_c = (value & 0x80) >> 7;
+    value = value << 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "ASL $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // LSR series
+template <class Trace>
 void CPU65C02::LSR_ACC() {
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (A & 0x01);
-    A = (A >> 1) | (old_carry << 7);
-    update_flags(A);
-    cycles += 2;  // LSR A takes 2 cycles
-    if (debug) cout << "LSR A" << endl;
-    print_registers();
+    regs.flag_c = regs.A & 0x01;
+    regs.A = regs.A >> 1;
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "LSR A" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LSR_ZP() {
-    uint8_t addr = fetch_byte();
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x01);
-    RAM[addr] = (RAM[addr] >> 1) | (old_carry << 7);
-    update_flags(RAM[addr]);
-    cycles += 5;  // LSR ZP takes 5 cycles
-    if (debug) cout << "LSR $" << hex << (int)addr << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t value = fetch_byte(addr);
+    regs.flag_c = value & 0x01;
+    value = value >> 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "LSR $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LSR_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x01);
-    RAM[addr] = (RAM[addr] >> 1) | (old_carry << 7);
-    update_flags(RAM[addr]);
-    cycles += 6;  // LSR ZP,X takes 6 cycles
-    if (debug) cout << "LSR $" << hex << (int)addr << ",X" << endl;
-    print_registers();
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    uint8_t value = fetch_byte(addr);
+    regs.flag_c = value & 0x01;
+    value = value >> 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "LSR $" << hex << (int)addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LSR_ABS() {
-    uint16_t addr = fetch_word();
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x01);
-    RAM[addr] = (RAM[addr] >> 1) | (old_carry << 7);
-    update_flags(RAM[addr]);
-    cycles += 6;  // LSR ABS takes 6 cycles
-    if (debug) cout << "LSR $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
+    uint16_t addr = fetch_operand_word<Trace>();
+    uint8_t value = fetch_byte(addr);
+    regs.flag_c = value & 0x01;
+    value = value >> 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "LSR $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::LSR_ABS_X() {
-    uint16_t addr = fetch_word() + X;
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x01);
-    RAM[addr] = (RAM[addr] >> 1) | (old_carry << 7);
-    update_flags(RAM[addr]);
-    cycles += 7;  // LSR ABS,X takes 7 cycles
-    if (debug) cout << "LSR $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.X;
+    cycles += page_crossed(base, addr);
+    uint8_t value = fetch_byte(addr);
+    regs.flag_c = value & 0x01;
+    value = value >> 1;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "LSR $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // ROL series
+template <class Trace>
 void CPU65C02::ROL_ACC() {
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (A & 0x80) >> 7;
-    A = (A << 1) | old_carry;
-    update_flags(A);
-    cycles += 2;  // ROL A takes 2 cycles
-    if (debug) cout << "ROL A" << endl;
-    print_registers();
+    uint8_t old_carry = regs.flag_c;
+    regs.flag_c = (regs.A & 0x80) >> 7;
+    regs.A = (regs.A << 1) | old_carry;
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "ROL A" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ROL_ZP() {
-    uint8_t addr = fetch_byte();
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x80) >> 7;
-    RAM[addr] = (RAM[addr] << 1) | old_carry;
-    update_flags(RAM[addr]);
-    cycles += 5;  // ROL ZP takes 5 cycles
-    if (debug) cout << "ROL $" << hex << (int)addr << endl;
-    print_registers();
-}
-
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t value = fetch_byte(addr);
+    uint8_t old_carry = regs.flag_c;
+    regs.flag_c = (value & 0x80) >> 7;
+    value = (value << 1) | old_carry;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "ROL $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
+}
+
+template <class Trace>
 void CPU65C02::ROL_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x80) >> 7;
-    RAM[addr] = (RAM[addr] << 1) | old_carry;
-    update_flags(RAM[addr]);
-    cycles += 6;  // ROL ZP,X takes 6 cycles
-    if (debug) cout << "ROL $" << hex << (int)addr << ",X" << endl;
-    print_registers();
-}
-
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    uint8_t value = fetch_byte(addr);
+    uint8_t old_carry = regs.flag_c;
+    regs.flag_c = (value & 0x80) >> 7;
+    value = (value << 1) | old_carry;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "ROL $" << hex << (int)addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
+}
+
+template <class Trace>
 void CPU65C02::ROL_ABS() {
-    uint16_t addr = fetch_word();
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x80) >> 7;
-    RAM[addr] = (RAM[addr] << 1) | old_carry;
-    update_flags(RAM[addr]);
-    cycles += 6;  // ROL ABS takes 6 cycles
-    if (debug) cout << "ROL $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
-}
-
+    uint16_t addr = fetch_operand_word<Trace>();
+    uint8_t value = fetch_byte(addr);
+    uint8_t old_carry = regs.flag_c;
+    regs.flag_c = (value & 0x80) >> 7;
+    value = (value << 1) | old_carry;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "ROL $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
+}
+
+template <class Trace>
 void CPU65C02::ROL_ABS_X() {
-    uint16_t addr = fetch_word() + X;
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x80) >> 7;
-    RAM[addr] = (RAM[addr] << 1) | old_carry;
-    update_flags(RAM[addr]);
-    cycles += 7;  // ROL ABS,X takes 7 cycles
-    if (debug) cout << "ROL $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.X;
+    cycles += page_crossed(base, addr);
+    uint8_t value = fetch_byte(addr);
+    uint8_t old_carry = regs.flag_c;
+    regs.flag_c = (value & 0x80) >> 7;
+    value = (value << 1) | old_carry;
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "ROL $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // ROR series
+template <class Trace>
 void CPU65C02::ROR_ACC() {
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (A & 0x01);
-    A = (A >> 1) | (old_carry << 7);
-    update_flags(A);
-    cycles += 2;  // ROR A takes 2 cycles
-    if (debug) cout << "ROR A" << endl;
-    print_registers();
+    uint8_t old_carry = regs.flag_c;
+    regs.flag_c = regs.A & 0x01;
+    regs.A = (regs.A >> 1) | (old_carry << 7);
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "ROR A" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
+template <class Trace>
 void CPU65C02::ROR_ZP() {
-    uint8_t addr = fetch_byte();
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x01);
-    RAM[addr] = (RAM[addr] >> 1) | (old_carry << 7);
-    update_flags(RAM[addr]);
-    cycles += 5;  // ROR ZP takes 5 cycles
-    if (debug) cout << "ROR $" << hex << (int)addr << endl;
-    print_registers();
-}
-
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t value = fetch_byte(addr);
+    uint8_t old_carry = regs.flag_c;
+    regs.flag_c = value & 0x01;
+    value = (value >> 1) | (old_carry << 7);
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "ROR $" << hex << (int)addr << endl;
+    if constexpr (Trace::enabled) print_registers();
+}
+
+template <class Trace>
 void CPU65C02::ROR_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x01);
-    RAM[addr] = (RAM[addr] >> 1) | (old_carry << 7);
-    update_flags(RAM[addr]);
-    cycles += 6;  // ROR ZP,X takes 6 cycles
-    if (debug) cout << "ROR $" << hex << (int)addr << ",X" << endl;
-    print_registers();
-}
-
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    uint8_t value = fetch_byte(addr);
+    uint8_t old_carry = regs.flag_c;
+    regs.flag_c = value & 0x01;
+    value = (value >> 1) | (old_carry << 7);
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "ROR $" << hex << (int)addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
+}
+
+template <class Trace>
 void CPU65C02::ROR_ABS() {
-    uint16_t addr = fetch_word();
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x01);
-    RAM[addr] = (RAM[addr] >> 1) | (old_carry << 7);
-    update_flags(RAM[addr]);
-    cycles += 6;  // ROR ABS takes 6 cycles
-    if (debug) cout << "ROR $" << hex << setw(4) << setfill('0') << addr << endl;
-    print_registers();
-}
-
+    uint16_t addr = fetch_operand_word<Trace>();
+    uint8_t value = fetch_byte(addr);
+    uint8_t old_carry = regs.flag_c;
+    regs.flag_c = value & 0x01;
+    value = (value >> 1) | (old_carry << 7);
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "ROR $" << hex << setw(4) << setfill('0') << addr << endl;
+    if constexpr (Trace::enabled) print_registers();
+}
+
+template <class Trace>
 void CPU65C02::ROR_ABS_X() {
-    uint16_t addr = fetch_word() + X;
-    uint8_t old_carry = status & 0x01;
-    status = (status & ~0x01) | (RAM[addr] & 0x01);
-    RAM[addr] = (RAM[addr] >> 1) | (old_carry << 7);
-    update_flags(RAM[addr]);
-    cycles += 7;  // ROR ABS,X takes 7 cycles
-    if (debug) cout << "ROR $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
-    print_registers();
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.X;
+    cycles += page_crossed(base, addr);
+    uint8_t value = fetch_byte(addr);
+    uint8_t old_carry = regs.flag_c;
+    regs.flag_c = value & 0x01;
+    value = (value >> 1) | (old_carry << 7);
+    store_byte(addr, value);
+    update_flags(value);
+    if constexpr (Trace::enabled) cout << "ROR $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    if constexpr (Trace::enabled) print_registers();
 }
 
 // Stack helper functions
 void CPU65C02::push(uint8_t value) {
-    RAM[0x100 + S] = value;
-    S--;
+    store_byte(0x100 + regs.S, value);
+    regs.S--;
 }
 
 uint8_t CPU65C02::pull() {
-    S++;
-    return RAM[0x100 + S];
+    regs.S++;
+    return fetch_byte(0x100 + regs.S);
 }
 
-void CPU65C02::update_NZ_flags(uint8_t value) {
-    // Update Zero flag
-    if (value == 0) {
-        status |= 0x02;  // Set Zero flag
-    } else {
-        status &= ~0x02; // Clear Zero flag
-    }
-    
-    // Update Negative flag
-    if (value & 0x80) {
-        status |= 0x80;  // Set Negative flag
-    } else {
-        status &= ~0x80; // Clear Negative flag
-    }
-}
 
 // Stack Operations
+template <class Trace>
 void CPU65C02::PHA() {
-    push(A);
-    cycles += 3;
-    if (debug) cout << "PHA: Pushed A ($" << hex << (int)A << ") to stack" << endl;
+    push(regs.A);
+    if constexpr (Trace::enabled) cout << "PHA: Pushed A ($" << hex << (int)regs.A << ") to stack" << endl;
 }
 
+template <class Trace>
 void CPU65C02::PHP() {
-    // Set B and U flags before pushing
-    uint8_t status_to_push = P;
-    status_to_push |= 0x30;  // Set B and U flags
+    uint8_t status_to_push = regs.P() | 0x30;  // Set B and U flags
     push(status_to_push);
-    cycles += 3;
-    if (debug) cout << "PHP: Pushed P ($" << hex << (int)status_to_push << ") to stack" << endl;
+    if constexpr (Trace::enabled) cout << "PHP: Pushed P ($" << hex << (int)status_to_push << ") to stack" << endl;
 }
 
+template <class Trace>
 void CPU65C02::PLA() {
-    A = pull();
-    update_NZ_flags(A);
-    cycles += 4;
-    if (debug) cout << "PLA: Pulled $" << hex << (int)A << " from stack to A" << endl;
+    regs.A = pull();
+    update_flags(regs.A);
+    if constexpr (Trace::enabled) cout << "PLA: Pulled $" << hex << (int)regs.A << " from stack to A" << endl;
 }
 
+template <class Trace>
 void CPU65C02::PLP() {
-    P = pull();
-    cycles += 4;
-    if (debug) cout << "PLP: Pulled $" << hex << (int)P << " from stack to P" << endl;
+    regs.set_P(pull());
+    poll_interrupts();  // I may now be clear with an IRQ pending
+    if constexpr (Trace::enabled) cout << "PLP: Pulled $" << hex << (int)regs.P() << " from stack to P" << endl;
 }
 
+template <class Trace>
 void CPU65C02::TSX() {
-    X = S;
-    update_NZ_flags(X);
-    cycles += 2;
-    if (debug) cout << "TSX: Transferred SP ($" << hex << (int)S << ") to X" << endl;
+    regs.X = regs.S;
+    update_flags(regs.X);
+    if constexpr (Trace::enabled) cout << "TSX: Transferred SP ($" << hex << (int)regs.S << ") to X" << endl;
 }
 
+template <class Trace>
 void CPU65C02::TXS() {
-    S = X;
-    cycles += 2;
-    if (debug) cout << "TXS: Transferred X ($" << hex << (int)X << ") to SP" << endl;
+    regs.S = regs.X;
+    if constexpr (Trace::enabled) cout << "TXS: Transferred X ($" << hex << (int)regs.X << ") to SP" << endl;
 }
 
 // Branch Instructions Implementation
-void CPU65C02::BCC() {
-    int8_t offset = fetch_byte();
-    if (!(status & 0x01)) {  // Carry Clear
-        PC += offset;
-        cycles += 3;
-        if (debug) cout << "BCC: Branch taken, new PC = $" << hex << (int)PC << endl;
-    } else {
-        cycles += 2;
-        if (debug) cout << "BCC: Branch not taken" << endl;
+
+// Shared by every conditional branch and BRA. The base 2 cycles come from the
+// opcode map; a taken branch adds one, and one more if it lands on another
+// page. Both penalties and the new PC are computed without a branch.
+template <class Trace>
+void CPU65C02::branch_if(bool condition, const char* name) {
+    int8_t offset = fetch_operand<Trace>();
+    uint16_t target = regs.PC + offset;
+    unsigned taken = condition;
+    cycles += taken + (taken & page_crossed(regs.PC, target));
+    regs.PC = taken ? target : regs.PC;
+    if constexpr (Trace::enabled) {
+        if (taken) {
+            cout << name << ": Branch taken, new PC = $" << hex << (int)regs.PC << endl;
+        } else {
+            cout << name << ": Branch not taken" << endl;
+        }
     }
 }
 
+template <class Trace>
+void CPU65C02::BCC() {
+    branch_if<Trace>(!regs.flag_c, "BCC");  // Carry Clear
+}
+
+template <class Trace>
 void CPU65C02::BCS() {
-    int8_t offset = fetch_byte();
-    if (status & 0x01) {  // Carry Set
-        PC += offset;
-        cycles += 3;
-        if (debug) cout << "BCS: Branch taken, new PC = $" << hex << (int)PC << endl;
-    } else {
-        cycles += 2;
-        if (debug) cout << "BCS: Branch not taken" << endl;
-    }
+    branch_if<Trace>(regs.flag_c, "BCS");  // Carry Set
 }
 
+template <class Trace>
 void CPU65C02::BEQ() {
-    int8_t offset = fetch_byte();
-    if (status & 0x02) {  // Zero Set
-        PC += offset;
-        cycles += 3;
-        if (debug) cout << "BEQ: Branch taken, new PC = $" << hex << (int)PC << endl;
-    } else {
-        cycles += 2;
-        if (debug) cout << "BEQ: Branch not taken" << endl;
-    }
+    branch_if<Trace>(!regs.flag_z, "BEQ");  // Zero Set
 }
 
+template <class Trace>
 void CPU65C02::BNE() {
-    int8_t offset = fetch_byte();
-    if (!(status & 0x02)) {  // Zero Clear
-        PC += offset;
-        cycles += 3;
-        if (debug) cout << "BNE: Branch taken, new PC = $" << hex << (int)PC << endl;
-    } else {
-        cycles += 2;
-        if (debug) cout << "BNE: Branch not taken" << endl;
-    }
+    branch_if<Trace>(regs.flag_z, "BNE");  // Zero Clear
 }
 
+template <class Trace>
 void CPU65C02::BMI() {
-    int8_t offset = fetch_byte();
-    if (status & 0x80) {  // Negative Set
-        PC += offset;
-        cycles += 3;
-        if (debug) cout << "BMI: Branch taken, new PC = $" << hex << (int)PC << endl;
-    } else {
-        cycles += 2;
-        if (debug) cout << "BMI: Branch not taken" << endl;
-    }
+    branch_if<Trace>(regs.flag_n & 0x80, "BMI");  // Negative Set
 }
 
+template <class Trace>
 void CPU65C02::BPL() {
-    int8_t offset = fetch_byte();
-    if (!(status & 0x80)) {  // Negative Clear
-        PC += offset;
-        cycles += 3;
-        if (debug) cout << "BPL: Branch taken, new PC = $" << hex << (int)PC << endl;
-    } else {
-        cycles += 2;
-        if (debug) cout << "BPL: Branch not taken" << endl;
-    }
+    branch_if<Trace>(!(regs.flag_n & 0x80), "BPL");  // Negative Clear
 }
 
+template <class Trace>
 void CPU65C02::BVC() {
-    int8_t offset = fetch_byte();
-    if (!(status & 0x40)) {  // Overflow Clear
-        PC += offset;
-        cycles += 3;
-        if (debug) cout << "BVC: Branch taken, new PC = $" << hex << (int)PC << endl;
-    } else {
-        cycles += 2;
-        if (debug) cout << "BVC: Branch not taken" << endl;
-    }
+    branch_if<Trace>(!(regs.flag_v & 0x80), "BVC");  // Overflow Clear
 }
 
+template <class Trace>
 void CPU65C02::BVS() {
-    int8_t offset = fetch_byte();
-    if (status & 0x40) {  // Overflow Set
-        PC += offset;
-        cycles += 3;
-        if (debug) cout << "BVS: Branch taken, new PC = $" << hex << (int)PC << endl;
-    } else {
-        cycles += 2;
-        if (debug) cout << "BVS: Branch not taken" << endl;
-    }
+    branch_if<Trace>(regs.flag_v & 0x80, "BVS");  // Overflow Set
 }
 
 // Status Flag Operations Implementation
+template <class Trace>
 void CPU65C02::CLC() {
-    status &= ~0x01;  // Clear Carry flag
-    cycles += 2;
-    if (debug) cout << "CLC: Cleared Carry flag" << endl;
+    regs.flag_c = 0;  // Clear Carry flag
+    if constexpr (Trace::enabled) cout << "CLC: Cleared Carry flag" << endl;
 }
 
+template <class Trace>
 void CPU65C02::SEC() {
-    status |= 0x01;   // Set Carry flag
-    cycles += 2;
-    if (debug) cout << "SEC: Set Carry flag" << endl;
+    regs.flag_c = 1;  // Set Carry flag
+    if constexpr (Trace::enabled) cout << "SEC: Set Carry flag" << endl;
 }
 
+template <class Trace>
 void CPU65C02::CLD() {
-    status &= ~0x08;  // Clear Decimal mode flag
-    cycles += 2;
-    if (debug) cout << "CLD: Cleared Decimal mode flag" << endl;
+    regs.status &= ~0x08;  // Clear Decimal mode flag
+    if constexpr (Trace::enabled) cout << "CLD: Cleared Decimal mode flag" << endl;
 }
 
+template <class Trace>
 void CPU65C02::SED() {
-    status |= 0x08;   // Set Decimal mode flag
-    cycles += 2;
-    if (debug) cout << "SED: Set Decimal mode flag" << endl;
+    regs.status |= 0x08;   // Set Decimal mode flag
+    if constexpr (Trace::enabled) cout << "SED: Set Decimal mode flag" << endl;
 }
 
+template <class Trace>
 void CPU65C02::CLI() {
-    status &= ~0x04;  // Clear Interrupt Disable flag
-    cycles += 2;
-    if (debug) cout << "CLI: Cleared Interrupt Disable flag" << endl;
+    regs.status &= ~0x04;  // Clear Interrupt Disable flag
+    poll_interrupts();
+    if constexpr (Trace::enabled) cout << "CLI: Cleared Interrupt Disable flag" << endl;
 }
 
+template <class Trace>
 void CPU65C02::SEI() {
-    status |= 0x04;   // Set Interrupt Disable flag
-    cycles += 2;
-    if (debug) cout << "SEI: Set Interrupt Disable flag" << endl;
+    regs.status |= 0x04;   // Set Interrupt Disable flag
+    if constexpr (Trace::enabled) cout << "SEI: Set Interrupt Disable flag" << endl;
 }
 
+template <class Trace>
 void CPU65C02::CLV() {
-    status &= ~0x40;  // Clear Overflow flag
-    cycles += 2;
-    if (debug) cout << "CLV: Cleared Overflow flag" << endl;
+    regs.flag_v = 0;  // Clear Overflow flag
+    if constexpr (Trace::enabled) cout << "CLV: Cleared Overflow flag" << endl;
 }
 
 // Comparison Operations Implementation
+template <class Trace>
 void CPU65C02::CMP_IMM() {
-    uint8_t operand = fetch_byte();
-    uint8_t result = A - operand;
+    uint8_t operand = fetch_operand<Trace>();
+    uint8_t result = regs.A - operand;
     update_flags(result);
-    status = (status & ~0x01) | (A >= operand); // Set carry if A >= operand
-    cycles += 2;
-    if (debug) cout << "CMP #$" << hex << (int)operand << endl;
+    regs.flag_c = regs.A >= operand; // Set carry if A >= operand
+    if constexpr (Trace::enabled) cout << "CMP #$" << hex << (int)operand << endl;
 }
 
+template <class Trace>
 void CPU65C02::CMP_ZP() {
-    uint8_t addr = fetch_byte();
-    uint8_t operand = RAM[addr];
-    uint8_t result = A - operand;
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = regs.A - operand;
     update_flags(result);
-    status = (status & ~0x01) | (A >= operand);
-    cycles += 3;
-    if (debug) cout << "CMP $" << hex << (int)addr << endl;
+    regs.flag_c = regs.A >= operand;
+    if constexpr (Trace::enabled) cout << "CMP $" << hex << (int)addr << endl;
 }
 
+template <class Trace>
 void CPU65C02::CMP_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    uint8_t operand = RAM[addr];
-    uint8_t result = A - operand;
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = regs.A - operand;
     update_flags(result);
-    status = (status & ~0x01) | (A >= operand);
-    cycles += 4;
-    if (debug) cout << "CMP $" << hex << (int)addr << ",X" << endl;
+    regs.flag_c = regs.A >= operand;
+    if constexpr (Trace::enabled) cout << "CMP $" << hex << (int)addr << ",X" << endl;
 }
 
+template <class Trace>
 void CPU65C02::CMP_ABS() {
-    uint16_t addr = fetch_word();
-    uint8_t operand = RAM[addr];
-    uint8_t result = A - operand;
+    uint16_t addr = fetch_operand_word<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = regs.A - operand;
     update_flags(result);
-    status = (status & ~0x01) | (A >= operand);
-    cycles += 4;
-    if (debug) cout << "CMP $" << hex << setw(4) << setfill('0') << addr << endl;
+    regs.flag_c = regs.A >= operand;
+    if constexpr (Trace::enabled) cout << "CMP $" << hex << setw(4) << setfill('0') << addr << endl;
 }
 
+template <class Trace>
 void CPU65C02::CMP_ABS_X() {
-    uint16_t addr = fetch_word() + X;
-    uint8_t operand = RAM[addr];
-    uint8_t result = A - operand;
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.X;
+    cycles += page_crossed(base, addr);
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = regs.A - operand;
     update_flags(result);
-    status = (status & ~0x01) | (A >= operand);
-    cycles += 4;
-    if (debug) cout << "CMP $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    regs.flag_c = regs.A >= operand;
+    if constexpr (Trace::enabled) cout << "CMP $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
 }
 
+template <class Trace>
 void CPU65C02::CMP_ABS_Y() {
-    uint16_t addr = fetch_word() + Y;
-    uint8_t operand = RAM[addr];
-    uint8_t result = A - operand;
+    uint16_t base = fetch_operand_word<Trace>();
+    uint16_t addr = base + regs.Y;
+    cycles += page_crossed(base, addr);
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = regs.A - operand;
     update_flags(result);
-    status = (status & ~0x01) | (A >= operand);
-    cycles += 4;
-    if (debug) cout << "CMP $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
+    regs.flag_c = regs.A >= operand;
+    if constexpr (Trace::enabled) cout << "CMP $" << hex << setw(4) << setfill('0') << addr << ",Y" << endl;
 }
 
+template <class Trace>
 void CPU65C02::CMP_PRE_IND_X() {
-    uint8_t zp_addr = fetch_byte() + X;
-    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    uint8_t operand = RAM[addr];
-    uint8_t result = A - operand;
+    uint8_t zp_addr = fetch_operand<Trace>() + regs.X;
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = regs.A - operand;
     update_flags(result);
-    status = (status & ~0x01) | (A >= operand);
-    cycles += 6;
-    if (debug) cout << "CMP ($" << hex << (int)zp_addr << ",X)" << endl;
+    regs.flag_c = regs.A >= operand;
+    if constexpr (Trace::enabled) cout << "CMP ($" << hex << (int)zp_addr << ",X)" << endl;
 }
 
+template <class Trace>
 void CPU65C02::CMP_POST_IND_Y() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t base = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    uint8_t operand = RAM[base + Y];
-    uint8_t result = A - operand;
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t base = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    cycles += page_crossed(base, base + regs.Y);
+    uint8_t operand = fetch_byte(base + regs.Y);
+    uint8_t result = regs.A - operand;
     update_flags(result);
-    status = (status & ~0x01) | (A >= operand);
-    cycles += 5;
-    if (debug) cout << "CMP ($" << hex << (int)zp_addr << "),Y" << endl;
+    regs.flag_c = regs.A >= operand;
+    if constexpr (Trace::enabled) cout << "CMP ($" << hex << (int)zp_addr << "),Y" << endl;
 }
 
+template <class Trace>
 void CPU65C02::CMP_IND() {
-    uint8_t zp_addr = fetch_byte();
-    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte(zp_addr + 1) << 8);
-    uint8_t operand = RAM[addr];
-    uint8_t result = A - operand;
+    uint8_t zp_addr = fetch_operand<Trace>();
+    uint16_t addr = fetch_byte(zp_addr) + (fetch_byte((uint8_t)(zp_addr + 1)) << 8);
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = regs.A - operand;
     update_flags(result);
-    status = (status & ~0x01) | (A >= operand);
-    cycles += 5;
-    if (debug) cout << "CMP ($" << hex << (int)zp_addr << ")" << endl;
+    regs.flag_c = regs.A >= operand;
+    if constexpr (Trace::enabled) cout << "CMP ($" << hex << (int)zp_addr << ")" << endl;
 }
 
+template <class Trace>
 void CPU65C02::CPX_IMM() {
-    uint8_t operand = fetch_byte();
-    uint8_t result = X - operand;
+    uint8_t operand = fetch_operand<Trace>();
+    uint8_t result = regs.X - operand;
     update_flags(result);
-    status = (status & ~0x01) | (X >= operand);
-    cycles += 2;
-    if (debug) cout << "CPX #$" << hex << (int)operand << endl;
+    regs.flag_c = regs.X >= operand;
+    if constexpr (Trace::enabled) cout << "CPX #$" << hex << (int)operand << endl;
 }
 
+template <class Trace>
 void CPU65C02::CPX_ZP() {
-    uint8_t addr = fetch_byte();
-    uint8_t operand = RAM[addr];
-    uint8_t result = X - operand;
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = regs.X - operand;
     update_flags(result);
-    status = (status & ~0x01) | (X >= operand);
-    cycles += 3;
-    if (debug) cout << "CPX $" << hex << (int)addr << endl;
+    regs.flag_c = regs.X >= operand;
+    if constexpr (Trace::enabled) cout << "CPX $" << hex << (int)addr << endl;
 }
 
+template <class Trace>
 void CPU65C02::CPX_ABS() {
-    uint16_t addr = fetch_word();
-    uint8_t operand = RAM[addr];
-    uint8_t result = X - operand;
+    uint16_t addr = fetch_operand_word<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = regs.X - operand;
     update_flags(result);
-    status = (status & ~0x01) | (X >= operand);
-    cycles += 4;
-    if (debug) cout << "CPX $" << hex << setw(4) << setfill('0') << addr << endl;
+    regs.flag_c = regs.X >= operand;
+    if constexpr (Trace::enabled) cout << "CPX $" << hex << setw(4) << setfill('0') << addr << endl;
 }
 
+template <class Trace>
 void CPU65C02::CPY_IMM() {
-    uint8_t operand = fetch_byte();
-    uint8_t result = Y - operand;
+    uint8_t operand = fetch_operand<Trace>();
+    uint8_t result = regs.Y - operand;
     update_flags(result);
-    status = (status & ~0x01) | (Y >= operand);
-    cycles += 2;
-    if (debug) cout << "CPY #$" << hex << (int)operand << endl;
+    regs.flag_c = regs.Y >= operand;
+    if constexpr (Trace::enabled) cout << "CPY #$" << hex << (int)operand << endl;
 }
 
+template <class Trace>
 void CPU65C02::CPY_ZP() {
-    uint8_t addr = fetch_byte();
-    uint8_t operand = RAM[addr];
-    uint8_t result = Y - operand;
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = regs.Y - operand;
     update_flags(result);
-    status = (status & ~0x01) | (Y >= operand);
-    cycles += 3;
-    if (debug) cout << "CPY $" << hex << (int)addr << endl;
+    regs.flag_c = regs.Y >= operand;
+    if constexpr (Trace::enabled) cout << "CPY $" << hex << (int)addr << endl;
 }
 
+template <class Trace>
 void CPU65C02::CPY_ABS() {
-    uint16_t addr = fetch_word();
-    uint8_t operand = RAM[addr];
-    uint8_t result = Y - operand;
+    uint16_t addr = fetch_operand_word<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = regs.Y - operand;
     update_flags(result);
-    status = (status & ~0x01) | (Y >= operand);
-    cycles += 4;
-    if (debug) cout << "CPY $" << hex << setw(4) << setfill('0') << addr << endl;
+    regs.flag_c = regs.Y >= operand;
+    if constexpr (Trace::enabled) cout << "CPY $" << hex << setw(4) << setfill('0') << addr << endl;
 }
 
 // Additional 65C02-specific instructions Implementation
+template <class Trace>
 void CPU65C02::BRA() {
-    int8_t offset = fetch_byte();
-    PC += offset;
-    cycles += 3;
-    if (debug) cout << "BRA: Branch taken, new PC = $" << hex << (int)PC << endl;
+    branch_if<Trace>(true, "BRA");
 }
 
+template <class Trace>
 void CPU65C02::PHX() {
-    push(X);
-    cycles += 3;
-    if (debug) cout << "PHX: Pushed X ($" << hex << (int)X << ") to stack" << endl;
+    push(regs.X);
+    if constexpr (Trace::enabled) cout << "PHX: Pushed X ($" << hex << (int)regs.X << ") to stack" << endl;
 }
 
+template <class Trace>
 void CPU65C02::PHY() {
-    push(Y);
-    cycles += 3;
-    if (debug) cout << "PHY: Pushed Y ($" << hex << (int)Y << ") to stack" << endl;
+    push(regs.Y);
+    if constexpr (Trace::enabled) cout << "PHY: Pushed Y ($" << hex << (int)regs.Y << ") to stack" << endl;
 }
 
+template <class Trace>
 void CPU65C02::PLX() {
-    X = pull();
-    update_NZ_flags(X);
-    cycles += 4;
-    if (debug) cout << "PLX: Pulled $" << hex << (int)X << " from stack to X" << endl;
+    regs.X = pull();
+    update_flags(regs.X);
+    if constexpr (Trace::enabled) cout << "PLX: Pulled $" << hex << (int)regs.X << " from stack to X" << endl;
 }
 
+template <class Trace>
 void CPU65C02::PLY() {
-    Y = pull();
-    update_NZ_flags(Y);
-    cycles += 4;
-    if (debug) cout << "PLY: Pulled $" << hex << (int)Y << " from stack to Y" << endl;
+    regs.Y = pull();
+    update_flags(regs.Y);
+    if constexpr (Trace::enabled) cout << "PLY: Pulled $" << hex << (int)regs.Y << " from stack to Y" << endl;
 }
 
+template <class Trace>
 void CPU65C02::STZ_ZP() {
-    uint8_t addr = fetch_byte();
-    RAM[addr] = 0;
-    cycles += 3;
-    if (debug) cout << "STZ $" << hex << (int)addr << endl;
+    uint8_t addr = fetch_operand<Trace>();
+    store_byte(addr, 0);
+    if constexpr (Trace::enabled) cout << "STZ $" << hex << (int)addr << endl;
 }
 
+template <class Trace>
 void CPU65C02::STZ_ZP_X() {
-    uint8_t addr = fetch_byte() + X;
-    RAM[addr] = 0;
-    cycles += 4;
-    if (debug) cout << "STZ $" << hex << (int)addr << ",X" << endl;
+    uint8_t addr = fetch_operand<Trace>() + regs.X;
+    store_byte(addr, 0);
+    if constexpr (Trace::enabled) cout << "STZ $" << hex << (int)addr << ",X" << endl;
 }
 
+template <class Trace>
 void CPU65C02::STZ_ABS() {
-    uint16_t addr = fetch_word();
-    RAM[addr] = 0;
-    cycles += 4;
-    if (debug) cout << "STZ $" << hex << setw(4) << setfill('0') << addr << endl;
+    uint16_t addr = fetch_operand_word<Trace>();
+    store_byte(addr, 0);
+    if constexpr (Trace::enabled) cout << "STZ $" << hex << setw(4) << setfill('0') << addr << endl;
 }
 
+template <class Trace>
 void CPU65C02::STZ_ABS_X() {
-    uint16_t addr = fetch_word() + X;
-    RAM[addr] = 0;
-    cycles += 5;
-    if (debug) cout << "STZ $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
+    uint16_t addr = fetch_operand_word<Trace>() + regs.X;
+    store_byte(addr, 0);
+    if constexpr (Trace::enabled) cout << "STZ $" << hex << setw(4) << setfill('0') << addr << ",X" << endl;
 }
 
+template <class Trace>
 void CPU65C02::TRB_ZP() {
-    uint8_t addr = fetch_byte();
-    uint8_t operand = RAM[addr];
-    uint8_t result = operand & ~A;  // Reset bits that are set in A
-    RAM[addr] = result;
-    update_NZ_flags(result);
-    cycles += 5;
-    if (debug) cout << "TRB $" << hex << (int)addr << endl;
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = operand & ~regs.A;  // Reset bits that are set in A
+    store_byte(addr, result);
+    regs.flag_z = regs.A & operand;  // Only Z, from the bits A selects
+    if constexpr (Trace::enabled) cout << "TRB $" << hex << (int)addr << endl;
 }
 
+template <class Trace>
 void CPU65C02::TRB_ABS() {
-    uint16_t addr = fetch_word();
-    uint8_t operand = RAM[addr];
-    uint8_t result = operand & ~A;  // Reset bits that are set in A
-    RAM[addr] = result;
-    update_NZ_flags(result);
-    cycles += 6;
-    if (debug) cout << "TRB $" << hex << setw(4) << setfill('0') << addr << endl;
+    uint16_t addr = fetch_operand_word<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = operand & ~regs.A;  // Reset bits that are set in A
+    store_byte(addr, result);
+    regs.flag_z = regs.A & operand;  // Only Z, from the bits A selects
+    if constexpr (Trace::enabled) cout << "TRB $" << hex << setw(4) << setfill('0') << addr << endl;
 }
 
+template <class Trace>
 void CPU65C02::TSB_ZP() {
-    uint8_t addr = fetch_byte();
-    uint8_t operand = RAM[addr];
-    uint8_t result = operand | A;  // Set bits that are set in A
-    RAM[addr] = result;
-    update_NZ_flags(result);
-    cycles += 5;
-    if (debug) cout << "TSB $" << hex << (int)addr << endl;
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = operand | regs.A;  // Set bits that are set in A
+    store_byte(addr, result);
+    regs.flag_z = regs.A & operand;  // Only Z, from the bits A selects
+    if constexpr (Trace::enabled) cout << "TSB $" << hex << (int)addr << endl;
 }
 
+template <class Trace>
 void CPU65C02::TSB_ABS() {
-    uint16_t addr = fetch_word();
-    uint8_t operand = RAM[addr];
-    uint8_t result = operand | A;  // Set bits that are set in A
-    RAM[addr] = result;
-    update_NZ_flags(result);
-    cycles += 6;
-    if (debug) cout << "TSB $" << hex << setw(4) << setfill('0') << addr << endl;
-} 
\ No newline at end of file
+    uint16_t addr = fetch_operand_word<Trace>();
+    uint8_t operand = fetch_byte(addr);
+    uint8_t result = operand | regs.A;  // Set bits that are set in A
+    store_byte(addr, result);
+    regs.flag_z = regs.A & operand;  // Only Z, from the bits A selects
+    if constexpr (Trace::enabled) cout << "TSB $" << hex << setw(4) << setfill('0') << addr << endl;
+} 
+
+// Bit manipulation implementation. RMBn/SMBn reset or set bit n of a zero
+// page byte without touching the flags.
+template <class Trace>
+void CPU65C02::change_bit(uint8_t mask, bool set, const char* name) {
+    uint8_t addr = fetch_operand<Trace>();
+    uint8_t value = fetch_byte(addr);
+    store_byte(addr, set ? value | mask : value & ~mask);
+    if constexpr (Trace::enabled) cout << name << " $" << hex << (int)addr << endl;
+}
+
+// BBRn/BBSn test bit n of a zero page byte and branch on it like the other
+// relative branches, with the same taken and page-cross penalties
+template <class Trace>
+void CPU65C02::branch_on_bit(uint8_t mask, bool set, const char* name) {
+    uint8_t addr = fetch_operand<Trace>();
+    bool bit = fetch_byte(addr) & mask;
+    branch_if<Trace>(bit == set, name);
+}
+
+template <class Trace>
+void CPU65C02::RMB0_ZP() {
+    change_bit<Trace>(0x01, false, "RMB0");
+}
+
+template <class Trace>
+void CPU65C02::RMB1_ZP() {
+    change_bit<Trace>(0x02, false, "RMB1");
+}
+
+template <class Trace>
+void CPU65C02::RMB2_ZP() {
+    change_bit<Trace>(0x04, false, "RMB2");
+}
+
+template <class Trace>
+void CPU65C02::RMB3_ZP() {
+    change_bit<Trace>(0x08, false, "RMB3");
+}
+
+template <class Trace>
+void CPU65C02::RMB4_ZP() {
+    change_bit<Trace>(0x10, false, "RMB4");
+}
+
+template <class Trace>
+void CPU65C02::RMB5_ZP() {
+    change_bit<Trace>(0x20, false, "RMB5");
+}
+
+template <class Trace>
+void CPU65C02::RMB6_ZP() {
+    change_bit<Trace>(0x40, false, "RMB6");
+}
+
+template <class Trace>
+void CPU65C02::RMB7_ZP() {
+    change_bit<Trace>(0x80, false, "RMB7");
+}
+
+template <class Trace>
+void CPU65C02::SMB0_ZP() {
+    change_bit<Trace>(0x01, true, "SMB0");
+}
+
+template <class Trace>
+void CPU65C02::SMB1_ZP() {
+    change_bit<Trace>(0x02, true, "SMB1");
+}
+
+template <class Trace>
+void CPU65C02::SMB2_ZP() {
+    change_bit<Trace>(0x04, true, "SMB2");
+}
+
+template <class Trace>
+void CPU65C02::SMB3_ZP() {
+    change_bit<Trace>(0x08, true, "SMB3");
+}
+
+template <class Trace>
+void CPU65C02::SMB4_ZP() {
+    change_bit<Trace>(0x10, true, "SMB4");
+}
+
+template <class Trace>
+void CPU65C02::SMB5_ZP() {
+    change_bit<Trace>(0x20, true, "SMB5");
+}
+
+template <class Trace>
+void CPU65C02::SMB6_ZP() {
+    change_bit<Trace>(0x40, true, "SMB6");
+}
+
+template <class Trace>
+void CPU65C02::SMB7_ZP() {
+    change_bit<Trace>(0x80, true, "SMB7");
+}
+
+template <class Trace>
+void CPU65C02::BBR0_ZP_REL() {
+    branch_on_bit<Trace>(0x01, false, "BBR0");
+}
+
+template <class Trace>
+void CPU65C02::BBR1_ZP_REL() {
+    branch_on_bit<Trace>(0x02, false, "BBR1");
+}
+
+template <class Trace>
+void CPU65C02::BBR2_ZP_REL() {
+    branch_on_bit<Trace>(0x04, false, "BBR2");
+}
+
+template <class Trace>
+void CPU65C02::BBR3_ZP_REL() {
+    branch_on_bit<Trace>(0x08, false, "BBR3");
+}
+
+template <class Trace>
+void CPU65C02::BBR4_ZP_REL() {
+    branch_on_bit<Trace>(0x10, false, "BBR4");
+}
+
+template <class Trace>
+void CPU65C02::BBR5_ZP_REL() {
+    branch_on_bit<Trace>(0x20, false, "BBR5");
+}
+
+template <class Trace>
+void CPU65C02::BBR6_ZP_REL() {
+    branch_on_bit<Trace>(0x40, false, "BBR6");
+}
+
+template <class Trace>
+void CPU65C02::BBR7_ZP_REL() {
+    branch_on_bit<Trace>(0x80, false, "BBR7");
+}
+
+template <class Trace>
+void CPU65C02::BBS0_ZP_REL() {
+    branch_on_bit<Trace>(0x01, true, "BBS0");
+}
+
+template <class Trace>
+void CPU65C02::BBS1_ZP_REL() {
+    branch_on_bit<Trace>(0x02, true, "BBS1");
+}
+
+template <class Trace>
+void CPU65C02::BBS2_ZP_REL() {
+    branch_on_bit<Trace>(0x04, true, "BBS2");
+}
+
+template <class Trace>
+void CPU65C02::BBS3_ZP_REL() {
+    branch_on_bit<Trace>(0x08, true, "BBS3");
+}
+
+template <class Trace>
+void CPU65C02::BBS4_ZP_REL() {
+    branch_on_bit<Trace>(0x10, true, "BBS4");
+}
+
+template <class Trace>
+void CPU65C02::BBS5_ZP_REL() {
+    branch_on_bit<Trace>(0x20, true, "BBS5");
+}
+
+template <class Trace>
+void CPU65C02::BBS6_ZP_REL() {
+    branch_on_bit<Trace>(0x40, true, "BBS6");
+}
+
+template <class Trace>
+void CPU65C02::BBS7_ZP_REL() {
+    branch_on_bit<Trace>(0x80, true, "BBS7");
+}
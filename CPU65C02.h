@@ -1,253 +1,652 @@
 #ifndef CPU65C02_H
 #define CPU65C02_H
 
+#include "Memory.h"
+#include "Scheduler.h"
 #include <cstdint>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+// The threaded core needs labels-as-values, a GCC/Clang extension
+#if defined(__GNUC__) || defined(__clang__)
+#define CPU65C02_COMPUTED_GOTO 1
+#else
+#define CPU65C02_COMPUTED_GOTO 0
+#endif
+
+// Small helpers shared by many handlers must be inlined into the switch and
+// threaded cores, or each use costs a call
+#if defined(__GNUC__) || defined(__clang__)
+#define CPU65C02_INLINE inline __attribute__((always_inline))
+#else
+#define CPU65C02_INLINE inline
+#endif
+
+// The JIT emits x86-64 System V code into an mmap'd buffer
+#if defined(__x86_64__) && defined(__linux__)
+#define CPU65C02_JIT 1
+#else
+#define CPU65C02_JIT 0
+#endif
+
+class Jit;
+class WideCPU;
+class TraceRecorder;
+class Profiler;
+
+// Tracing policies for the instruction handlers. Every handler is a template
+// on one of these; the NoTrace instantiation compiles without any of the
+// debug output, DebugTrace prints each instruction and the registers.
+struct NoTrace {
+    static constexpr bool enabled = false;
+    static constexpr bool decoded = false;
+};
+
+struct DebugTrace {
+    static constexpr bool enabled = true;
+    static constexpr bool decoded = false;
+};
+
+// Handlers instantiated on Decoded<Trace> take their operand from the block
+// cache instead of fetching it from memory at PC.
+template <class Trace>
+struct Decoded : Trace {
+    static constexpr bool decoded = true;
+};
+
+class CPU65C02 : private PageWatcher, private ScheduleWatcher {
+public:
+    // Interpreter cores, selectable at runtime. Table calls each handler
+    // through opcode_table; Switch and Threaded inline the handlers into a
+    // single dispatch loop. Switch is the default: Threaded's computed goto
+    // measured no faster on the benchmarks or the functional test image,
+    // and falls back to Switch where unsupported.
+    // Block runs basic blocks pre-decoded into the block cache, and Jit
+    // additionally translates hot blocks to native code (falling back to
+    // Block where unsupported).
+    enum class Engine { Table, Switch, Threaded, Block, Jit };
+
+    // Why run_cycles()/run_instructions() returned
+    enum class StopReason {
+        Budget,         // The cycle or instruction budget was used up
+        Brk,            // Reached a BRK; PC is left on the opcode
+        Halt,           // Reached STP; PC is left on the opcode
+        Wait,           // Waiting at WAI with no interrupt raised; PC is left
+                        // after it, and a later run resumes once one is
+        Breakpoint,     // Reached a breakpoint; PC is left on it
+        Watchpoint      // Read or wrote a watched address; PC is left after
+                        // the instruction that did
+    };
+
+    // Decides whether a breakpoint or watchpoint that was hit stops the run
+    typedef std::function<bool(CPU65C02&)> StopCondition;
+
+    // The access that last hit a watchpoint
+    struct WatchHit {
+        uint16_t address;
+        uint8_t value; // Read, or about to be in memory
+        bool write;
+    };
+
+    // The register file, small enough to copy whole into snapshots and batch
+    // results. P is kept apart the way instructions produce it: N, Z, C and
+    // V are raw results in the flag_ bytes, and P() packs them with the
+    // other bits only when something reads the whole register. Loads and ALU
+    // ops store their result to flag_n/flag_z instead of testing it.
+    struct Registers {
+        uint16_t PC;
+        uint8_t A, X, Y;
+        uint8_t S; // Stack pointer, into page 1
+        uint8_t status; // The P bits not kept in the flag_ bytes: D, I, B and bit 5
+        uint8_t flag_n; // N is bit 7
+        uint8_t flag_z; // Z is set when this is zero
+        uint8_t flag_c; // C, 0 or 1
+        uint8_t flag_v; // V is bit 7
+
+        uint8_t P() const {
+            return (status & 0x3C) | (flag_n & 0x80) | ((flag_v & 0x80) >> 1) | (flag_z ? 0 : 0x02) | flag_c;
+        }
+        void set_P(uint8_t value) {
+            status = value & 0x3C;
+            flag_n = value;
+            flag_z = ~value & 0x02;
+            flag_c = value & 0x01;
+            flag_v = value << 1;
+        }
+    };
+    static_assert(sizeof(Registers) == 12, "Registers must stay packed");
+
+    // Complete CPU state. The memory half shares pages with the CPU, so
+    // taking and restoring one costs a page table plus the dirty pages.
+    struct Snapshot {
+        Registers regs;
+        uint64_t cycles;
+        uint8_t irq_lines;
+        bool nmi_pending, waiting;
+        MemorySnapshot memory;
+    };
 
-class CPU65C02 {
 private:
-    uint8_t A, X, Y, S, P; // 8-bit registers // S is the stack pointer register
-    uint16_t PC; // 16-bit address counter
-    uint8_t status; // 8-bit status register
-    uint8_t RAM[65536]; // 64KB of RAM, 16 bits address
-    uint32_t cycles; // Cycle counter
-    bool debug; // Debug flag
+    friend class Jit;
+    friend class WideCPU;
+    Registers regs;
+    Memory memory; // 64KB address space, copy-on-write 256-byte pages
+    Scheduler scheduler; // Device events, keyed on cycles
+    uint64_t cycles; // Cycle counter; 64-bit so long runs never wrap
+    bool debug; // Debug flag, selects the DebugTrace instantiation
     typedef void (CPU65C02::*OpCodeFn)();
-    OpCodeFn opcode_table[256];
-
-    uint8_t fetch_byte();
-    uint8_t fetch_byte(uint16_t addr);
+    typedef void (*DecodedFn)(CPU65C02&);
+    // Dispatch tables built at compile time from the opcode map, one pair
+    // per tracing policy; the CPU points at the pair debug selects
+    template <class Trace> static const OpCodeFn opcode_tables[256];
+    template <class Trace> static const DecodedFn decoded_tables[256];
+    const OpCodeFn* opcode_table;
+    Engine engine;
+    uint64_t deadline; // The run loop stops once cycles reaches this
+    uint64_t cycle_limit; // Deadline of the current run; deadline may drop below it
+    StopReason stop_reason;
+    // Interrupt inputs. IRQ is a wired-OR level: every source holds its own
+    // bit of irq_lines. NMI is an edge, remembered until it is taken.
+    uint8_t irq_lines;
+    bool nmi_pending;
+    bool waiting; // Sleeping in WAI until an interrupt is raised
+    bool brk_stops; // BRK ends the run rather than vectoring through $FFFE
+
+    // Block cache. A block is the run of instructions from its start address
+    // up to the first one other than a conditional branch that may change PC,
+    // or to the end of its page. A taken conditional branch leaves the block
+    // early, so branchy code still runs several instructions per lookup.
+    // Blocks are looked up through a per-page table of start offsets, and
+    // every page a block was decoded from is watched so the first write to
+    // it throws away the blocks that could include it.
+    struct DecodedOp {
+        DecodedFn handler; // Runs the Decoded<Trace> instantiation
+        uint16_t operand; // Operand bytes, little-endian
+        uint16_t next_pc; // Address of the following instruction
+        uint8_t opcode;
+        uint8_t cycles; // Base cycle count from the opcode map
+    };
+    // Successor of a translated block, valid while generation matches
+    struct BlockLink {
+        uint16_t pc;
+        uint32_t generation;
+        const uint8_t* body;
+    };
+    struct Block {
+        std::vector<DecodedOp> ops;
+        uint16_t address;
+        uint32_t runs = 0; // Executions so far, until it is translated
+        void (*native)(CPU65C02*) = nullptr; // Translated code, if any
+        const uint8_t* native_body = nullptr; // Past the prologue, for linked jumps
+        size_t native_ops = 0; // Leading ops translated, up to the first branch
+        BlockLink links[2] = {}; // Branch target and fall-through
+    };
+    struct CodePage {
+        std::unique_ptr<Block> blocks[256]; // By start address low byte
+    };
+    const DecodedFn* decoded_table;
+    std::unique_ptr<CodePage> code_pages[256];
+    bool stale_pages[256]; // Pages whose blocks are dropped at the next safe point
+    bool code_stale;
+    bool running_blocks; // The block or JIT core is running, whatever the engine
+    uint16_t decoded_operand; // Operand of the decoded instruction being run
+    uint32_t code_generation; // Bumped whenever blocks are dropped, to break links
+    std::unique_ptr<Jit> jit; // Created by the first translation
+    uint32_t jit_threshold; // Block runs before translation
+    Block* jit_exit; // Translated block that last returned, if it wants a link
+    TraceRecorder* recorder; // Receives a record per instruction while set
+    Profiler* profiler; // Counts every instruction while set
+
+    // Breakpoints are patched into the block cache, watchpoints into the
+    // page table, so neither is looked up until one is hit
+    struct Watchpoint {
+        uint16_t first, last;
+        bool reads, writes;
+        StopCondition condition;
+    };
+    std::map<uint16_t, StopCondition> breakpoints;
+    std::vector<Watchpoint> watchpoints;
+    WatchHit watch_hit;
+    // PC of the breakpoint the last run stopped on, which the next run
+    // steps over, or NO_BREAKPOINT
+    uint32_t breakpoint_resume;
+    static const uint32_t NO_BREAKPOINT = 0x10000;
+
+    uint8_t fetch_byte() { return memory.fetch(regs.PC++); }
+    uint8_t fetch_byte(uint16_t addr) { return memory.read(addr); }
+    void store_byte(uint16_t addr, uint8_t value) { memory.write(addr, value); }
     uint16_t fetch_word();
+    template <class Trace> uint8_t fetch_operand() {
+        if constexpr (Trace::decoded) {
+            uint8_t value = decoded_operand;
+            decoded_operand >>= 8;
+            return value;
+        } else {
+            return fetch_byte();
+        }
+    }
+    template <class Trace> uint16_t fetch_operand_word() {
+        if constexpr (Trace::decoded) {
+            return decoded_operand;
+        } else {
+            return fetch_word();
+        }
+    }
     void debug_print(const char* message);
-    void update_flags(uint8_t value);
-    void update_NZ_flags(uint8_t value);
-    void input();
+    void update_flags(uint8_t value) { regs.flag_n = value; regs.flag_z = value; }
+    // BIT: N and V from bits 7 and 6 of the operand, Z from A AND operand
+    void bit_test(uint8_t operand) { regs.flag_n = operand; regs.flag_v = operand << 1; regs.flag_z = regs.A & operand; }
+    // 1 when a and b are on different pages; indexed reads and taken
+    // branches cost an extra cycle then. Arithmetic rather than a test, so
+    // the common case has no branch to mispredict.
+    static unsigned page_crossed(uint16_t a, uint16_t b) { return ((a ^ b) >> 8) & 1; }
+    // Bxx other than BRA, and BBR/BBS: the JUMP rows that fall through to
+    // the next instruction when not taken
+    static bool conditional_branch(uint8_t op) { return (op & 0x1F) == 0x10 || (op & 0x0F) == 0x0F; }
+    template <class Trace> CPU65C02_INLINE void branch_if(bool condition, const char* name);
+    CPU65C02_INLINE void add_with_carry(uint8_t operand);
+    CPU65C02_INLINE void subtract_with_borrow(uint8_t operand);
+    template <class Trace> void change_bit(uint8_t mask, bool set, const char* name);
+    template <class Trace> void branch_on_bit(uint8_t mask, bool set, const char* name);
+    template <class Trace> void take_interrupt(uint16_t vector, uint8_t pushed_status);
+    template <class Trace> void enter_interrupt(uint16_t vector);
+    void record_interrupt(uint16_t vector, const Registers& before, unsigned entry_cycles);
+    bool interrupt_ready() const { return nmi_pending || (irq_lines && !(regs.status & 0x04)); }
+    void poll_interrupts();
+    void restore_deadline();
     void print_registers();
     void push(uint8_t value);
     void reset_cycles();
-    
-    // Getters
+    template <OpCodeFn Fn> static void call_decoded(CPU65C02& cpu) { (cpu.*Fn)(); }
+    template <class Trace, bool CountInstructions>
+    StopReason run(uint64_t cycle_deadline, uint64_t instructions);
+    template <class Trace, bool CountInstructions> void run_core(uint64_t& instructions);
+    template <class Trace, bool CountInstructions> void run_table(uint64_t& instructions);
+    template <class Trace, bool CountInstructions> void run_switch(uint64_t& instructions);
+    template <class Trace, bool CountInstructions> void run_threaded(uint64_t& instructions);
+    template <class Trace, bool CountInstructions> void run_block(uint64_t& instructions);
+    template <class Trace, bool CountInstructions> void run_jit(uint64_t& instructions);
+    template <class Trace, bool CountInstructions> void run_instrumented(uint64_t& instructions);
+    template <class Trace, bool CountInstructions>
+    bool run_decoded(const Block* block, uint64_t& instructions);
+    Block* find_block(uint16_t address);
+    Block* build_block(uint16_t address);
+    bool translate(Block& block);
+    void link_block(Block& from, const Block& to);
+    bool resume_after_code_write();
+    void flush_stale_code();
+    void page_written(unsigned page) override;
+    void access_trapped(uint16_t addr, uint8_t value, bool write) override;
+    bool has_breakpoint(uint16_t pc) const { return !breakpoints.empty() && breakpoints.count(pc) != 0; }
+    bool breakpoint_stops();
+    void breakpoint_trap();
+    void next_event_changed(uint64_t time) override;
     uint8_t pull();
-    uint8_t get_P() { return P; }
-    uint8_t get_X() { return X; }
-    uint8_t get_SP() { return S; }
-    uint8_t get_A() { return A; }
-    uint8_t get_Y() { return Y; }
-    uint16_t get_PC() { return PC; }
-    uint8_t get_status() { return status; }
-    uint8_t get_RAM(uint16_t addr) { return RAM[addr]; }
-    uint32_t get_cycles() { return cycles; }
 
 public:
+    // Getters
+    const Registers& get_registers() const { return regs; }
+    uint8_t get_P() { return regs.P(); }
+    uint8_t get_status() { return regs.P(); } // Same as get_P()
+    uint8_t get_X() { return regs.X; }
+    uint8_t get_SP() { return regs.S; }
+    uint8_t get_A() { return regs.A; }
+    uint8_t get_Y() { return regs.Y; }
+    uint16_t get_PC() { return regs.PC; }
+    uint8_t get_RAM(uint16_t addr) { return memory.peek(addr); } // No I/O side effects
+    Memory& get_memory() { return memory; }
+    // Device events fire at the first instruction boundary at or after
+    // their cycle count, before any interrupt they raise is taken. They
+    // are not part of snapshots.
+    Scheduler& get_scheduler() { return scheduler; }
+    uint64_t get_cycles() { return cycles; }
+
+    // Setters, for starting a program from a given register state
+    // Flag bytes are normalised, since a Registers filled in by hand may
+    // hold any value in them and C indexes two-entry tables
+    void set_registers(const Registers& r);
+    void set_A(uint8_t value) { regs.A = value; }
+    void set_X(uint8_t value) { regs.X = value; }
+    void set_Y(uint8_t value) { regs.Y = value; }
+    void set_SP(uint8_t value) { regs.S = value; }
+    void set_P(uint8_t value) { regs.set_P(value); }
+    void set_status(uint8_t value) { regs.set_P(value); } // Same as set_P()
+    void set_PC(uint16_t value) { regs.PC = value; }
+
     CPU65C02(bool debug_mode = false);
-    void reset();
-    void load_program(uint8_t* program, size_t size);
+    ~CPU65C02();
+    void reset(); // Registers to their power-on values, PC from the $FFFC vector
+    void load_program(const uint8_t* program, size_t size, uint16_t address = 0);
+    void load_image(const MemoryImage& image); // Share the image's pages until written
+    Snapshot snapshot();
+    void restore(const Snapshot& snapshot);
     void execute();
 
+    // Bounded runs for callers that time-slice many CPUs. They stop at the
+    // first instruction boundary where the budget is spent, or earlier on
+    // BRK, STP, WAI or request_stop(), and print nothing themselves.
+    // Interrupts raised before or during a run are taken at the next
+    // instruction boundary.
+    StopReason run_cycles(uint64_t n);
+    StopReason run_instructions(uint64_t n);
+    void request_stop(StopReason reason);
+    static const char* stop_reason_name(StopReason reason);
+    static const char* engine_name(Engine e);
+    void set_engine(Engine e);
+    Engine get_engine() const { return engine; }
+    // Runs of a block before the Jit engine translates it; 1 translates
+    // every block the first time it is reached
+    void set_jit_threshold(uint32_t runs) { jit_threshold = runs; }
+
+    // Interrupt inputs, for devices and hosts. Polling them costs nothing
+    // per instruction: raising one that can be taken lowers the run loop's
+    // deadline, and run() takes it once the current instruction is done.
+    // IRQ stays asserted until every source that asserted it releases it.
+    void assert_irq(uint8_t source = 0x01);
+    void release_irq(uint8_t source = 0x01);
+    void nmi();
+    // By default BRK ends the run, which is how test programs finish. With
+    // false it is the 65C02's software interrupt through $FFFE.
+    void set_brk_stops(bool stops) { brk_stops = stops; }
+
+    // Append a TraceRecord to recorder for every instruction executed, or
+    // stop with nullptr. Recording needs the state before each instruction,
+    // so while it is on every engine runs a switch core that captures it.
+    void set_recorder(TraceRecorder* r) { recorder = r; }
+    // Count every instruction executed in profiler, or stop with nullptr.
+    // Runs on the same instrumented core as recording.
+    void set_profiler(Profiler* p) { profiler = p; }
+
+    // Stop before the instruction at pc, if condition (when given) returns
+    // true when it is reached. The next run steps over the breakpoint it
+    // stopped on. Breakpoints replace their instruction's entry in the block
+    // cache, so while there are any the Table, Switch and Threaded engines
+    // run on the Block core; the recording and profiling core checks them
+    // itself. Runs without breakpoints do not look for them.
+    void add_breakpoint(uint16_t pc, StopCondition condition = nullptr);
+    void remove_breakpoint(uint16_t pc);
+    void clear_breakpoints();
+    // Stop after an instruction that reads and/or writes first..last, if
+    // condition (when given) returns true; get_watch_hit() has the access.
+    // Instruction fetches are not reads. Watchpoints trap their pages in the
+    // page table, so only accesses to those pages go the slow way.
+    void add_watchpoint(uint16_t first, uint16_t last, bool reads, bool writes, StopCondition condition = nullptr);
+    void clear_watchpoints();
+    const WatchHit& get_watch_hit() const { return watch_hit; }
+
     // LDA instructions
-    void LDA_ZP();
-    void LDA_ZP_X();
-    void LDA_IMM();
-    void LDA_ABS();
-    void LDA_ABS_Y();
-    void LDA_ABS_X();
-    void LDA_PRE_IND_X();
-    void LDA_POST_IND_Y();
-    void LDA_IND();
+    template <class Trace> void LDA_ZP();
+    template <class Trace> void LDA_ZP_X();
+    template <class Trace> void LDA_IMM();
+    template <class Trace> void LDA_ABS();
+    template <class Trace> void LDA_ABS_Y();
+    template <class Trace> void LDA_ABS_X();
+    template <class Trace> void LDA_PRE_IND_X();
+    template <class Trace> void LDA_POST_IND_Y();
+    template <class Trace> void LDA_IND();
 
     // LDX instructions
-    void LDX_IMM();
-    void LDX_ZP();
-    void LDX_ZP_Y();
-    void LDX_ABS();
-    void LDX_ABS_Y();
+    template <class Trace> void LDX_IMM();
+    template <class Trace> void LDX_ZP();
+    template <class Trace> void LDX_ZP_Y();
+    template <class Trace> void LDX_ABS();
+    template <class Trace> void LDX_ABS_Y();
 
     // LDY instructions
-    void LDY_IMM();
-    void LDY_ZP();
-    void LDY_ZP_X();
-    void LDY_ABS();
-    void LDY_ABS_X();
+    template <class Trace> void LDY_IMM();
+    template <class Trace> void LDY_ZP();
+    template <class Trace> void LDY_ZP_X();
+    template <class Trace> void LDY_ABS();
+    template <class Trace> void LDY_ABS_X();
 
     // STA instructions
-    void STA_ZP();
-    void STA_ZP_X();
-    void STA_ABS();
-    void STA_ABS_X();
-    void STA_ABS_Y();
-    void STA_PRE_IND_X();
-    void STA_POST_IND_Y();
-    void STA_IND();
+    template <class Trace> void STA_ZP();
+    template <class Trace> void STA_ZP_X();
+    template <class Trace> void STA_ABS();
+    template <class Trace> void STA_ABS_X();
+    template <class Trace> void STA_ABS_Y();
+    template <class Trace> void STA_PRE_IND_X();
+    template <class Trace> void STA_POST_IND_Y();
+    template <class Trace> void STA_IND();
 
     // STX instructions
-    void STX_ZP();
-    void STX_ZP_Y();
-    void STX_ABS();
+    template <class Trace> void STX_ZP();
+    template <class Trace> void STX_ZP_Y();
+    template <class Trace> void STX_ABS();
 
     // STY instructions
-    void STY_ZP();
-    void STY_ZP_X();
-    void STY_ABS();
+    template <class Trace> void STY_ZP();
+    template <class Trace> void STY_ZP_X();
+    template <class Trace> void STY_ABS();
 
     // Arithmetic Operations
-    void ADC_IMM();
-    void ADC_ZP();
-    void ADC_ZP_X();
-    void ADC_ABS();
-    void ADC_ABS_X();
-    void ADC_ABS_Y();
-    void ADC_PRE_IND_X();
-    void ADC_POST_IND_Y();
-    void ADC_IND();
-
-    void SBC_IMM();
-    void SBC_ZP();
-    void SBC_ZP_X();
-    void SBC_ABS();
-    void SBC_ABS_X();
-    void SBC_ABS_Y();
-    void SBC_PRE_IND_X();
-    void SBC_POST_IND_Y();
-    void SBC_IND();
-
-    void INC_ZP();
-    void INC_ZP_X();
-    void INC_ABS();
-    void INC_ABS_X();
-
-    void INX();
-    void INY();
-
-    void DEC_ZP();
-    void DEC_ZP_X();
-    void DEC_ABS();
-    void DEC_ABS_X();
-
-    void DEX();
-    void DEY();
+    template <class Trace> void ADC_IMM();
+    template <class Trace> void ADC_ZP();
+    template <class Trace> void ADC_ZP_X();
+    template <class Trace> void ADC_ABS();
+    template <class Trace> void ADC_ABS_X();
+    template <class Trace> void ADC_ABS_Y();
+    template <class Trace> void ADC_PRE_IND_X();
+    template <class Trace> void ADC_POST_IND_Y();
+    template <class Trace> void ADC_IND();
+
+    template <class Trace> void SBC_IMM();
+    template <class Trace> void SBC_ZP();
+    template <class Trace> void SBC_ZP_X();
+    template <class Trace> void SBC_ABS();
+    template <class Trace> void SBC_ABS_X();
+    template <class Trace> void SBC_ABS_Y();
+    template <class Trace> void SBC_PRE_IND_X();
+    template <class Trace> void SBC_POST_IND_Y();
+    template <class Trace> void SBC_IND();
+
+    template <class Trace> void INC_ZP();
+    template <class Trace> void INC_ZP_X();
+    template <class Trace> void INC_ABS();
+    template <class Trace> void INC_ABS_X();
+
+    template <class Trace> void INX();
+    template <class Trace> void INY();
+
+    template <class Trace> void DEC_ZP();
+    template <class Trace> void DEC_ZP_X();
+    template <class Trace> void DEC_ABS();
+    template <class Trace> void DEC_ABS_X();
+
+    template <class Trace> void DEX();
+    template <class Trace> void DEY();
 
     // Logical Operations
-    void AND_IMM();
-    void AND_ZP();
-    void AND_ZP_X();
-    void AND_ABS();
-    void AND_ABS_X();
-    void AND_ABS_Y();
-    void AND_PRE_IND_X();
-    void AND_POST_IND_Y();
-    void AND_IND();
-
-    void ORA_IMM();
-    void ORA_ZP();
-    void ORA_ZP_X();
-    void ORA_ABS();
-    void ORA_ABS_X();
-    void ORA_ABS_Y();
-    void ORA_PRE_IND_X();
-    void ORA_POST_IND_Y();
-    void ORA_IND();
-
-    void EOR_IMM();
-    void EOR_ZP();
-    void EOR_ZP_X();
-    void EOR_ABS();
-    void EOR_ABS_X();
-    void EOR_ABS_Y();
-    void EOR_PRE_IND_X();
-    void EOR_POST_IND_Y();
-    void EOR_IND();
-
-    void ASL_ACC();
-    void ASL_ZP();
-    void ASL_ZP_X();
-    void ASL_ABS();
-    void ASL_ABS_X();
-
-    void LSR_ACC();
-    void LSR_ZP();
-    void LSR_ZP_X();
-    void LSR_ABS();
-    void LSR_ABS_X();
-
-    void ROL_ACC();
-    void ROL_ZP();
-    void ROL_ZP_X();
-    void ROL_ABS();
-    void ROL_ABS_X();
-
-    void ROR_ACC();
-    void ROR_ZP();
-    void ROR_ZP_X();
-    void ROR_ABS();
-    void ROR_ABS_X();
+    template <class Trace> void AND_IMM();
+    template <class Trace> void AND_ZP();
+    template <class Trace> void AND_ZP_X();
+    template <class Trace> void AND_ABS();
+    template <class Trace> void AND_ABS_X();
+    template <class Trace> void AND_ABS_Y();
+    template <class Trace> void AND_PRE_IND_X();
+    template <class Trace> void AND_POST_IND_Y();
+    template <class Trace> void AND_IND();
+
+    template <class Trace> void ORA_IMM();
+    template <class Trace> void ORA_ZP();
+    template <class Trace> void ORA_ZP_X();
+    template <class Trace> void ORA_ABS();
+    template <class Trace> void ORA_ABS_X();
+    template <class Trace> void ORA_ABS_Y();
+    template <class Trace> void ORA_PRE_IND_X();
+    template <class Trace> void ORA_POST_IND_Y();
+    template <class Trace> void ORA_IND();
+
+    template <class Trace> void EOR_IMM();
+    template <class Trace> void EOR_ZP();
+    template <class Trace> void EOR_ZP_X();
+    template <class Trace> void EOR_ABS();
+    template <class Trace> void EOR_ABS_X();
+    template <class Trace> void EOR_ABS_Y();
+    template <class Trace> void EOR_PRE_IND_X();
+    template <class Trace> void EOR_POST_IND_Y();
+    template <class Trace> void EOR_IND();
+
+    template <class Trace> void ASL_ACC();
+    template <class Trace> void ASL_ZP();
+    template <class Trace> void ASL_ZP_X();
+    template <class Trace> void ASL_ABS();
+    template <class Trace> void ASL_ABS_X();
+
+    template <class Trace> void LSR_ACC();
+    template <class Trace> void LSR_ZP();
+    template <class Trace> void LSR_ZP_X();
+    template <class Trace> void LSR_ABS();
+    template <class Trace> void LSR_ABS_X();
+
+    template <class Trace> void ROL_ACC();
+    template <class Trace> void ROL_ZP();
+    template <class Trace> void ROL_ZP_X();
+    template <class Trace> void ROL_ABS();
+    template <class Trace> void ROL_ABS_X();
+
+    template <class Trace> void ROR_ACC();
+    template <class Trace> void ROR_ZP();
+    template <class Trace> void ROR_ZP_X();
+    template <class Trace> void ROR_ABS();
+    template <class Trace> void ROR_ABS_X();
+
+    template <class Trace> void INC_ACC();
+    template <class Trace> void DEC_ACC();
+
+    template <class Trace> void BIT_IMM();
+    template <class Trace> void BIT_ZP();
+    template <class Trace> void BIT_ZP_X();
+    template <class Trace> void BIT_ABS();
+    template <class Trace> void BIT_ABS_X();
+
+    // Register transfers
+    template <class Trace> void TAX();
+    template <class Trace> void TAY();
+    template <class Trace> void TXA();
+    template <class Trace> void TYA();
+
+    // Jumps and subroutines
+    template <class Trace> void JMP_ABS();
+    template <class Trace> void JMP_ABS_IND();
+    template <class Trace> void JMP_ABS_IND_X();
+    template <class Trace> void JSR_ABS();
+    template <class Trace> void RTS();
+    template <class Trace> void RTI();
 
     // Other instructions
-    void JMP();
-    void BRK();
-    void NOP();
-    void RTI();
+    template <class Trace> void BRK();
+    template <class Trace> void STP();     // Stop the processor
+    template <class Trace> void WAI();     // Wait for interrupt
+    template <class Trace> void NOP();
+    // The NOPs the 65C02 executes for unassigned opcodes, which skip their
+    // operand bytes without touching memory
+    template <class Trace> void NOP_IMM();
+    template <class Trace> void NOP_ZP();
+    template <class Trace> void NOP_ZP_X();
+    template <class Trace> void NOP_ABS();
 
     // Stack Operations
-    void PHA();  // Push Accumulator
-    void PHP();  // Push Processor Status
-    void PLA();  // Pull Accumulator
-    void PLP();  // Pull Processor Status
-    void TSX();  // Transfer Stack Pointer to X
-    void TXS();  // Transfer X to Stack Pointer
+    template <class Trace> void PHA();  // Push Accumulator
+    template <class Trace> void PHP();  // Push Processor Status
+    template <class Trace> void PLA();  // Pull Accumulator
+    template <class Trace> void PLP();  // Pull Processor Status
+    template <class Trace> void TSX();  // Transfer Stack Pointer to X
+    template <class Trace> void TXS();  // Transfer X to Stack Pointer
 
     // Branch Instructions
-    void BCC();  // Branch if Carry Clear
-    void BCS();  // Branch if Carry Set
-    void BEQ();  // Branch if Equal
-    void BNE();  // Branch if Not Equal
-    void BMI();  // Branch if Minus
-    void BPL();  // Branch if Plus
-    void BVC();  // Branch if Overflow Clear
-    void BVS();  // Branch if Overflow Set
+    template <class Trace> void BCC();  // Branch if Carry Clear
+    template <class Trace> void BCS();  // Branch if Carry Set
+    template <class Trace> void BEQ();  // Branch if Equal
+    template <class Trace> void BNE();  // Branch if Not Equal
+    template <class Trace> void BMI();  // Branch if Minus
+    template <class Trace> void BPL();  // Branch if Plus
+    template <class Trace> void BVC();  // Branch if Overflow Clear
+    template <class Trace> void BVS();  // Branch if Overflow Set
 
     // Status Flag Operations
-    void CLC();  // Clear Carry Flag
-    void SEC();  // Set Carry Flag
-    void CLD();  // Clear Decimal Mode
-    void SED();  // Set Decimal Mode
-    void CLI();  // Clear Interrupt Disable
-    void SEI();  // Set Interrupt Disable
-    void CLV();  // Clear Overflow Flag
+    template <class Trace> void CLC();  // Clear Carry Flag
+    template <class Trace> void SEC();  // Set Carry Flag
+    template <class Trace> void CLD();  // Clear Decimal Mode
+    template <class Trace> void SED();  // Set Decimal Mode
+    template <class Trace> void CLI();  // Clear Interrupt Disable
+    template <class Trace> void SEI();  // Set Interrupt Disable
+    template <class Trace> void CLV();  // Clear Overflow Flag
 
     // Comparison Operations
-    void CMP_IMM();  // Compare with Accumulator (Immediate)
-    void CMP_ZP();   // Compare with Accumulator (Zero Page)
-    void CMP_ZP_X(); // Compare with Accumulator (Zero Page, X)
-    void CMP_ABS();  // Compare with Accumulator (Absolute)
-    void CMP_ABS_X(); // Compare with Accumulator (Absolute, X)
-    void CMP_ABS_Y(); // Compare with Accumulator (Absolute, Y)
-    void CMP_PRE_IND_X(); // Compare with Accumulator (Indirect, X)
-    void CMP_POST_IND_Y(); // Compare with Accumulator (Indirect, Y)
-    void CMP_IND();  // Compare with Accumulator (Indirect)
-
-    void CPX_IMM();  // Compare with X Register (Immediate)
-    void CPX_ZP();   // Compare with X Register (Zero Page)
-    void CPX_ABS();  // Compare with X Register (Absolute)
-
-    void CPY_IMM();  // Compare with Y Register (Immediate)
-    void CPY_ZP();   // Compare with Y Register (Zero Page)
-    void CPY_ABS();  // Compare with Y Register (Absolute)
+    template <class Trace> void CMP_IMM();  // Compare with Accumulator (Immediate)
+    template <class Trace> void CMP_ZP();   // Compare with Accumulator (Zero Page)
+    template <class Trace> void CMP_ZP_X(); // Compare with Accumulator (Zero Page, X)
+    template <class Trace> void CMP_ABS();  // Compare with Accumulator (Absolute)
+    template <class Trace> void CMP_ABS_X(); // Compare with Accumulator (Absolute, X)
+    template <class Trace> void CMP_ABS_Y(); // Compare with Accumulator (Absolute, Y)
+    template <class Trace> void CMP_PRE_IND_X(); // Compare with Accumulator (Indirect, X)
+    template <class Trace> void CMP_POST_IND_Y(); // Compare with Accumulator (Indirect, Y)
+    template <class Trace> void CMP_IND();  // Compare with Accumulator (Indirect)
+
+    template <class Trace> void CPX_IMM();  // Compare with X Register (Immediate)
+    template <class Trace> void CPX_ZP();   // Compare with X Register (Zero Page)
+    template <class Trace> void CPX_ABS();  // Compare with X Register (Absolute)
+
+    template <class Trace> void CPY_IMM();  // Compare with Y Register (Immediate)
+    template <class Trace> void CPY_ZP();   // Compare with Y Register (Zero Page)
+    template <class Trace> void CPY_ABS();  // Compare with Y Register (Absolute)
 
     // Additional 65C02-specific instructions
-    void BRA();      // Branch Always
-    void PHX();      // Push X Register
-    void PHY();      // Push Y Register
-    void PLX();      // Pull X Register
-    void PLY();      // Pull Y Register
-    void STZ_ZP();   // Store Zero (Zero Page)
-    void STZ_ZP_X(); // Store Zero (Zero Page, X)
-    void STZ_ABS();  // Store Zero (Absolute)
-    void STZ_ABS_X(); // Store Zero (Absolute, X)
-    void TRB_ZP();   // Test and Reset Bits (Zero Page)
-    void TRB_ABS();  // Test and Reset Bits (Absolute)
-    void TSB_ZP();   // Test and Set Bits (Zero Page)
-    void TSB_ABS();  // Test and Set Bits (Absolute)
-
+    template <class Trace> void BRA();      // Branch Always
+    template <class Trace> void PHX();      // Push X Register
+    template <class Trace> void PHY();      // Push Y Register
+    template <class Trace> void PLX();      // Pull X Register
+    template <class Trace> void PLY();      // Pull Y Register
+    template <class Trace> void STZ_ZP();   // Store Zero (Zero Page)
+    template <class Trace> void STZ_ZP_X(); // Store Zero (Zero Page, X)
+    template <class Trace> void STZ_ABS();  // Store Zero (Absolute)
+    template <class Trace> void STZ_ABS_X(); // Store Zero (Absolute, X)
+    template <class Trace> void TRB_ZP();   // Test and Reset Bits (Zero Page)
+    template <class Trace> void TRB_ABS();  // Test and Reset Bits (Absolute)
+    template <class Trace> void TSB_ZP();   // Test and Set Bits (Zero Page)
+    template <class Trace> void TSB_ABS();  // Test and Set Bits (Absolute)
+
+    // Rockwell/WDC bit instructions: reset or set bit n of a zero page byte,
+    // and branch if bit n of a zero page byte is reset or set
+    template <class Trace> void RMB0_ZP();
+    template <class Trace> void RMB1_ZP();
+    template <class Trace> void RMB2_ZP();
+    template <class Trace> void RMB3_ZP();
+    template <class Trace> void RMB4_ZP();
+    template <class Trace> void RMB5_ZP();
+    template <class Trace> void RMB6_ZP();
+    template <class Trace> void RMB7_ZP();
+
+    template <class Trace> void SMB0_ZP();
+    template <class Trace> void SMB1_ZP();
+    template <class Trace> void SMB2_ZP();
+    template <class Trace> void SMB3_ZP();
+    template <class Trace> void SMB4_ZP();
+    template <class Trace> void SMB5_ZP();
+    template <class Trace> void SMB6_ZP();
+    template <class Trace> void SMB7_ZP();
+
+    template <class Trace> void BBR0_ZP_REL();
+    template <class Trace> void BBR1_ZP_REL();
+    template <class Trace> void BBR2_ZP_REL();
+    template <class Trace> void BBR3_ZP_REL();
+    template <class Trace> void BBR4_ZP_REL();
+    template <class Trace> void BBR5_ZP_REL();
+    template <class Trace> void BBR6_ZP_REL();
+    template <class Trace> void BBR7_ZP_REL();
+
+    template <class Trace> void BBS0_ZP_REL();
+    template <class Trace> void BBS1_ZP_REL();
+    template <class Trace> void BBS2_ZP_REL();
+    template <class Trace> void BBS3_ZP_REL();
+    template <class Trace> void BBS4_ZP_REL();
+    template <class Trace> void BBS5_ZP_REL();
+    template <class Trace> void BBS6_ZP_REL();
+    template <class Trace> void BBS7_ZP_REL();
 };
 
 #endif // CPU65C02_H 
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "Disassembler.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+// Handler names from the opcode map, e.g. "LDA_ABS_X" or "BBR3_ZP_REL";
+// the part after the first underscore names the addressing mode
+const char* const handler_names[256] = {
+    #define OPCODE(op, fn, bytes, cycles) #fn,
+    #include "CPU65C02_opcodes.def"
+};
+
+const uint8_t lengths[256] = {
+    #define OPCODE(op, fn, bytes, cycles) bytes,
+    #include "CPU65C02_opcodes.def"
+};
+
+const bool jumps[256] = {
+    #define OPCODE(op, fn, bytes, cycles) false,
+    #define JUMP(op, fn, bytes, cycles) true,
+    #include "CPU65C02_opcodes.def"
+};
+
+} // namespace
+
+const char* opcode_handler_name(uint8_t opcode) {
+    return handler_names[opcode];
+}
+
+const char* opcode_mode(uint8_t opcode) {
+    const char* suffix = strchr(handler_names[opcode], '_');
+    if (suffix) {
+        return suffix + 1;
+    }
+    return jumps[opcode] && lengths[opcode] == 2 ? "RELATIVE" : "IMPLIED";
+}
+
+const char* opcode_mnemonic(uint8_t opcode) {
+    struct Mnemonics {
+        char text[256][5] = {};
+        Mnemonics() {
+            for (unsigned op = 0; op < 256; op++) {
+                memcpy(text[op], handler_names[op], strcspn(handler_names[op], "_"));
+            }
+        }
+    };
+    static const Mnemonics mnemonics;
+    return mnemonics.text[opcode];
+}
+
+unsigned opcode_length(uint8_t opcode) {
+    return lengths[opcode];
+}
+
+string disassemble(uint16_t pc, uint8_t opcode, uint8_t lo, uint8_t hi) {
+    const char* name = handler_names[opcode];
+    int len = (int)strcspn(name, "_");
+    const char* mode = name[len] == '_' ? name + len + 1 : "";
+    unsigned word = lo | (hi << 8);
+    char text[32];
+    if (strcmp(mode, "IMM") == 0) {
+        snprintf(text, sizeof(text), "%.*s #$%02X", len, name, lo);
+    } else if (strcmp(mode, "ZP") == 0) {
+        snprintf(text, sizeof(text), "%.*s $%02X", len, name, lo);
+    } else if (strcmp(mode, "ZP_X") == 0) {
+        snprintf(text, sizeof(text), "%.*s $%02X,X", len, name, lo);
+    } else if (strcmp(mode, "ZP_Y") == 0) {
+        snprintf(text, sizeof(text), "%.*s $%02X,Y", len, name, lo);
+    } else if (strcmp(mode, "ZP_REL") == 0) {
+        // BBRn/BBSn: zero page byte, then a branch from the next instruction
+        snprintf(text, sizeof(text), "%.*s $%02X,$%04X", len, name, lo, (uint16_t)(pc + 3 + (int8_t)hi));
+    } else if (strcmp(mode, "ABS") == 0) {
+        snprintf(text, sizeof(text), "%.*s $%04X", len, name, word);
+    } else if (strcmp(mode, "ABS_X") == 0) {
+        snprintf(text, sizeof(text), "%.*s $%04X,X", len, name, word);
+    } else if (strcmp(mode, "ABS_Y") == 0) {
+        snprintf(text, sizeof(text), "%.*s $%04X,Y", len, name, word);
+    } else if (strcmp(mode, "ABS_IND") == 0) {
+        snprintf(text, sizeof(text), "%.*s ($%04X)", len, name, word);
+    } else if (strcmp(mode, "ABS_IND_X") == 0) {
+        snprintf(text, sizeof(text), "%.*s ($%04X,X)", len, name, word);
+    } else if (strcmp(mode, "PRE_IND_X") == 0) {
+        snprintf(text, sizeof(text), "%.*s ($%02X,X)", len, name, lo);
+    } else if (strcmp(mode, "POST_IND_Y") == 0) {
+        snprintf(text, sizeof(text), "%.*s ($%02X),Y", len, name, lo);
+    } else if (strcmp(mode, "IND") == 0) {
+        snprintf(text, sizeof(text), "%.*s ($%02X)", len, name, lo);
+    } else if (strcmp(mode, "ACC") == 0) {
+        snprintf(text, sizeof(text), "%.*s A", len, name);
+    } else if (jumps[opcode] && lengths[opcode] == 2) {
+        // Relative branch: the target counts from the next instruction
+        snprintf(text, sizeof(text), "%.*s $%04X", len, name, (uint16_t)(pc + 2 + (int8_t)lo));
+    } else {
+        snprintf(text, sizeof(text), "%.*s", len, name);
+    }
+    return text;
+}
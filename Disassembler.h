@@ -0,0 +1,28 @@
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include <cstdint>
+#include <string>
+
+// Handler name of an opcode in the opcode map, e.g. "LDA_ABS_X" or
+// "BBR3_ZP_REL"; the part after the first underscore names the addressing
+// mode
+const char* opcode_handler_name(uint8_t opcode);
+
+// Mnemonic of an opcode, e.g. "LDA" or "BBR3"
+const char* opcode_mnemonic(uint8_t opcode);
+
+// Addressing mode of an opcode as the opcode map names it, e.g. "ABS_X" or
+// "ZP_REL", or "RELATIVE" for branches and "IMPLIED" for the rest
+const char* opcode_mode(uint8_t opcode);
+
+// Length in bytes of the instruction starting with opcode
+unsigned opcode_length(uint8_t opcode);
+
+// One instruction as assembly, e.g. "LDA $02F0,X" or "BNE $0211". lo and
+// hi are the bytes after the opcode; pc is where the opcode is, for branch
+// targets. Both are read from the opcode map, so this always agrees with
+// what the CPU executes.
+std::string disassemble(uint16_t pc, uint8_t opcode, uint8_t lo, uint8_t hi);
+
+#endif // DISASSEMBLER_H
@@ -0,0 +1,235 @@
+#include "Fuzzer.h"
+#include "Disassembler.h"
+#include "ReferenceModel.h"
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// SplitMix64: every output is a full 64-bit mix of the counter, so nearby
+// seeds and case numbers still give unrelated streams
+struct Random {
+    uint64_t state;
+    explicit Random(uint64_t seed) : state(seed) {}
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    void fill(uint8_t* bytes, size_t size) {
+        for (size_t i = 0; i < size; i += 8) {
+            uint64_t word = next();
+            for (size_t j = i; j < size && j < i + 8; j++, word >>= 8) {
+                bytes[j] = word;
+            }
+        }
+    }
+};
+
+const size_t CASES_PER_GRAB = 256;
+
+// Flags the CPU and the model both keep; B and bit 5 only exist on the stack
+const uint8_t P_MASK = 0xCF;
+
+template <class T>
+void differ(ostringstream& what, const char* name, T cpu, T model, int width) {
+    if (cpu != model) {
+        what << (what.tellp() > 0 ? ", " : "") << name << " $" << hex << setfill('0') << setw(width)
+             << (uint64_t)cpu << " (model $" << setw(width) << (uint64_t)model << ")" << dec;
+    }
+}
+
+} // namespace
+
+struct Fuzzer::Worker {
+    vector<unique_ptr<CPU65C02>> cpus; // One per engine in options.engines
+    vector<CPU65C02::Snapshot> starts;
+    unique_ptr<ReferenceModel> model;
+    uint64_t instructions = 0;
+
+    Worker(const Fuzzer& fuzzer) : model(new ReferenceModel) {
+        for (CPU65C02::Engine engine : fuzzer.options.engines) {
+            cpus.emplace_back(new CPU65C02(false));
+            cpus.back()->set_engine(engine);
+            cpus.back()->set_jit_threshold(1);  // A case's code runs once
+            cpus.back()->load_image(*fuzzer.image);
+            starts.push_back(cpus.back()->snapshot());
+        }
+        model->set_memory(fuzzer.memory.data());
+    }
+
+    // Run c on the model and then every CPU, and compare. Odd cases give the
+    // CPUs the cycles the model took instead of its instruction count, so
+    // Jit runs them as translated code.
+    void run(const FuzzCase& c, uint64_t index, unsigned budget, vector<FuzzFailure>& failures) {
+        model->state = ReferenceModel::State{ c.pc, c.a, c.x, c.y, c.s, (uint8_t)(c.p | 0x30), 0 };
+        model->load(c.code, sizeof(c.code), c.pc);
+        model->load(c.zero_page, sizeof(c.zero_page), c.zero_page_address);
+        CPU65C02::StopReason model_stop = CPU65C02::StopReason::Budget;
+        for (unsigned i = 0; i < budget && model_stop == CPU65C02::StopReason::Budget; i++) {
+            model_stop = model->step();
+            instructions += model_stop == CPU65C02::StopReason::Budget;
+        }
+        const ReferenceModel::State& m = model->state;
+
+        for (size_t e = 0; e < cpus.size(); e++) {
+            CPU65C02& cpu = *cpus[e];
+            cpu.restore(starts[e]);
+            cpu.load_program(c.code, sizeof(c.code), c.pc);
+            cpu.load_program(c.zero_page, sizeof(c.zero_page), c.zero_page_address);
+            CPU65C02::Registers regs = {};
+            regs.PC = c.pc;
+            regs.A = c.a;
+            regs.X = c.x;
+            regs.Y = c.y;
+            regs.S = c.s;
+            regs.set_P(c.p);
+            cpu.set_registers(regs);
+            CPU65C02::StopReason stop;
+            if (index & 1) {
+                // One cycle more lets a CPU reach the BRK, STP or WAI the model stopped at
+                stop = cpu.run_cycles(m.cycles + (model_stop != CPU65C02::StopReason::Budget));
+            } else {
+                stop = cpu.run_instructions(budget);
+            }
+
+            ostringstream what;
+            if (stop != model_stop) {
+                what << "stop " << CPU65C02::stop_reason_name(stop) << " (model "
+                     << CPU65C02::stop_reason_name(model_stop) << ")";
+            }
+            const CPU65C02::Registers& r = cpu.get_registers();
+            differ(what, "pc", r.PC, m.pc, 4);
+            differ(what, "a", r.A, m.a, 2);
+            differ(what, "x", r.X, m.x, 2);
+            differ(what, "y", r.Y, m.y, 2);
+            differ(what, "s", r.S, m.s, 2);
+            differ<int>(what, "p", r.P() & P_MASK, m.p & P_MASK, 2);
+            if (cpu.get_cycles() != m.cycles) {
+                what << (what.tellp() > 0 ? ", " : "") << "cycles " << cpu.get_cycles() << " (model " << m.cycles
+                     << ")";
+            }
+            // Every page the CPU wrote, and every byte the model did
+            Memory& memory = cpu.get_memory();
+            uint32_t wrong = UINT32_MAX;
+            for (unsigned i = 0; i < memory.written_page_count(); i++) {
+                unsigned page = memory.written_page(i) << 8;
+                for (unsigned address = page; address < page + Memory::PAGE_SIZE; address++) {
+                    if (memory.peek(address) != model->peek(address)) {
+                        wrong = min<uint32_t>(wrong, address);
+                        break;
+                    }
+                }
+            }
+            model->for_each_written([&](uint16_t address) {
+                if (memory.peek(address) != model->peek(address)) {
+                    wrong = min<uint32_t>(wrong, address);
+                }
+            });
+            if (wrong != UINT32_MAX) {
+                what << (what.tellp() > 0 ? ", " : "") << hex << setfill('0') << "memory $" << setw(4) << wrong
+                     << " $" << setw(2) << (int)memory.peek(wrong) << " (model $" << setw(2)
+                     << (int)model->peek(wrong) << ")" << dec;
+            }
+            if (what.tellp() > 0) {
+                failures.push_back(FuzzFailure{ index, cpu.get_engine(), what.str() });
+            }
+        }
+        model->rollback();
+    }
+};
+
+Fuzzer::Fuzzer(const FuzzOptions& options) : options(options), memory(0x10000) {
+    Random random(options.seed);
+    random.fill(memory.data(), memory.size());
+    image.reset(new MemoryImage(memory.data(), memory.size(), 0));
+    if (this->options.threads == 0) {
+        this->options.threads = max(1u, thread::hardware_concurrency());
+    }
+}
+
+Fuzzer::~Fuzzer() {}
+
+FuzzCase Fuzzer::make_case(uint64_t index) const {
+    Random random(options.seed ^ (index * 0xD1B54A32D192ED03ull) ^ 0x5DEECE66Dull);
+    FuzzCase c;
+    uint64_t word = random.next();
+    c.pc = word % (0x10000 - sizeof(c.code));
+    c.a = word >> 16;
+    c.x = word >> 24;
+    c.y = word >> 32;
+    c.s = word >> 40;
+    c.p = word >> 48;
+    c.zero_page_address = (word >> 56) % (0x100 - sizeof(c.zero_page));
+    random.fill(c.code, sizeof(c.code));
+    random.fill(c.zero_page, sizeof(c.zero_page));
+    return c;
+}
+
+void Fuzzer::print_case(uint64_t index, ostream& out) const {
+    FuzzCase c = make_case(index);
+    out << "case " << index << " (seed " << options.seed << ")" << hex << setfill('0') << ": pc=$" << setw(4)
+        << c.pc << " a=$" << setw(2) << (int)c.a << " x=$" << setw(2) << (int)c.x << " y=$" << setw(2)
+        << (int)c.y << " s=$" << setw(2) << (int)c.s << " p=$" << setw(2) << (int)c.p << endl;
+    for (unsigned i = 0; i < sizeof(c.code);) {
+        uint8_t lo = i + 1 < sizeof(c.code) ? c.code[i + 1] : memory[(uint16_t)(c.pc + i + 1)];
+        uint8_t hi = i + 2 < sizeof(c.code) ? c.code[i + 2] : memory[(uint16_t)(c.pc + i + 2)];
+        out << "  $" << setw(4) << c.pc + i << "  " << disassemble(c.pc + i, c.code[i], lo, hi) << endl;
+        i += opcode_length(c.code[i]);
+    }
+    out << dec << setfill(' ');
+}
+
+vector<FuzzFailure> Fuzzer::run_case(uint64_t index) {
+    Worker worker(*this);
+    vector<FuzzFailure> failures;
+    worker.run(make_case(index), index, options.instructions, failures);
+    return failures;
+}
+
+FuzzReport Fuzzer::run() {
+    FuzzReport report;
+    atomic<uint64_t> next(0);
+    atomic<size_t> failed(0);
+    mutex lock;
+    vector<thread> pool;
+    for (unsigned t = 0; t < options.threads; t++) {
+        pool.emplace_back([&]() {
+            Worker worker(*this);
+            vector<FuzzFailure> failures;
+            uint64_t cases = 0;
+            while (failed < options.max_failures) {
+                uint64_t first = next.fetch_add(CASES_PER_GRAB);
+                if (first >= options.cases) {
+                    break;
+                }
+                uint64_t last = min<uint64_t>(first + CASES_PER_GRAB, options.cases);
+                for (uint64_t index = first; index < last; index++) {
+                    size_t before = failures.size();
+                    worker.run(make_case(index), index, options.instructions, failures);
+                    if (failures.size() != before) {
+                        failed++;
+                    }
+                }
+                cases += last - first;
+            }
+            lock_guard<mutex> guard(lock);
+            report.cases += cases;
+            report.instructions += worker.instructions;
+            report.failures.insert(report.failures.end(), failures.begin(), failures.end());
+        });
+    }
+    for (thread& t : pool) {
+        t.join();
+    }
+    stable_sort(report.failures.begin(), report.failures.end(),
+                [](const FuzzFailure& a, const FuzzFailure& b) { return a.index < b.index; });
+    return report;
+}
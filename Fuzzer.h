@@ -0,0 +1,77 @@
+#ifndef FUZZER_H
+#define FUZZER_H
+
+#include "CPU65C02.h"
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct FuzzOptions {
+    uint64_t cases = 1000000;
+    uint64_t seed = 1;
+    unsigned threads = 0;        // 0: one per hardware thread
+    unsigned instructions = 16;  // Budget of each case
+    std::vector<CPU65C02::Engine> engines = {
+        CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+        CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+    };
+    size_t max_failures = 10;    // Stop once this many cases have failed
+};
+
+// A starting state, derived from the seed and the case number alone so any
+// case can be rerun by its number. Everything else in memory is the
+// seed's random image, shared by every case.
+struct FuzzCase {
+    uint16_t pc;
+    uint8_t a, x, y, s, p;
+    uint8_t code[16];      // At pc
+    uint8_t zero_page[16]; // At zero_page_address, for pointers
+    uint8_t zero_page_address;
+};
+
+struct FuzzFailure {
+    uint64_t index;
+    CPU65C02::Engine engine;
+    std::string what; // Each field that differs, CPU value then model value
+};
+
+struct FuzzReport {
+    uint64_t cases = 0;        // Run on every engine
+    uint64_t instructions = 0; // Executed by the model over all cases
+    std::vector<FuzzFailure> failures; // By case number
+};
+
+// Runs random instruction streams from random states on every engine and
+// checks each against ReferenceModel. Each thread owns a CPU per engine
+// and a model, and resets them between cases by restoring a snapshot and
+// rolling back the model's journal, so a case costs the pages and bytes it
+// touched rather than a fresh 64KB.
+//
+// Even cases run with an instruction budget, which keeps Jit on its decoded
+// handlers. Odd ones run for the cycles the model took, with Jit translating
+// every block on first sight, so its native code is checked too.
+class Fuzzer {
+public:
+    explicit Fuzzer(const FuzzOptions& options);
+    ~Fuzzer();
+
+    FuzzReport run();
+
+    // Run one case on a single thread, for reproducing a failure
+    std::vector<FuzzFailure> run_case(uint64_t index);
+
+    FuzzCase make_case(uint64_t index) const;
+    // The case's registers and code, disassembled
+    void print_case(uint64_t index, std::ostream& out) const;
+
+private:
+    struct Worker;
+
+    FuzzOptions options;
+    std::vector<uint8_t> memory; // The seed's random 64KB
+    std::unique_ptr<MemoryImage> image;
+};
+
+#endif // FUZZER_H
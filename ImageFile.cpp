@@ -0,0 +1,230 @@
+#include "ImageFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define IMAGE_FILE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define IMAGE_FILE_MMAP 0
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile(const string& path) : bytes(nullptr), length(0) {
+#if IMAGE_FILE_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("cannot open image " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw runtime_error("cannot stat image " + path);
+    }
+    length = info.st_size;
+    if (length > 0) {
+        void* map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("cannot map image " + path);
+        }
+        bytes = static_cast<const uint8_t*>(map);
+    }
+    close(fd);  // The mapping keeps the file open
+#else
+    ifstream file(path, ios::binary);
+    if (!file) {
+        throw runtime_error("cannot open image " + path);
+    }
+    copy.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    bytes = copy.data();
+    length = copy.size();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if IMAGE_FILE_MMAP
+    if (bytes) {
+        munmap(const_cast<uint8_t*>(bytes), length);
+    }
+#endif
+}
+
+ImageFormat image_format_for(const string& path) {
+    size_t dot = path.rfind('.');
+    string extension = dot == string::npos ? "" : path.substr(dot + 1);
+    transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (extension == "hex" || extension == "ihx") {
+        return ImageFormat::IntelHex;
+    }
+    if (extension == "nes") {
+        return ImageFormat::INes;
+    }
+    return ImageFormat::Raw;
+}
+
+namespace {
+
+// Copy size bytes to address, widening info's range to cover them
+void place(CPU65C02& cpu, ImageInfo& info, bool& any, const uint8_t* data, size_t size,
+           uint32_t address, const string& path) {
+    if (size == 0) {
+        return;
+    }
+    if (address + size > 0x10000) {
+        throw runtime_error("image " + path + " does not fit below $10000");
+    }
+    cpu.load_program(data, size, address);
+    uint16_t last = address + size - 1;
+    info.first = any ? min<uint16_t>(info.first, address) : address;
+    info.last = any ? max(info.last, last) : last;
+    any = true;
+}
+
+int hex_digit(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Records are parsed straight out of the mapped file:
+// :LLAAAATT<LL data bytes>CC, where CC makes all the bytes sum to zero
+ImageInfo load_intel_hex(CPU65C02& cpu, const MappedFile& file, const string& path) {
+    ImageInfo info;
+    bool any = false;
+    uint32_t base = 0;  // From extended segment/linear address records
+    const uint8_t* p = file.data();
+    const uint8_t* end = p + file.size();
+    for (int line = 1; p < end; line++) {
+        const uint8_t* eol = static_cast<const uint8_t*>(memchr(p, '\n', end - p));
+        if (!eol) {
+            eol = end;
+        }
+        const uint8_t* text = p;
+        const uint8_t* text_end = eol > p && eol[-1] == '\r' ? eol - 1 : eol;
+        p = eol + (eol < end);
+        if (text == text_end) {
+            continue;
+        }
+        auto bad = [&](const char* why) {
+            return runtime_error(path + " line " + to_string(line) + ": " + why);
+        };
+        if (*text != ':' || (text_end - text) % 2 != 1 || text_end - text < 11) {
+            throw bad("not an Intel HEX record");
+        }
+        uint8_t record[256 + 5];
+        size_t count = (text_end - text) / 2;
+        if (count > sizeof(record)) {
+            throw bad("record too long");
+        }
+        uint8_t sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            int high = hex_digit(text[1 + 2 * i]), low = hex_digit(text[2 + 2 * i]);
+            if (high < 0 || low < 0) {
+                throw bad("bad hex digit");
+            }
+            record[i] = high << 4 | low;
+            sum += record[i];
+        }
+        if (sum != 0) {
+            throw bad("checksum mismatch");
+        }
+        size_t size = record[0];
+        if (count != size + 5) {
+            throw bad("length does not match the record");
+        }
+        uint16_t offset = record[1] << 8 | record[2];
+        const uint8_t* data = record + 4;
+        uint32_t value = 0;
+        for (size_t i = 0; i < size && i < 4; i++) {
+            value = value << 8 | data[i];
+        }
+        switch (record[3]) {
+        case 0x00:  // Data
+            place(cpu, info, any, data, size, base + offset, path);
+            break;
+        case 0x01:  // End of file
+            return info;
+        case 0x02:  // Extended segment address
+            base = value << 4;
+            break;
+        case 0x03:  // Start segment address, CS:IP
+            value = ((value >> 16) << 4) + (value & 0xFFFF);
+            // Fall through
+        case 0x05:  // Start linear address
+            if (value > 0xFFFF) {
+                throw bad("start address above $FFFF");
+            }
+            info.has_entry = true;
+            info.entry = value;
+            break;
+        case 0x04:  // Extended linear address
+            base = value << 16;
+            break;
+        default:
+            throw bad("unknown record type");
+        }
+    }
+    return info;
+}
+
+// iNES header: "NES\x1A", PRG ROM size in 16KB units, CHR ROM size in 8KB
+// units, flags. Only mapper-less cartridges fit the 6502's address space:
+// PRG ROM goes at $8000 and a single 16KB bank is mirrored at $C000, as on
+// NROM boards. A 512-byte trainer, if present, goes at $7000.
+ImageInfo load_ines(CPU65C02& cpu, const MappedFile& file, const string& path) {
+    const uint8_t* header = file.data();
+    if (file.size() < 16 || memcmp(header, "NES\x1A", 4) != 0) {
+        throw runtime_error(path + " is not an iNES image");
+    }
+    size_t prg_size = header[4] * 0x4000;
+    bool trainer = header[6] & 0x04;
+    size_t prg_offset = 16 + (trainer ? 512 : 0);
+    if (prg_size == 0 || prg_size > 0x8000) {
+        throw runtime_error(path + ": PRG ROM of " + to_string(prg_size / 1024) +
+                            "KB needs a mapper; only 16KB and 32KB are supported");
+    }
+    if (file.size() < prg_offset + prg_size) {
+        throw runtime_error(path + " is truncated");
+    }
+    ImageInfo info;
+    bool any = false;
+    if (trainer) {
+        place(cpu, info, any, header + 16, 512, 0x7000, path);
+    }
+    place(cpu, info, any, header + prg_offset, prg_size, 0x8000, path);
+    if (prg_size == 0x4000) {
+        place(cpu, info, any, header + prg_offset, prg_size, 0xC000, path);
+    }
+    return info;
+}
+
+} // namespace
+
+ImageInfo load_image_file(CPU65C02& cpu, const string& path, ImageFormat format, uint16_t address) {
+    MappedFile file(path);
+    switch (format) {
+    case ImageFormat::IntelHex:
+        return load_intel_hex(cpu, file, path);
+    case ImageFormat::INes:
+        return load_ines(cpu, file, path);
+    default:
+        break;
+    }
+    if (file.size() == 0) {
+        throw runtime_error("image " + path + " is empty");
+    }
+    ImageInfo info;
+    bool any = false;
+    place(cpu, info, any, file.data(), file.size(), address, path);
+    return info;
+}
@@ -0,0 +1,50 @@
+#ifndef IMAGE_FILE_H
+#define IMAGE_FILE_H
+
+#include "CPU65C02.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A whole file, read-only. On POSIX systems it is memory-mapped, so opening
+// an image costs a page-table update rather than a copy through a stream,
+// and only the pages actually loaded are ever read from disk.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path); // Throws std::runtime_error
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* bytes;
+    size_t length;
+    std::vector<uint8_t> copy; // The contents where mmap is unavailable
+};
+
+enum class ImageFormat {
+    Raw,        // Bytes loaded as-is at a given address
+    IntelHex,   // Intel HEX records, each with its own address
+    INes        // iNES cartridge; PRG ROM at $8000, mirrored when 16KB
+};
+
+// .hex/.ihx are Intel HEX, .nes is iNES, anything else is raw
+ImageFormat image_format_for(const std::string& path);
+
+// What loading an image found out
+struct ImageInfo {
+    uint16_t first = 0, last = 0; // Lowest and highest address written
+    bool has_entry = false; // The image names its start address
+    uint16_t entry = 0;
+};
+
+// Load an image file into the CPU's memory. address is where a raw image
+// goes; the other formats say where their bytes belong. Throws
+// std::runtime_error if the file is malformed or does not fit in 64KB.
+ImageInfo load_image_file(CPU65C02& cpu, const std::string& path, ImageFormat format, uint16_t address = 0);
+
+#endif // IMAGE_FILE_H
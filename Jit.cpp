@@ -0,0 +1,259 @@
+#include "Jit.h"
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#if CPU65C02_JIT
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+#if CPU65C02_JIT
+
+namespace {
+
+// Just enough of an x86-64 assembler for Jit::compile(). rbx holds the
+// CPU65C02 pointer throughout; rax, rcx and rdx are scratch.
+class Assembler {
+public:
+    vector<uint8_t> code;
+
+    void byte(uint8_t b) { code.push_back(b); }
+    void bytes(std::initializer_list<uint8_t> list) { code.insert(code.end(), list); }
+    void u16(uint16_t v) { append(&v, sizeof(v)); }
+    void u32(uint32_t v) { append(&v, sizeof(v)); }
+    void u64(uint64_t v) { append(&v, sizeof(v)); }
+    void append(const void* p, size_t n) {
+        const uint8_t* b = static_cast<const uint8_t*>(p);
+        code.insert(code.end(), b, b + n);
+    }
+    size_t here() const { return code.size(); }
+
+    // ModRM for [rbx + disp32] with the given reg field
+    void rbx_disp(unsigned reg, int32_t disp) {
+        byte(0x80 | (reg << 3) | 3);
+        u32(disp);
+    }
+
+    // rel32 jumps; returns the offset of the rel32 for patch()
+    size_t jcc(uint8_t cc) { bytes({ 0x0F, cc }); u32(0); return here() - 4; }
+    size_t jmp() { byte(0xE9); u32(0); return here() - 4; }
+    void patch(size_t at, size_t target) {
+        int32_t rel = (int32_t)(target - (at + 4));
+        memcpy(&code[at], &rel, 4);
+    }
+};
+
+const uint8_t JAE = 0x83, JE = 0x84, JNE = 0x85;
+
+const size_t PAGE = 4096; // mprotect() granularity on x86-64 Linux
+
+} // namespace
+
+Jit::Jit(size_t capacity) : capacity(capacity), used(0) {
+    void* p = mmap(nullptr, capacity, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        throw bad_alloc();
+    }
+    buffer = static_cast<uint8_t*>(p);
+}
+
+Jit::~Jit() {
+    munmap(buffer, capacity);
+}
+
+bool Jit::compile(CPU65C02& cpu, CPU65C02::Block& block) {
+    static_assert(sizeof(cpu.regs.PC) == 2 && sizeof(cpu.decoded_operand) == 2, "16-bit stores");
+    static_assert(sizeof(cpu.regs.status) == 1 && sizeof(cpu.regs.A) == 1 && sizeof(cpu.regs.flag_z) == 1, "8-bit registers");
+    static_assert(sizeof(cpu.deadline) == 8, "64-bit deadline");
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(&cpu);
+    auto field = [base](const void* member) {
+        return (int32_t)(static_cast<const uint8_t*>(member) - base);
+    };
+    const int32_t A = field(&cpu.regs.A), X = field(&cpu.regs.X), Y = field(&cpu.regs.Y);
+    const int32_t PC = field(&cpu.regs.PC), STATUS = field(&cpu.regs.status);
+    const int32_t FLAG_N = field(&cpu.regs.flag_n), FLAG_Z = field(&cpu.regs.flag_z);
+    const int32_t FLAG_C = field(&cpu.regs.flag_c), FLAG_V = field(&cpu.regs.flag_v);
+    const int32_t CYCLES = field(&cpu.cycles), DEADLINE = field(&cpu.deadline);
+    const int32_t OPERAND = field(&cpu.decoded_operand);
+    const int32_t GENERATION = field(&cpu.code_generation), EXIT = field(&cpu.jit_exit);
+
+    Assembler a;
+    auto store_pc = [&](uint16_t pc) {
+        a.byte(0x66); a.byte(0xC7); a.rbx_disp(0, PC); a.u16(pc);
+    };
+    auto add_cycles = [&](uint8_t n) {
+        if (n == 0) return;
+        if (sizeof(cpu.cycles) == 8) a.byte(0x48);
+        a.byte(0x83); a.rbx_disp(0, CYCLES); a.byte(n);
+    };
+    // Jumps (to be patched) if cycles >= deadline
+    auto budget_spent = [&]() {
+        if (sizeof(cpu.cycles) == 8) a.byte(0x48);
+        a.byte(0x8B); a.rbx_disp(0, CYCLES);                // mov (r|e)ax, cycles
+        a.byte(0x48); a.byte(0x3B); a.rbx_disp(0, DEADLINE); // cmp rax, deadline
+        return a.jcc(JAE);
+    };
+    auto store_byte = [&](int32_t to, uint8_t value) {
+        a.byte(0xC6); a.rbx_disp(0, to); a.byte(value);     // mov byte to, value
+    };
+    auto step_register = [&](int32_t reg, bool increment) {
+        a.byte(0xFE); a.rbx_disp(increment ? 0 : 1, reg);   // inc/dec byte reg
+        a.byte(0x8A); a.rbx_disp(0, reg);                    // mov al, reg
+        a.byte(0x88); a.rbx_disp(0, FLAG_N);                 // mov flag_n, al
+        a.byte(0x88); a.rbx_disp(0, FLAG_Z);                 // mov flag_z, al
+    };
+    auto set_status = [&](uint8_t mask, bool set) {
+        a.byte(0x80); a.rbx_disp(set ? 1 : 4, STATUS); a.byte(set ? mask : (uint8_t)~mask);
+    };
+    // Taken when (flag & mask) is non-zero, or zero if !if_set. The branch
+    // penalties are known here, so each path adds a constant.
+    auto branch = [&](int32_t flag, uint8_t mask, bool if_set, const CPU65C02::DecodedOp& op, uint16_t target) {
+        a.byte(0xF6); a.rbx_disp(0, flag); a.byte(mask);    // test flag, mask
+        size_t not_taken = a.jcc(if_set ? JE : JNE);
+        store_pc(target);
+        add_cycles(op.cycles + 1 + CPU65C02::page_crossed(op.next_pc, target));
+        size_t done = a.jmp();
+        a.patch(not_taken, a.here());
+        store_pc(op.next_pc);
+        add_cycles(op.cycles);
+        a.patch(done, a.here());
+    };
+    // The handler adds any page-cross penalty itself
+    auto call_handler = [&](const CPU65C02::DecodedOp& op) {
+        add_cycles(op.cycles);
+        store_pc(op.next_pc);
+        a.byte(0x66); a.byte(0xC7); a.rbx_disp(0, OPERAND); a.u16(op.operand);
+        a.bytes({ 0x48, 0x89, 0xDF });                      // mov rdi, rbx
+        a.bytes({ 0x48, 0xB8 }); a.u64((uint64_t)op.handler); // mov rax, handler
+        a.bytes({ 0xFF, 0xD0 });                            // call rax
+    };
+
+    a.byte(0x53);                     // push rbx
+    a.bytes({ 0x48, 0x89, 0xFB });    // mov rbx, rdi
+    size_t body = a.here();
+
+    // Translation stops after the first branch, so the native code has only
+    // the two successors its links cover; the rest of the block is found
+    // again at the fall-through
+    size_t count = 1;
+    while (count < block.ops.size() && !CPU65C02::conditional_branch(block.ops[count - 1].opcode)) {
+        count++;
+    }
+
+    // Budget exits before instruction k leave PC on it
+    vector<pair<size_t, uint16_t>> exits;
+    uint16_t pc = block.address;
+    bool pc_stored = false;
+    for (size_t k = 0; k < count; k++) {
+        const CPU65C02::DecodedOp& op = block.ops[k];
+        if (k > 0) {
+            exits.push_back(make_pair(budget_spent(), pc));
+        }
+        uint16_t target = op.next_pc + (int8_t)op.operand;
+        pc_stored = false;
+        // Entries patched with another handler (breakpoints) are called
+        int opcode = op.handler == cpu.decoded_table[op.opcode] ? op.opcode : -1;
+        switch (opcode) {
+        case 0xE8: step_register(X, true); break;             // INX
+        case 0xC8: step_register(Y, true); break;             // INY
+        case 0xCA: step_register(X, false); break;            // DEX
+        case 0x88: step_register(Y, false); break;            // DEY
+        case 0x18: store_byte(FLAG_C, 0); break;              // CLC
+        case 0x38: store_byte(FLAG_C, 1); break;              // SEC
+        // CLI calls its handler, which may have to stop for a pending IRQ
+        case 0x78: set_status(0x04, true); break;             // SEI
+        case 0xB8: store_byte(FLAG_V, 0); break;              // CLV
+        case 0xD8: set_status(0x08, false); break;            // CLD
+        case 0xF8: set_status(0x08, true); break;             // SED
+        case 0xEA: break;                                     // NOP
+        case 0xA9:                                            // LDA #imm
+            store_byte(A, op.operand);
+            store_byte(FLAG_N, op.operand);
+            store_byte(FLAG_Z, op.operand);
+            break;
+        case 0x10: branch(FLAG_N, 0x80, false, op, target); pc_stored = true; break; // BPL
+        case 0x30: branch(FLAG_N, 0x80, true, op, target); pc_stored = true; break;  // BMI
+        case 0x50: branch(FLAG_V, 0x80, false, op, target); pc_stored = true; break; // BVC
+        case 0x70: branch(FLAG_V, 0x80, true, op, target); pc_stored = true; break;  // BVS
+        case 0x90: branch(FLAG_C, 0x01, false, op, target); pc_stored = true; break; // BCC
+        case 0xB0: branch(FLAG_C, 0x01, true, op, target); pc_stored = true; break;  // BCS
+        case 0xD0: branch(FLAG_Z, 0xFF, true, op, target); pc_stored = true; break;  // BNE
+        case 0xF0: branch(FLAG_Z, 0xFF, false, op, target); pc_stored = true; break; // BEQ
+        case 0x80:                                                                   // BRA
+            store_pc(target);
+            add_cycles(op.cycles + 1 + CPU65C02::page_crossed(op.next_pc, target));
+            pc_stored = true;
+            break;
+        default:
+            call_handler(op);
+            pc_stored = true;
+            break;
+        }
+        if (!pc_stored) {
+            add_cycles(op.cycles);  // Inline ops; branches and call-outs add their own
+        }
+        pc = op.next_pc;
+    }
+    if (!pc_stored) {
+        store_pc(pc);
+    }
+
+    // Follow a link if one matches the new PC and is still current
+    size_t spent = budget_spent();
+    a.bytes({ 0x0F, 0xB7 }); a.rbx_disp(0, PC);                   // movzx eax, word PC
+    a.bytes({ 0x48, 0xB9 }); a.u64((uint64_t)&block.links[0]);    // mov rcx, links
+    a.byte(0x8B); a.rbx_disp(2, GENERATION);                      // mov edx, generation
+    for (int slot = 0; slot < 2; slot++) {
+        uint8_t link = slot * sizeof(CPU65C02::BlockLink);
+        a.bytes({ 0x66, 0x3B, 0x41, (uint8_t)(link + offsetof(CPU65C02::BlockLink, pc)) });
+        a.bytes({ 0x75, 0x08 });                                  // jne next slot
+        a.bytes({ 0x3B, 0x51, (uint8_t)(link + offsetof(CPU65C02::BlockLink, generation)) });
+        a.bytes({ 0x75, 0x03 });                                  // jne next slot
+        a.bytes({ 0xFF, 0x61, (uint8_t)(link + offsetof(CPU65C02::BlockLink, body)) });
+    }
+    // No link: ask the run loop to make one
+    a.bytes({ 0x48, 0xB8 }); a.u64((uint64_t)&block);             // mov rax, block
+    a.byte(0x48); a.byte(0x89); a.rbx_disp(0, EXIT);              // mov jit_exit, rax
+    size_t leave = a.here();
+    a.bytes({ 0x5B, 0xC3 });                                      // pop rbx; ret
+    a.patch(spent, leave);
+    for (const pair<size_t, uint16_t>& exit : exits) {
+        a.patch(exit.first, a.here());
+        store_pc(exit.second);
+        a.bytes({ 0x5B, 0xC3 });
+    }
+
+    if (a.code.size() > capacity - used) {
+        return false;
+    }
+    // Only the pages the code lands on are made writable, so the cost of a
+    // translation does not grow with the buffer
+    uint8_t* dest = buffer + used;
+    uint8_t* first = buffer + (used & ~(PAGE - 1));
+    size_t span = dest + a.code.size() - first;
+    mprotect(first, span, PROT_READ | PROT_WRITE);
+    memcpy(dest, a.code.data(), a.code.size());
+    mprotect(first, span, PROT_READ | PROT_EXEC);
+    used += (a.code.size() + 15) & ~(size_t)15;
+    block.native = reinterpret_cast<void (*)(CPU65C02*)>(dest);
+    block.native_body = dest + body;
+    block.native_ops = count;
+    return true;
+}
+
+#else
+
+Jit::Jit(size_t capacity) : buffer(nullptr), capacity(capacity), used(0) {
+}
+
+Jit::~Jit() {
+}
+
+bool Jit::compile(CPU65C02&, CPU65C02::Block&) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "CPU65C02.h"
+#include <cstddef>
+#include <cstdint>
+
+// Translates cached blocks to x86-64 code in an mmap'd buffer. Simple
+// register, flag and branch instructions are compiled inline; everything
+// else is a direct call to the same Decoded<NoTrace> handler the block core
+// uses, with PC and the operand stored first, so translated code cannot
+// disagree with the interpreter about what an instruction does.
+//
+// The cycle deadline is checked after every instruction, which keeps
+// run_cycles(), request_stop() and code invalidation exact inside
+// translated code. A translated block ends by jumping straight into the
+// block that followed it last time, if the CPU linked one.
+class Jit {
+public:
+    explicit Jit(size_t capacity = 1 << 20);
+    ~Jit();
+    Jit(const Jit&) = delete;
+    Jit& operator=(const Jit&) = delete;
+
+    // Fills in block.native and block.native_body. Returns false when the
+    // buffer is full; clear() it, drop every translation and try again.
+    bool compile(CPU65C02& cpu, CPU65C02::Block& block);
+
+    // Forget every translation
+    void clear() { used = 0; }
+
+private:
+    uint8_t* buffer;
+    size_t capacity;
+    size_t used;
+};
+
+#endif // JIT_H
@@ -0,0 +1,191 @@
+#include "Lockstep.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+
+using namespace std;
+
+namespace {
+
+typedef CPU65C02::StopReason StopReason;
+
+uint64_t saturating_add(uint64_t a, uint64_t b) {
+    return b > UINT64_MAX - a ? UINT64_MAX : a + b;
+}
+
+// Find the first byte where a and b differ. Pages that are still the ones
+// a_before and b_before held, on both sides, have not been written since
+// and agreed then, so they are skipped without being read.
+bool find_difference(const MemorySnapshot& a, const MemorySnapshot& b, const MemorySnapshot& a_before,
+                     const MemorySnapshot& b_before, uint16_t& address) {
+    for (unsigned p = 0; p < Memory::PAGE_COUNT; p++) {
+        const PageRef& page_a = a->pages[p];
+        const PageRef& page_b = b->pages[p];
+        if (page_a == page_b ||
+            (a_before && page_a == a_before->pages[p] && page_b == b_before->pages[p]) ||
+            memcmp(page_a->bytes, page_b->bytes, Memory::PAGE_SIZE) == 0) {
+            continue;
+        }
+        unsigned i = 0;
+        while (page_a->bytes[i] == page_b->bytes[i]) {
+            i++;
+        }
+        address = p << 8 | i;
+        return true;
+    }
+    return false;
+}
+
+void print_state(ostream& out, const char* name, const CPU65C02::Registers& regs, uint64_t cycles,
+                 StopReason stop) {
+    out << name << hex << setfill('0') << " pc=$" << setw(4) << regs.PC << " a=$" << setw(2) << (int)regs.A
+        << " x=$" << setw(2) << (int)regs.X << " y=$" << setw(2) << (int)regs.Y << " s=$" << setw(2)
+        << (int)regs.S << " p=$" << setw(2) << (int)regs.P() << dec << setfill(' ') << " cycles=" << cycles
+        << " stop=" << CPU65C02::stop_reason_name(stop) << endl;
+}
+
+} // namespace
+
+void Divergence::print(ostream& out) const {
+    static const char* const names[] = { "nothing", "stop reason", "registers", "flags", "memory", "cycles" };
+    if (!diverged()) {
+        out << "no divergence" << endl;
+        return;
+    }
+    out << names[(int)kind] << " diverged ";
+    if (exact) {
+        out << "after " << instruction << " instructions, stepping from $";
+    } else {
+        out << "after " << instruction << " instructions, in a chunk that agreed when stepped from $";
+    }
+    out << hex << setfill('0') << setw(4) << pc << dec << setfill(' ') << endl;
+    print_state(out, "  reference:", reference, reference_cycles, reference_stop);
+    print_state(out, "  subject:  ", subject, subject_cycles, subject_stop);
+    if (kind == Kind::Memory) {
+        out << hex << setfill('0') << "  $" << setw(4) << address << ": reference $" << setw(2)
+            << (int)reference_byte << ", subject $" << setw(2) << (int)subject_byte << dec << setfill(' ')
+            << endl;
+    }
+}
+
+Lockstep::Lockstep(CPU65C02& reference, CPU65C02& subject)
+    : reference(reference), subject(subject), chunk_cycles(0), instructions(0),
+      stop_reason(StopReason::Budget) {
+    reference.set_engine(CPU65C02::Engine::Table);
+}
+
+// Snapshot both CPUs and compare them. If they agree, the snapshots become
+// the baseline for the next comparison; otherwise d describes the first
+// difference, in the order the Kind enum lists them.
+bool Lockstep::compare(StopReason reference_stop, StopReason subject_stop, Divergence& d) {
+    CPU65C02::Snapshot r = reference.snapshot();
+    CPU65C02::Snapshot s = subject.snapshot();
+    uint16_t address = 0;
+    if (reference_stop != subject_stop) {
+        d.kind = Divergence::Kind::Stop;
+    } else if (r.regs.PC != s.regs.PC || r.regs.A != s.regs.A || r.regs.X != s.regs.X ||
+               r.regs.Y != s.regs.Y || r.regs.S != s.regs.S) {
+        d.kind = Divergence::Kind::Registers;
+    } else if (r.regs.P() != s.regs.P()) {
+        d.kind = Divergence::Kind::Flags;
+    } else if (find_difference(r.memory, s.memory, reference_state.memory, subject_state.memory, address)) {
+        d.kind = Divergence::Kind::Memory;
+        d.address = address;
+        d.reference_byte = reference.get_RAM(address);
+        d.subject_byte = subject.get_RAM(address);
+    } else if (r.cycles != s.cycles) {
+        d.kind = Divergence::Kind::Cycles;
+    } else {
+        reference_state = r;
+        subject_state = s;
+        return false;
+    }
+    d.reference = r.regs;
+    d.subject = s.regs;
+    d.reference_cycles = r.cycles;
+    d.subject_cycles = s.cycles;
+    d.reference_stop = reference_stop;
+    d.subject_stop = subject_stop;
+    return true;
+}
+
+bool Lockstep::step(uint64_t count, Divergence& d) {
+    for (uint64_t i = 0; i < count && stop_reason == StopReason::Budget; i++) {
+        uint16_t pc = reference.get_PC();
+        StopReason reference_stop = reference.run_instructions(1);
+        StopReason subject_stop = subject.run_instructions(1);
+        if (reference_stop == StopReason::Budget) {
+            instructions++;
+        }
+        if (compare(reference_stop, subject_stop, d)) {
+            d.instruction = instructions;
+            d.pc = pc;
+            return true;
+        }
+        stop_reason = reference_stop;
+    }
+    return false;
+}
+
+bool Lockstep::run_chunk(uint64_t cycles, Divergence& d) {
+    CPU65C02::Snapshot reference_start = reference_state;
+    CPU65C02::Snapshot subject_start = subject_state;
+    uint64_t start_instructions = instructions;
+
+    StopReason subject_stop = subject.run_cycles(cycles);
+    uint64_t target = subject.get_cycles();
+    // Catch the reference up to the same cycle count, and then, if the
+    // subject stopped there, one more step to see whether it stops too
+    StopReason reference_stop = StopReason::Budget;
+    while (reference.get_cycles() < target ||
+           (reference.get_cycles() == target && subject_stop != StopReason::Budget)) {
+        reference_stop = reference.run_instructions(1);
+        if (reference_stop != StopReason::Budget) {
+            break;
+        }
+        instructions++;
+    }
+    if (!compare(reference_stop, subject_stop, d)) {
+        stop_reason = reference_stop;
+        return false;
+    }
+
+    // Replay the chunk an instruction at a time, one step further than the
+    // reference got, to find the instruction that diverged
+    Divergence chunk = d;
+    uint64_t end_instructions = instructions;
+    reference.restore(reference_start);
+    subject.restore(subject_start);
+    reference_state = reference_start;
+    subject_state = subject_start;
+    instructions = start_instructions;
+    if (step(end_instructions - start_instructions + 1, d)) {
+        return true;
+    }
+    d = chunk;
+    d.exact = false;
+    d.instruction = end_instructions;
+    d.pc = reference_start.regs.PC;
+    return true;
+}
+
+Divergence Lockstep::run(uint64_t max_cycles, uint64_t max_instructions) {
+    Divergence d;
+    stop_reason = StopReason::Budget;
+    if (compare(StopReason::Budget, StopReason::Budget, d)) {
+        d.instruction = instructions;
+        d.pc = reference.get_PC();
+        return d;
+    }
+    uint64_t end_cycles = saturating_add(reference.get_cycles(), max_cycles);
+    uint64_t end_instructions = saturating_add(instructions, max_instructions);
+    while (stop_reason == StopReason::Budget && reference.get_cycles() < end_cycles &&
+           instructions < end_instructions) {
+        bool diverged = chunk_cycles ? run_chunk(min(chunk_cycles, end_cycles - reference.get_cycles()), d)
+                                     : step(1, d);
+        if (diverged) {
+            break;
+        }
+    }
+    return d;
+}
@@ -0,0 +1,79 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include "CPU65C02.h"
+#include <cstdint>
+#include <ostream>
+
+// The first point where two CPUs running the same program disagreed
+struct Divergence {
+    enum class Kind {
+        None,       // They agreed throughout
+        Stop,       // One stopped (BRK, STP, WAI) and the other did not
+        Registers,  // PC, A, X, Y or S
+        Flags,      // P
+        Memory,     // A byte of the address space
+        Cycles      // The cycle counters
+    };
+    Kind kind = Kind::None;
+    uint64_t instruction = 0; // Reference instructions run, up to and including the diverging one
+    uint16_t pc = 0;          // Reference PC before the diverging instruction
+    // False when the subject only diverged running a chunk of several
+    // instructions and agreed when replayed one at a time; instruction and
+    // pc then give the end and start of the chunk
+    bool exact = true;
+    CPU65C02::Registers reference = {}, subject = {};
+    uint64_t reference_cycles = 0, subject_cycles = 0;
+    CPU65C02::StopReason reference_stop = CPU65C02::StopReason::Budget;
+    CPU65C02::StopReason subject_stop = CPU65C02::StopReason::Budget;
+    uint16_t address = 0; // First differing byte, for Kind::Memory
+    uint8_t reference_byte = 0, subject_byte = 0;
+
+    bool diverged() const { return kind != Kind::None; }
+    void print(std::ostream& out) const;
+};
+
+// Runs a program on the reference Table core and on a subject CPU side by
+// side, comparing registers, P, every page either one wrote and the cycle
+// counters after each step. Both CPUs must start out holding the same
+// program and state, without devices or scheduled events, which a lockstep
+// run cannot duplicate.
+//
+// By default the subject steps one instruction at a time, which pins a
+// divergence to its instruction. Counted runs keep the Block and Jit engines
+// on their decoded handlers, though, so set_chunk_cycles() lets the subject
+// run freely for that many cycles between comparisons instead (executing
+// translated code), while the reference catches up one instruction at a
+// time. A chunk that diverges is replayed instruction by instruction to
+// find the culprit.
+class Lockstep {
+public:
+    // reference is switched to Engine::Table; subject keeps its engine
+    Lockstep(CPU65C02& reference, CPU65C02& subject);
+
+    void set_chunk_cycles(uint64_t cycles) { chunk_cycles = cycles; }
+
+    // Run until the CPUs diverge, both stop, or the reference has run
+    // max_cycles or max_instructions more
+    Divergence run(uint64_t max_cycles, uint64_t max_instructions = UINT64_MAX);
+
+    // Totals over every run so far
+    uint64_t get_instructions() const { return instructions; }
+    CPU65C02::StopReason get_stop_reason() const { return stop_reason; }
+
+private:
+    bool step(uint64_t count, Divergence& d);
+    bool run_chunk(uint64_t cycles, Divergence& d);
+    bool compare(CPU65C02::StopReason reference_stop, CPU65C02::StopReason subject_stop, Divergence& d);
+
+    CPU65C02& reference;
+    CPU65C02& subject;
+    uint64_t chunk_cycles;
+    uint64_t instructions;
+    CPU65C02::StopReason stop_reason;
+    // State at the last comparison, where both agreed. Pages still shared
+    // with these have not been written since.
+    CPU65C02::Snapshot reference_state, subject_state;
+};
+
+#endif // LOCKSTEP_H
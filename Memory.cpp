@@ -0,0 +1,204 @@
+#include "Memory.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Shared by every page that has never been written
+static const PageRef& zero_page() {
+    static const PageRef page = make_shared<MemoryPage>(MemoryPage());
+    return page;
+}
+
+MemoryImage::MemoryImage(const uint8_t* data, size_t size, uint16_t address) {
+    for (unsigned p = 0; p < Memory::PAGE_COUNT; p++) {
+        pages[p] = zero_page();
+    }
+    size = min<size_t>(size, 0x10000 - address);
+    while (size > 0) {
+        unsigned p = address >> 8;
+        unsigned offset = address & 0xFF;
+        size_t chunk = min<size_t>(size, Memory::PAGE_SIZE - offset);
+        shared_ptr<MemoryPage> page = make_shared<MemoryPage>(*pages[p]);
+        memcpy(page->bytes + offset, data, chunk);
+        pages[p] = page;
+        data += chunk;
+        size -= chunk;
+        address += chunk;
+    }
+}
+
+Memory::Memory() : owned(), devices(), trap_count(0), watcher(nullptr), dirty_count(0) {
+    clear();
+}
+
+void Memory::map_io(uint8_t first_page, uint8_t last_page, IoDevice* device) {
+    for (unsigned p = first_page; p <= last_page; p++) {
+        notify(p);
+        devices[p] = device;
+        update_pointers(p);
+    }
+}
+
+void Memory::watch(uint16_t addr, unsigned size) {
+    for (unsigned i = 0; i < size; i++, addr++) {
+        unsigned p = addr >> 8;
+        if (!watches[p]) {
+            watches[p].reset(new bitset<PAGE_SIZE>());
+            write_pages[p] = nullptr;
+        }
+        watches[p]->set(addr & 0xFF);
+    }
+}
+
+void Memory::trap(uint16_t first, uint16_t last, bool reads, bool writes) {
+    for (unsigned addr = first; addr <= last; addr++) {
+        unsigned p = addr >> 8;
+        if (!traps[p]) {
+            traps[p].reset(new Traps());
+            trap_count++;
+        }
+        if (reads) {
+            traps[p]->reads.set(addr & 0xFF);
+        }
+        if (writes) {
+            traps[p]->writes.set(addr & 0xFF);
+        }
+        update_pointers(p);
+    }
+}
+
+void Memory::clear_traps() {
+    for (unsigned p = 0; p < PAGE_COUNT; p++) {
+        if (traps[p]) {
+            traps[p].reset();
+            update_pointers(p);
+        }
+    }
+    trap_count = 0;
+}
+
+void Memory::load(const uint8_t* data, size_t size, uint16_t address) {
+    size = min<size_t>(size, 0x10000 - address);
+    for (size_t i = 0; i < size; i++) {
+        write(address + i, data[i]);
+    }
+}
+
+void Memory::map(const MemoryImage& image) {
+    for (unsigned p = 0; p < PAGE_COUNT; p++) {
+        set_page(p, image.pages[p]);
+    }
+    base = nullptr;
+    dirty_count = 0;
+}
+
+void Memory::clear() {
+    for (unsigned p = 0; p < PAGE_COUNT; p++) {
+        set_page(p, zero_page());
+    }
+    base = nullptr;
+    dirty_count = 0;
+}
+
+MemorySnapshot Memory::snapshot() {
+    if (base && dirty_count == 0) {
+        return base;
+    }
+    shared_ptr<PageTable> table = make_shared<PageTable>();
+    copy(pages, pages + PAGE_COUNT, table->pages);
+    for (unsigned i = 0; i < dirty_count; i++) {
+        owned[dirty[i]] = nullptr;
+        update_pointers(dirty[i]);
+    }
+    dirty_count = 0;
+    base = table;
+    return base;
+}
+
+void Memory::restore(const MemorySnapshot& snapshot) {
+    if (snapshot == base) {
+        for (unsigned i = 0; i < dirty_count; i++) {
+            set_page(dirty[i], base->pages[dirty[i]]);
+        }
+    } else {
+        for (unsigned p = 0; p < PAGE_COUNT; p++) {
+            set_page(p, snapshot->pages[p]);
+        }
+        base = snapshot;
+    }
+    dirty_count = 0;
+}
+
+// Map a shared page read-only
+void Memory::set_page(unsigned p, const PageRef& page) {
+    if (page != pages[p]) {
+        notify(p);
+    }
+    pages[p] = page;
+    owned[p] = nullptr;
+    update_pointers(p);
+}
+
+void Memory::update_pointers(unsigned p) {
+    bool read_trap = traps[p] && traps[p]->reads.any();
+    bool write_trap = traps[p] && traps[p]->writes.any();
+    read_pages[p] = devices[p] || read_trap ? nullptr : pages[p]->bytes;
+    write_pages[p] = devices[p] || watches[p] || write_trap || !owned[p] ? nullptr : owned[p]->bytes;
+}
+
+void Memory::notify(unsigned p) {
+    if (watches[p]) {
+        watches[p].reset();
+        watcher->page_written(p);
+    }
+}
+
+size_t Memory::private_pages() const {
+    return count_if(owned, owned + PAGE_COUNT, [](const MemoryPage* page) { return page != nullptr; });
+}
+
+// I/O page, or a page with read traps
+uint8_t Memory::read_slow(uint16_t addr) const {
+    uint8_t value = fetch_slow(addr);
+    const Traps* page_traps = traps[addr >> 8].get();
+    if (page_traps && page_traps->reads.test(addr & 0xFF)) {
+        watcher->access_trapped(addr, value, false);
+    }
+    return value;
+}
+
+uint8_t Memory::fetch_slow(uint16_t addr) const {
+    unsigned p = addr >> 8;
+    return devices[p] ? devices[p]->read(addr) : pages[p]->bytes[addr & 0xFF];
+}
+
+// I/O page, page with watched or trapped bytes, or the first write to a
+// shared page: give this instance its own copy
+void Memory::write_slow(uint16_t addr, uint8_t value) {
+    unsigned p = addr >> 8;
+    if (devices[p]) {
+        devices[p]->write(addr, value);
+        trapped_write(addr, value);
+        return;
+    }
+    if (watches[p] && watches[p]->test(addr & 0xFF)) {
+        notify(p);
+    }
+    if (!owned[p]) {
+        shared_ptr<MemoryPage> page = make_shared<MemoryPage>(*pages[p]);
+        owned[p] = page.get();
+        pages[p] = page;
+        dirty[dirty_count++] = p;
+    }
+    update_pointers(p);
+    owned[p]->bytes[addr & 0xFF] = value;
+    trapped_write(addr, value);
+}
+
+void Memory::trapped_write(uint16_t addr, uint8_t value) {
+    const Traps* page_traps = traps[addr >> 8].get();
+    if (page_traps && page_traps->writes.test(addr & 0xFF)) {
+        watcher->access_trapped(addr, value, true);
+    }
+}
@@ -0,0 +1,174 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <cstddef>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+
+// One 6502 page: 256 bytes sharing the high address byte
+struct MemoryPage {
+    uint8_t bytes[256];
+};
+
+typedef std::shared_ptr<const MemoryPage> PageRef;
+
+// The full set of pages at some point in time
+struct PageTable {
+    PageRef pages[256];
+};
+
+typedef std::shared_ptr<const PageTable> MemorySnapshot;
+
+// An immutable 64KB address space. Any number of Memory instances can map
+// it at once; they all read the same pages until they write to them.
+class MemoryImage {
+public:
+    MemoryImage(const uint8_t* data, size_t size, uint16_t address);
+
+private:
+    friend class Memory;
+    PageRef pages[256];
+};
+
+// A memory-mapped peripheral. It is given whole pages and sees the full
+// address of every access that falls into them.
+class IoDevice {
+public:
+    virtual ~IoDevice() {}
+    virtual uint8_t read(uint16_t addr) = 0;
+    virtual void write(uint16_t addr, uint8_t value) = 0;
+};
+
+// Told when a watched byte is about to be written, or a page holding watched
+// bytes is replaced by a different one. All watches on the page are dropped
+// before the call. Also told of every read or write of a trapped byte, once
+// the access has been made; traps stay until cleared.
+class PageWatcher {
+public:
+    virtual ~PageWatcher() {}
+    virtual void page_written(unsigned page) = 0;
+    virtual void access_trapped(uint16_t addr, uint8_t value, bool write) = 0;
+};
+
+// Copy-on-write paged memory. Every page starts out shared (the all-zero
+// page or a page of a MemoryImage) and is copied into a private page the
+// first time it is written, so an instance costs its page table plus the
+// pages it has actually dirtied.
+//
+// Memory is also the CPU's bus: any page can be handed to an IoDevice. Each
+// access tests one page-table pointer; plain RAM goes straight to the page,
+// while I/O pages (and the first write to a shared page) leave the pointer
+// null and take the out-of-line slow path. Pages holding watched bytes also
+// keep their write pointer null, so watching costs nothing on reads and on
+// pages that are never written. Traps do the same to the read or write
+// pointer of the pages they cover, and cost nothing anywhere else.
+class Memory {
+public:
+    static const unsigned PAGE_SIZE = 256;
+    static const unsigned PAGE_COUNT = 256;
+
+    Memory();
+    Memory(const Memory&) = delete;
+    Memory& operator=(const Memory&) = delete;
+
+    uint8_t read(uint16_t addr) const {
+        const uint8_t* page = read_pages[addr >> 8];
+        if (page) {
+            return page[addr & 0xFF];
+        }
+        return read_slow(addr);
+    }
+
+    void write(uint16_t addr, uint8_t value) {
+        uint8_t* page = write_pages[addr >> 8];
+        if (page) {
+            page[addr & 0xFF] = value;
+        } else {
+            write_slow(addr, value);
+        }
+    }
+
+    // Read an instruction byte. The same as read(), except that read traps
+    // only see data reads.
+    uint8_t fetch(uint16_t addr) const {
+        const uint8_t* page = read_pages[addr >> 8];
+        if (page) {
+            return page[addr & 0xFF];
+        }
+        return fetch_slow(addr);
+    }
+
+    // Read the RAM behind an address without side effects, even on I/O pages
+    uint8_t peek(uint16_t addr) const {
+        return pages[addr >> 8]->bytes[addr & 0xFF];
+    }
+
+    // Route every access to pages first_page..last_page to the device
+    // (or back to RAM when device is null). The device is not owned.
+    void map_io(uint8_t first_page, uint8_t last_page, IoDevice* device);
+    bool is_io(unsigned page) const { return devices[page] != nullptr; }
+    // The bytes reads of a page come from, or null for I/O and traps. Instances
+    // returning the same pointer are sharing the page.
+    const uint8_t* read_page(unsigned page) const { return read_pages[page]; }
+
+    // Report the next write to any of the bytes to the watcher (which is
+    // not owned)
+    void set_watcher(PageWatcher* w) { watcher = w; }
+    void watch(uint16_t addr, unsigned size);
+    // Report reads and/or writes of first..last to the watcher
+    void trap(uint16_t first, uint16_t last, bool reads, bool writes);
+    void clear_traps();
+    bool has_traps() const { return trap_count != 0; }
+
+    // Copy bytes in through the write path, privatising the pages touched
+    void load(const uint8_t* data, size_t size, uint16_t address);
+
+    // Drop every private page and map the image (or all zeros) instead
+    void map(const MemoryImage& image);
+    void clear();
+
+    // Freeze the current pages. The pages written since the last snapshot
+    // become shared with it, so the next write to each copies it again.
+    MemorySnapshot snapshot();
+
+    // Map a snapshot's pages back in. Restoring the most recent snapshot
+    // only touches the pages written since it was taken.
+    void restore(const MemorySnapshot& snapshot);
+
+    size_t private_pages() const;
+
+    // Pages written since the last snapshot or restore, in the order they
+    // were first written
+    unsigned written_page_count() const { return dirty_count; }
+    unsigned written_page(unsigned i) const { return dirty[i]; }
+
+private:
+    uint8_t read_slow(uint16_t addr) const;
+    uint8_t fetch_slow(uint16_t addr) const;
+    void write_slow(uint16_t addr, uint8_t value);
+    void trapped_write(uint16_t addr, uint8_t value);
+    void set_page(unsigned p, const PageRef& page);
+    void update_pointers(unsigned p);
+    void notify(unsigned p);
+
+    // Trapped bytes of a page
+    struct Traps {
+        std::bitset<PAGE_SIZE> reads, writes;
+    };
+
+    const uint8_t* read_pages[PAGE_COUNT];    // Null for I/O and read-trapped pages
+    uint8_t* write_pages[PAGE_COUNT]; // Null unless the page is private, unwatched, untrapped RAM
+    PageRef pages[PAGE_COUNT];        // Keeps shared and private pages alive
+    MemoryPage* owned[PAGE_COUNT];    // Writable view of pages private to this instance
+    IoDevice* devices[PAGE_COUNT];    // Device owning each page, if any
+    std::unique_ptr<std::bitset<PAGE_SIZE>> watches[PAGE_COUNT]; // Watched bytes, if any
+    std::unique_ptr<Traps> traps[PAGE_COUNT]; // Trapped bytes, if any
+    unsigned trap_count;              // Pages with traps
+    PageWatcher* watcher;
+    MemorySnapshot base;              // Latest snapshot; pages not in dirty[] still match it
+    uint8_t dirty[PAGE_COUNT];        // Pages made private since base was taken
+    unsigned dirty_count;
+};
+
+#endif // MEMORY_H
@@ -0,0 +1,157 @@
+#include "Profiler.h"
+#include "Disassembler.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+string hex_address(uint16_t address) {
+    char text[8];
+    snprintf(text, sizeof(text), "$%04X", address);
+    return text;
+}
+
+// One report row: a label with its count and cycles
+struct Row {
+    string label;
+    uint64_t count;
+    uint64_t cycles;
+};
+
+void print_section(ostream& out, const char* title, vector<Row>& rows, uint64_t total_cycles, size_t top) {
+    sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+        return a.cycles != b.cycles ? a.cycles > b.cycles : a.label < b.label;
+    });
+    out << '\n' << title << '\n';
+    char line[128];
+    snprintf(line, sizeof(line), "  %14s %6s %14s  %s\n", "cycles", "%", "count", "");
+    out << line;
+    for (size_t i = 0; i < rows.size() && i < top; i++) {
+        double share = total_cycles ? 100.0 * rows[i].cycles / total_cycles : 0.0;
+        snprintf(line, sizeof(line), "  %14llu %6.2f %14llu  ", (unsigned long long)rows[i].cycles, share,
+                 (unsigned long long)rows[i].count);
+        out << line << rows[i].label << '\n';
+    }
+}
+
+} // namespace
+
+Profiler::Profiler() : pcs(new PcCounts[65536]) {
+    clear();
+}
+
+void Profiler::clear() {
+    fill(opcode_counts, opcode_counts + 256, 0);
+    fill(opcode_cycles, opcode_cycles + 256, 0);
+    fill(pcs.get(), pcs.get() + 65536, PcCounts());
+    frames.assign(1, Frame());
+    children.clear();
+    frame = 0;
+    untracked_calls = 0;
+    brk_pending = false;
+    interrupt_count = 0;
+    interrupt_cycles = 0;
+}
+
+void Profiler::interrupt(uint16_t pc, uint16_t handler, unsigned cycles) {
+    if (brk_pending) {
+        enter_handler(pc);  // Taken before the BRK handler's first instruction
+    }
+    call(handler);
+    frames[frame].cycles += cycles;
+    interrupt_count++;
+    interrupt_cycles += cycles;
+}
+
+void Profiler::enter_handler(uint16_t address) {
+    brk_pending = false;
+    call(address);
+}
+
+void Profiler::call(uint16_t address) {
+    if (frames[frame].depth >= MAX_DEPTH) {
+        untracked_calls++;
+        return;
+    }
+    uint64_t key = ((uint64_t)frame << 16) | address;
+    auto found = children.find(key);
+    if (found != children.end()) {
+        frame = found->second;
+        return;
+    }
+    Frame callee;
+    callee.address = address;
+    callee.depth = frames[frame].depth + 1;
+    callee.parent = frame;
+    callee.cycles = 0;
+    frames.push_back(callee);
+    frame = frames.size() - 1;
+    children[key] = frame;
+}
+
+void Profiler::ret() {
+    if (untracked_calls) {
+        untracked_calls--;
+    } else {
+        frame = frames[frame].parent;  // The root frame is its own parent
+    }
+}
+
+void Profiler::report(ostream& out, size_t top) const {
+    uint64_t total_count = 0, total_cycles = 0;
+    vector<Row> opcodes, modes, addresses;
+    for (unsigned op = 0; op < 256; op++) {
+        if (!opcode_counts[op]) {
+            continue;
+        }
+        total_count += opcode_counts[op];
+        total_cycles += opcode_cycles[op];
+        char label[16];
+        snprintf(label, sizeof(label), "$%02X %s", op, opcode_mnemonic(op));
+        opcodes.push_back(Row{ label, opcode_counts[op], opcode_cycles[op] });
+        string mode = opcode_mode(op);
+        auto row = find_if(modes.begin(), modes.end(), [&](const Row& r) { return r.label == mode; });
+        if (row == modes.end()) {
+            modes.push_back(Row{ mode, 0, 0 });
+            row = modes.end() - 1;
+        }
+        row->count += opcode_counts[op];
+        row->cycles += opcode_cycles[op];
+    }
+    for (unsigned pc = 0; pc < 65536; pc++) {
+        const PcCounts& p = pcs[pc];
+        if (p.count) {
+            addresses.push_back(Row{ hex_address(pc) + "  " +
+                                     disassemble(pc, p.code & 0xFF, (p.code >> 8) & 0xFF, p.code >> 16),
+                                     p.count, p.cycles });
+        }
+    }
+    out << "Profile: " << total_count << " instructions, " << total_cycles << " cycles\n";
+    if (interrupt_count) {
+        out << "Interrupts: " << interrupt_count << " taken, " << interrupt_cycles << " cycles\n";
+    }
+    print_section(out, "By opcode:", opcodes, total_cycles, top);
+    print_section(out, "By addressing mode:", modes, total_cycles, top);
+    print_section(out, "By PC:", addresses, total_cycles, top);
+}
+
+void Profiler::write_folded(ostream& out) const {
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (!frames[i].cycles) {
+            continue;
+        }
+        // Walk up to the root, then print outermost first
+        vector<uint16_t> stack;
+        for (uint32_t f = i; f != 0; f = frames[f].parent) {
+            stack.push_back(frames[f].address);
+        }
+        out << "root";
+        for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+            out << ';' << hex_address(*it);
+        }
+        out << ' ' << frames[i].cycles << '\n';
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+// Counts executions and cycles per opcode and per PC in flat arrays, and
+// cycles per call stack. The stack is tracked from the instructions
+// themselves: JSR enters the subroutine at its operand, BRK and interrupt
+// entry enter the handler, and RTS and RTI return to the caller's frame.
+// Interrupt entry is not an instruction, so the CPU reports it separately
+// through interrupt(); its cycles go to the handler's frame. Calls nested
+// deeper than MAX_DEPTH are charged to the deepest frame, so firmware that
+// never returns cannot grow the tree without bound. Addressing-mode totals
+// are summed from the opcode counts when reporting, since the mode follows
+// from the opcode.
+class Profiler {
+public:
+    Profiler();
+
+    // One executed instruction: its address, opcode, the two bytes after
+    // it and the cycles it took
+    void count(uint16_t pc, uint8_t opcode, uint8_t lo, uint8_t hi, unsigned cycles) {
+        if (brk_pending) {
+            enter_handler(pc);
+        }
+        opcode_counts[opcode]++;
+        opcode_cycles[opcode] += cycles;
+        pcs[pc].count++;
+        pcs[pc].cycles += cycles;
+        pcs[pc].code = opcode | (lo << 8) | (hi << 16);
+        frames[frame].cycles += cycles;
+        if (opcode == 0x20) {
+            call(lo | (hi << 8));
+        } else if (opcode == 0x60 || opcode == 0x40) {
+            ret();
+        } else if (opcode == 0x00) {
+            brk_pending = true;  // The handler is wherever the next instruction is
+        }
+    }
+
+    // An IRQ or NMI taken at pc, entering the handler at handler
+    void interrupt(uint16_t pc, uint16_t handler, unsigned cycles);
+
+    void clear();
+
+    // Totals by opcode, addressing mode and PC, most cycles first. Each
+    // section lists at most top entries.
+    void report(std::ostream& out, size_t top = 20) const;
+
+    // Cycles per call stack as "root;$8000;$8123 cycles" lines, the folded
+    // format flamegraph.pl and speedscope read
+    void write_folded(std::ostream& out) const;
+
+    uint64_t get_count(uint16_t pc) const { return pcs[pc].count; }
+    uint64_t get_cycles(uint16_t pc) const { return pcs[pc].cycles; }
+    uint64_t get_opcode_count(uint8_t opcode) const { return opcode_counts[opcode]; }
+    uint64_t get_opcode_cycles(uint8_t opcode) const { return opcode_cycles[opcode]; }
+    uint64_t get_interrupts() const { return interrupt_count; }
+    uint64_t get_interrupt_cycles() const { return interrupt_cycles; }
+
+private:
+    struct PcCounts {
+        uint64_t count;
+        uint64_t cycles;
+        uint32_t code; // Opcode and operand bytes last seen here, for the report
+    };
+    // Call tree node: one per distinct stack of subroutine entry addresses
+    struct Frame {
+        uint16_t address;
+        uint16_t depth;
+        uint32_t parent;
+        uint64_t cycles; // Spent in this frame itself, not its callees
+    };
+
+    static const unsigned MAX_DEPTH = 128;
+    void call(uint16_t address);
+    void ret();
+    void enter_handler(uint16_t address);
+
+    uint64_t opcode_counts[256];
+    uint64_t opcode_cycles[256];
+    std::unique_ptr<PcCounts[]> pcs; // 64K entries
+    std::vector<Frame> frames; // frames[0] is the root
+    std::unordered_map<uint64_t, uint32_t> children; // (parent << 16 | address) -> frame
+    uint32_t frame; // Current frame
+    uint64_t untracked_calls; // Calls made past MAX_DEPTH, still to return
+    bool brk_pending; // The last instruction was a BRK taken as an interrupt
+    uint64_t interrupt_count, interrupt_cycles;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,450 @@
+#include "ReferenceModel.h"
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+enum Op : uint8_t {
+    ADC, AND, ASL, BBR, BBS, BCC, BCS, BEQ, BIT, BMI, BNE, BPL, BRA, BRK, BVC, BVS,
+    CLC, CLD, CLI, CLV, CMP, CPX, CPY, DEC, DEX, DEY, EOR, INC, INX, INY, JMP, JSR,
+    LDA, LDX, LDY, LSR, NOP, ORA, PHA, PHP, PHX, PHY, PLA, PLP, PLX, PLY, RMB, ROL,
+    ROR, RTI, RTS, SBC, SEC, SED, SEI, SMB, STA, STP, STX, STY, STZ, TAX, TAY, TRB,
+    TSB, TSX, TXA, TXS, TYA, WAI
+};
+
+enum Mode : uint8_t {
+    IMP,  // Implied, or a stack operation
+    ACC,  // Accumulator
+    IMM,  // #nn
+    ZP,   // nn
+    ZPX,  // nn,X
+    ZPY,  // nn,Y
+    ABS,  // nnnn
+    ABX,  // nnnn,X
+    ABY,  // nnnn,Y
+    IZP,  // (nn)
+    IZX,  // (nn,X)
+    IZY,  // (nn),Y
+    IND,  // (nnnn), for JMP
+    IAX,  // (nnnn,X), for JMP
+    REL,  // Branch offset
+    ZPR   // nn then a branch offset, for BBR and BBS
+};
+
+struct Row {
+    Op op;
+    Mode mode;
+    uint8_t cycles; // Before page-cross, branch and decimal penalties
+};
+
+// The W65C02S opcode matrix, row by high nibble. The unassigned opcodes are
+// NOPs of the length and timing the chip gives them.
+const Row rows[256] = {
+    // $00
+    { BRK, IMP, 7 }, { ORA, IZX, 6 }, { NOP, IMM, 2 }, { NOP, IMP, 1 },
+    { TSB, ZP, 5 },  { ORA, ZP, 3 },  { ASL, ZP, 5 },  { RMB, ZP, 5 },
+    { PHP, IMP, 3 }, { ORA, IMM, 2 }, { ASL, ACC, 2 }, { NOP, IMP, 1 },
+    { TSB, ABS, 6 }, { ORA, ABS, 4 }, { ASL, ABS, 6 }, { BBR, ZPR, 5 },
+    // $10
+    { BPL, REL, 2 }, { ORA, IZY, 5 }, { ORA, IZP, 5 }, { NOP, IMP, 1 },
+    { TRB, ZP, 5 },  { ORA, ZPX, 4 }, { ASL, ZPX, 6 }, { RMB, ZP, 5 },
+    { CLC, IMP, 2 }, { ORA, ABY, 4 }, { INC, ACC, 2 }, { NOP, IMP, 1 },
+    { TRB, ABS, 6 }, { ORA, ABX, 4 }, { ASL, ABX, 6 }, { BBR, ZPR, 5 },
+    // $20
+    { JSR, ABS, 6 }, { AND, IZX, 6 }, { NOP, IMM, 2 }, { NOP, IMP, 1 },
+    { BIT, ZP, 3 },  { AND, ZP, 3 },  { ROL, ZP, 5 },  { RMB, ZP, 5 },
+    { PLP, IMP, 4 }, { AND, IMM, 2 }, { ROL, ACC, 2 }, { NOP, IMP, 1 },
+    { BIT, ABS, 4 }, { AND, ABS, 4 }, { ROL, ABS, 6 }, { BBR, ZPR, 5 },
+    // $30
+    { BMI, REL, 2 }, { AND, IZY, 5 }, { AND, IZP, 5 }, { NOP, IMP, 1 },
+    { BIT, ZPX, 4 }, { AND, ZPX, 4 }, { ROL, ZPX, 6 }, { RMB, ZP, 5 },
+    { SEC, IMP, 2 }, { AND, ABY, 4 }, { DEC, ACC, 2 }, { NOP, IMP, 1 },
+    { BIT, ABX, 4 }, { AND, ABX, 4 }, { ROL, ABX, 6 }, { BBR, ZPR, 5 },
+    // $40
+    { RTI, IMP, 6 }, { EOR, IZX, 6 }, { NOP, IMM, 2 }, { NOP, IMP, 1 },
+    { NOP, ZP, 3 },  { EOR, ZP, 3 },  { LSR, ZP, 5 },  { RMB, ZP, 5 },
+    { PHA, IMP, 3 }, { EOR, IMM, 2 }, { LSR, ACC, 2 }, { NOP, IMP, 1 },
+    { JMP, ABS, 3 }, { EOR, ABS, 4 }, { LSR, ABS, 6 }, { BBR, ZPR, 5 },
+    // $50
+    { BVC, REL, 2 }, { EOR, IZY, 5 }, { EOR, IZP, 5 }, { NOP, IMP, 1 },
+    { NOP, ZPX, 4 }, { EOR, ZPX, 4 }, { LSR, ZPX, 6 }, { RMB, ZP, 5 },
+    { CLI, IMP, 2 }, { EOR, ABY, 4 }, { PHY, IMP, 3 }, { NOP, IMP, 1 },
+    { NOP, ABS, 8 }, { EOR, ABX, 4 }, { LSR, ABX, 6 }, { BBR, ZPR, 5 },
+    // $60
+    { RTS, IMP, 6 }, { ADC, IZX, 6 }, { NOP, IMM, 2 }, { NOP, IMP, 1 },
+    { STZ, ZP, 3 },  { ADC, ZP, 3 },  { ROR, ZP, 5 },  { RMB, ZP, 5 },
+    { PLA, IMP, 4 }, { ADC, IMM, 2 }, { ROR, ACC, 2 }, { NOP, IMP, 1 },
+    { JMP, IND, 6 }, { ADC, ABS, 4 }, { ROR, ABS, 6 }, { BBR, ZPR, 5 },
+    // $70
+    { BVS, REL, 2 }, { ADC, IZY, 5 }, { ADC, IZP, 5 }, { NOP, IMP, 1 },
+    { STZ, ZPX, 4 }, { ADC, ZPX, 4 }, { ROR, ZPX, 6 }, { RMB, ZP, 5 },
+    { SEI, IMP, 2 }, { ADC, ABY, 4 }, { PLY, IMP, 4 }, { NOP, IMP, 1 },
+    { JMP, IAX, 6 }, { ADC, ABX, 4 }, { ROR, ABX, 6 }, { BBR, ZPR, 5 },
+    // $80
+    { BRA, REL, 2 }, { STA, IZX, 6 }, { NOP, IMM, 2 }, { NOP, IMP, 1 },
+    { STY, ZP, 3 },  { STA, ZP, 3 },  { STX, ZP, 3 },  { SMB, ZP, 5 },
+    { DEY, IMP, 2 }, { BIT, IMM, 2 }, { TXA, IMP, 2 }, { NOP, IMP, 1 },
+    { STY, ABS, 4 }, { STA, ABS, 4 }, { STX, ABS, 4 }, { BBS, ZPR, 5 },
+    // $90
+    { BCC, REL, 2 }, { STA, IZY, 6 }, { STA, IZP, 5 }, { NOP, IMP, 1 },
+    { STY, ZPX, 4 }, { STA, ZPX, 4 }, { STX, ZPY, 4 }, { SMB, ZP, 5 },
+    { TYA, IMP, 2 }, { STA, ABY, 5 }, { TXS, IMP, 2 }, { NOP, IMP, 1 },
+    { STZ, ABS, 4 }, { STA, ABX, 5 }, { STZ, ABX, 5 }, { BBS, ZPR, 5 },
+    // $A0
+    { LDY, IMM, 2 }, { LDA, IZX, 6 }, { LDX, IMM, 2 }, { NOP, IMP, 1 },
+    { LDY, ZP, 3 },  { LDA, ZP, 3 },  { LDX, ZP, 3 },  { SMB, ZP, 5 },
+    { TAY, IMP, 2 }, { LDA, IMM, 2 }, { TAX, IMP, 2 }, { NOP, IMP, 1 },
+    { LDY, ABS, 4 }, { LDA, ABS, 4 }, { LDX, ABS, 4 }, { BBS, ZPR, 5 },
+    // $B0
+    { BCS, REL, 2 }, { LDA, IZY, 5 }, { LDA, IZP, 5 }, { NOP, IMP, 1 },
+    { LDY, ZPX, 4 }, { LDA, ZPX, 4 }, { LDX, ZPY, 4 }, { SMB, ZP, 5 },
+    { CLV, IMP, 2 }, { LDA, ABY, 4 }, { TSX, IMP, 2 }, { NOP, IMP, 1 },
+    { LDY, ABX, 4 }, { LDA, ABX, 4 }, { LDX, ABY, 4 }, { BBS, ZPR, 5 },
+    // $C0
+    { CPY, IMM, 2 }, { CMP, IZX, 6 }, { NOP, IMM, 2 }, { NOP, IMP, 1 },
+    { CPY, ZP, 3 },  { CMP, ZP, 3 },  { DEC, ZP, 5 },  { SMB, ZP, 5 },
+    { INY, IMP, 2 }, { CMP, IMM, 2 }, { DEX, IMP, 2 }, { WAI, IMP, 3 },
+    { CPY, ABS, 4 }, { CMP, ABS, 4 }, { DEC, ABS, 6 }, { BBS, ZPR, 5 },
+    // $D0
+    { BNE, REL, 2 }, { CMP, IZY, 5 }, { CMP, IZP, 5 }, { NOP, IMP, 1 },
+    { NOP, ZPX, 4 }, { CMP, ZPX, 4 }, { DEC, ZPX, 6 }, { SMB, ZP, 5 },
+    { CLD, IMP, 2 }, { CMP, ABY, 4 }, { PHX, IMP, 3 }, { STP, IMP, 3 },
+    { NOP, ABS, 4 }, { CMP, ABX, 4 }, { DEC, ABX, 7 }, { BBS, ZPR, 5 },
+    // $E0
+    { CPX, IMM, 2 }, { SBC, IZX, 6 }, { NOP, IMM, 2 }, { NOP, IMP, 1 },
+    { CPX, ZP, 3 },  { SBC, ZP, 3 },  { INC, ZP, 5 },  { SMB, ZP, 5 },
+    { INX, IMP, 2 }, { SBC, IMM, 2 }, { NOP, IMP, 2 }, { NOP, IMP, 1 },
+    { CPX, ABS, 4 }, { SBC, ABS, 4 }, { INC, ABS, 6 }, { BBS, ZPR, 5 },
+    // $F0
+    { BEQ, REL, 2 }, { SBC, IZY, 5 }, { SBC, IZP, 5 }, { NOP, IMP, 1 },
+    { NOP, ZPX, 4 }, { SBC, ZPX, 4 }, { INC, ZPX, 6 }, { SMB, ZP, 5 },
+    { SED, IMP, 2 }, { SBC, ABY, 4 }, { PLX, IMP, 4 }, { NOP, IMP, 1 },
+    { NOP, ABS, 4 }, { SBC, ABX, 4 }, { INC, ABX, 7 }, { BBS, ZPR, 5 },
+};
+
+const uint8_t FLAG_C = 0x01, FLAG_Z = 0x02, FLAG_I = 0x04, FLAG_D = 0x08, FLAG_V = 0x40, FLAG_N = 0x80;
+
+// Indexed reads, and the shifts and rotates on nnnn,X, take a cycle more
+// when indexing crosses a page
+bool page_penalty(Op op, Mode mode) {
+    switch (op) {
+    case ADC: case AND: case BIT: case CMP: case EOR: case LDA: case LDX: case LDY: case ORA: case SBC:
+        return true;
+    case ASL: case LSR: case ROL: case ROR:
+        return mode == ABX;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+ReferenceModel::ReferenceModel() : state{ 0, 0, 0, 0, 0xFF, 0x34, 0 } {
+    memset(memory, 0, sizeof(memory));
+}
+
+void ReferenceModel::set_memory(const uint8_t* bytes) {
+    memcpy(memory, bytes, sizeof(memory));
+    journal.clear();
+}
+
+void ReferenceModel::load(const uint8_t* data, size_t size, uint16_t address) {
+    for (size_t i = 0; i < size; i++) {
+        write(address + i, data[i]);
+    }
+}
+
+void ReferenceModel::rollback() {
+    for (auto undo = journal.rbegin(); undo != journal.rend(); ++undo) {
+        memory[undo->address] = undo->old;
+    }
+    journal.clear();
+}
+
+void ReferenceModel::set_nz(uint8_t value) {
+    set_flag(FLAG_N, value & 0x80);
+    set_flag(FLAG_Z, value == 0);
+}
+
+// Taken branches cost a cycle, and another if the target is on a different
+// page from the next instruction
+void ReferenceModel::branch(bool taken, uint16_t target) {
+    if (taken) {
+        state.cycles += 1 + ((state.pc ^ target) > 0xFF);
+        state.pc = target;
+    }
+}
+
+CPU65C02::StopReason ReferenceModel::step() {
+    uint8_t opcode = read(state.pc);
+    const Row& row = rows[opcode];
+    if (row.op == BRK) {
+        return CPU65C02::StopReason::Brk;
+    }
+    if (row.op == STP) {
+        return CPU65C02::StopReason::Halt;
+    }
+    state.pc++;
+    state.cycles += row.cycles;
+
+    // Resolve the addressing mode to the address operated on
+    uint16_t address = 0, base = 0;
+    uint8_t zp = 0;
+    switch (row.mode) {
+    case IMP:
+    case ACC:
+        break;
+    case IMM:
+        address = state.pc++;
+        break;
+    case ZP:
+        address = read(state.pc++);
+        break;
+    case ZPX:
+        address = (uint8_t)(read(state.pc++) + state.x);
+        break;
+    case ZPY:
+        address = (uint8_t)(read(state.pc++) + state.y);
+        break;
+    case ABS:
+        address = read_word(state.pc);
+        state.pc += 2;
+        break;
+    case ABX:
+        base = read_word(state.pc);
+        state.pc += 2;
+        address = base + state.x;
+        break;
+    case ABY:
+        base = read_word(state.pc);
+        state.pc += 2;
+        address = base + state.y;
+        break;
+    case IZP:
+        zp = read(state.pc++);
+        address = read(zp) | read((uint8_t)(zp + 1)) << 8;
+        break;
+    case IZX:
+        zp = read(state.pc++) + state.x;
+        address = read(zp) | read((uint8_t)(zp + 1)) << 8;
+        break;
+    case IZY:
+        zp = read(state.pc++);
+        base = read(zp) | read((uint8_t)(zp + 1)) << 8;
+        address = base + state.y;
+        break;
+    case IND:
+        address = read_word(read_word(state.pc));
+        state.pc += 2;
+        break;
+    case IAX:
+        address = read_word(read_word(state.pc) + state.x);
+        state.pc += 2;
+        break;
+    case REL:
+        address = state.pc + 1 + (int8_t)read(state.pc);
+        state.pc++;
+        break;
+    case ZPR:
+        zp = read(state.pc);
+        address = state.pc + 2 + (int8_t)read(state.pc + 1);
+        state.pc += 2;
+        break;
+    }
+    if ((row.mode == ABX || row.mode == ABY || row.mode == IZY) && (base ^ address) > 0xFF &&
+        page_penalty(row.op, row.mode)) {
+        state.cycles++;
+    }
+
+    uint8_t bit = 1 << ((opcode >> 4) & 7); // For RMB, SMB, BBR and BBS
+    uint8_t value = 0;
+    switch (row.op) {
+    case ADC:
+    case SBC: {
+        uint8_t m = read(address);
+        unsigned carry = state.p & FLAG_C;
+        if (state.p & FLAG_D) {
+            // Decimal mode, after "Decimal Mode" by Bruce Clark (6502.org),
+            // 65C02 sequences 1, 2 and 4. N and Z come from the result.
+            int result, signed_result;
+            if (row.op == ADC) {
+                int low = (state.a & 0x0F) + (m & 0x0F) + carry;
+                if (low >= 0x0A) {
+                    low = ((low + 0x06) & 0x0F) + 0x10;
+                }
+                result = (state.a & 0xF0) + (m & 0xF0) + low;
+                signed_result = (int8_t)(state.a & 0xF0) + (int8_t)(m & 0xF0) + low;
+                if (result >= 0xA0) {
+                    result += 0x60;
+                }
+                set_flag(FLAG_C, result >= 0x100);
+                set_flag(FLAG_V, signed_result < -128 || signed_result > 127);
+            } else {
+                int low = (state.a & 0x0F) - (m & 0x0F) + (int)carry - 1;
+                int binary = state.a - m + (int)carry - 1;
+                signed_result = (int8_t)state.a - (int8_t)m + (int)carry - 1;
+                result = binary;
+                if (result < 0) {
+                    result -= 0x60;
+                }
+                if (low < 0) {
+                    result -= 0x06;
+                }
+                set_flag(FLAG_C, binary >= 0);
+                set_flag(FLAG_V, signed_result < -128 || signed_result > 127);
+            }
+            state.a = result;
+            state.cycles++;
+        } else {
+            if (row.op == SBC) {
+                m = ~m;
+            }
+            int sum = state.a + m + carry;
+            int signed_sum = (int8_t)state.a + (int8_t)m + (int)carry;
+            set_flag(FLAG_C, sum > 0xFF);
+            set_flag(FLAG_V, signed_sum < -128 || signed_sum > 127);
+            state.a = sum;
+        }
+        set_nz(state.a);
+        break;
+    }
+    case AND:
+        state.a &= read(address);
+        set_nz(state.a);
+        break;
+    case ORA:
+        state.a |= read(address);
+        set_nz(state.a);
+        break;
+    case EOR:
+        state.a ^= read(address);
+        set_nz(state.a);
+        break;
+    case ASL:
+    case LSR:
+    case ROL:
+    case ROR: {
+        value = row.mode == ACC ? state.a : read(address);
+        bool carry_in = state.p & FLAG_C;
+        bool carry_out = row.op == ASL || row.op == ROL ? value & 0x80 : value & 0x01;
+        if (row.op == ASL || row.op == ROL) {
+            value = value << 1 | (row.op == ROL && carry_in);
+        } else {
+            value = value >> 1 | (row.op == ROR && carry_in ? 0x80 : 0);
+        }
+        set_flag(FLAG_C, carry_out);
+        set_nz(value);
+        if (row.mode == ACC) {
+            state.a = value;
+        } else {
+            write(address, value);
+        }
+        break;
+    }
+    case INC:
+    case DEC:
+        value = (row.mode == ACC ? state.a : read(address)) + (row.op == INC ? 1 : -1);
+        set_nz(value);
+        if (row.mode == ACC) {
+            state.a = value;
+        } else {
+            write(address, value);
+        }
+        break;
+    case BIT:
+        value = read(address);
+        set_flag(FLAG_Z, (state.a & value) == 0);
+        if (row.mode != IMM) {
+            set_flag(FLAG_N, value & 0x80);
+            set_flag(FLAG_V, value & 0x40);
+        }
+        break;
+    case TRB:
+    case TSB:
+        value = read(address);
+        set_flag(FLAG_Z, (state.a & value) == 0);
+        write(address, row.op == TSB ? value | state.a : value & ~state.a);
+        break;
+    case CMP:
+    case CPX:
+    case CPY: {
+        uint8_t reg = row.op == CMP ? state.a : row.op == CPX ? state.x : state.y;
+        value = read(address);
+        set_flag(FLAG_C, reg >= value);
+        set_nz(reg - value);
+        break;
+    }
+    case BBR:
+        branch(!(read(zp) & bit), address);
+        break;
+    case BBS:
+        branch(read(zp) & bit, address);
+        break;
+    case BCC: branch(!(state.p & FLAG_C), address); break;
+    case BCS: branch(state.p & FLAG_C, address); break;
+    case BNE: branch(!(state.p & FLAG_Z), address); break;
+    case BEQ: branch(state.p & FLAG_Z, address); break;
+    case BPL: branch(!(state.p & FLAG_N), address); break;
+    case BMI: branch(state.p & FLAG_N, address); break;
+    case BVC: branch(!(state.p & FLAG_V), address); break;
+    case BVS: branch(state.p & FLAG_V, address); break;
+    case BRA: branch(true, address); break;
+    case CLC: set_flag(FLAG_C, false); break;
+    case CLD: set_flag(FLAG_D, false); break;
+    case CLI: set_flag(FLAG_I, false); break;
+    case CLV: set_flag(FLAG_V, false); break;
+    case SEC: set_flag(FLAG_C, true); break;
+    case SED: set_flag(FLAG_D, true); break;
+    case SEI: set_flag(FLAG_I, true); break;
+    case DEX: set_nz(--state.x); break;
+    case DEY: set_nz(--state.y); break;
+    case INX: set_nz(++state.x); break;
+    case INY: set_nz(++state.y); break;
+    case LDA: set_nz(state.a = read(address)); break;
+    case LDX: set_nz(state.x = read(address)); break;
+    case LDY: set_nz(state.y = read(address)); break;
+    case STA: write(address, state.a); break;
+    case STX: write(address, state.x); break;
+    case STY: write(address, state.y); break;
+    case STZ: write(address, 0); break;
+    case TAX: set_nz(state.x = state.a); break;
+    case TAY: set_nz(state.y = state.a); break;
+    case TSX: set_nz(state.x = state.s); break;
+    case TXA: set_nz(state.a = state.x); break;
+    case TYA: set_nz(state.a = state.y); break;
+    case TXS: state.s = state.x; break;
+    case PHA: push(state.a); break;
+    case PHX: push(state.x); break;
+    case PHY: push(state.y); break;
+    case PHP: push(state.p | 0x30); break;
+    case PLA: set_nz(state.a = pull()); break;
+    case PLX: set_nz(state.x = pull()); break;
+    case PLY: set_nz(state.y = pull()); break;
+    case PLP: state.p = pull() | 0x30; break;
+    case RMB: write(address, read(address) & ~bit); break;
+    case SMB: write(address, read(address) | bit); break;
+    case JMP: state.pc = address; break;
+    case JSR:
+        push((state.pc - 1) >> 8);
+        push(state.pc - 1);
+        state.pc = address;
+        break;
+    case RTS:
+        state.pc = pull();
+        state.pc = (state.pc | pull() << 8) + 1;
+        break;
+    case RTI:
+        state.p = pull() | 0x30;
+        state.pc = pull();
+        state.pc |= pull() << 8;
+        break;
+    case WAI:
+        return CPU65C02::StopReason::Wait;
+    case NOP:
+    case BRK:
+    case STP:
+        break;
+    }
+    return CPU65C02::StopReason::Budget;
+}
@@ -0,0 +1,71 @@
+#ifndef REFERENCE_MODEL_H
+#define REFERENCE_MODEL_H
+
+#include "CPU65C02.h"
+#include <cstdint>
+#include <vector>
+
+// A second, deliberately simple 65C02, written from the data sheet rather
+// than from CPU65C02's opcode map, to check the CPU against. Each opcode is
+// a row of one table giving its operation, addressing mode and base cycle
+// count; step() resolves the mode to an address and then runs the
+// operation on it. Speed is not a goal beyond what fuzzing needs.
+//
+// It models what a fuzzed program can observe without devices: registers,
+// flags, memory and cycles. BRK, STP and WAI stop it the way they stop a
+// CPU65C02 run with its default settings, and interrupts are not modelled.
+//
+// Every write is journaled, so rollback() undoes a run (and anything loaded
+// since the last set_memory()) at the cost of the bytes it wrote.
+class ReferenceModel {
+public:
+    // P keeps its two unused bits set, as it reads on the stack
+    struct State {
+        uint16_t pc;
+        uint8_t a, x, y, s, p;
+        uint64_t cycles;
+    };
+    State state;
+
+    ReferenceModel();
+
+    // Replace all of memory, forgetting the journal
+    void set_memory(const uint8_t* bytes);
+    void load(const uint8_t* data, size_t size, uint16_t address);
+    uint8_t peek(uint16_t address) const { return memory[address]; }
+
+    // Run one instruction. Returns Budget unless the instruction stopped it,
+    // in which case PC is left as CPU65C02 leaves it.
+    CPU65C02::StopReason step();
+
+    // Undo every write since set_memory() or the last rollback()
+    void rollback();
+    // Addresses written since then, oldest first; may repeat
+    template <class Fn> void for_each_written(Fn fn) const {
+        for (const Undo& undo : journal) {
+            fn(undo.address);
+        }
+    }
+
+private:
+    struct Undo {
+        uint16_t address;
+        uint8_t old;
+    };
+    uint8_t memory[65536];
+    std::vector<Undo> journal;
+
+    uint8_t read(uint16_t address) const { return memory[address]; }
+    void write(uint16_t address, uint8_t value) {
+        journal.push_back(Undo{ address, memory[address] });
+        memory[address] = value;
+    }
+    uint16_t read_word(uint16_t address) const { return read(address) | read((uint16_t)(address + 1)) << 8; }
+    void push(uint8_t value) { write(0x0100 | state.s--, value); }
+    uint8_t pull() { return read(0x0100 | ++state.s); }
+    void set_nz(uint8_t value);
+    void set_flag(uint8_t flag, bool on) { state.p = on ? state.p | flag : state.p & ~flag; }
+    void branch(bool taken, uint16_t target);
+};
+
+#endif // REFERENCE_MODEL_H
@@ -0,0 +1,29 @@
+#include "Scheduler.h"
+#include <algorithm>
+
+using namespace std;
+
+void Scheduler::schedule(uint64_t time, EventHandler* handler) {
+    uint64_t previous = next_time();
+    heap.push_back(Event{ time, sequence++, handler });
+    push_heap(heap.begin(), heap.end(), later);
+    if (time < previous && watcher) {
+        watcher->next_event_changed(time);
+    }
+}
+
+void Scheduler::cancel(EventHandler* handler) {
+    heap.erase(remove_if(heap.begin(), heap.end(),
+                         [handler](const Event& e) { return e.handler == handler; }),
+               heap.end());
+    make_heap(heap.begin(), heap.end(), later);
+}
+
+void Scheduler::run_due(uint64_t now) {
+    while (!heap.empty() && heap.front().time <= now) {
+        Event event = heap.front();
+        pop_heap(heap.begin(), heap.end(), later);
+        heap.pop_back();
+        event.handler->fire(event.time);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <cstdint>
+#include <vector>
+
+// A peripheral's timed work: a timer expiring, a UART byte arriving. fire()
+// is called with the cycle count the event was scheduled for, once the CPU
+// has reached it, and may schedule the device's next event.
+class EventHandler {
+public:
+    virtual ~EventHandler() {}
+    virtual void fire(uint64_t time) = 0;
+};
+
+// Told when a newly scheduled event becomes the earliest one
+class ScheduleWatcher {
+public:
+    virtual ~ScheduleWatcher() {}
+    virtual void next_event_changed(uint64_t time) = 0;
+};
+
+// Pending device events, keyed on the CPU cycle counter. The CPU runs
+// uninterrupted up to next_time() and then calls run_due(), so devices cost
+// nothing between their events. Events due at the same time fire in the
+// order they were scheduled.
+class Scheduler {
+public:
+    Scheduler() : sequence(0), watcher(nullptr) {}
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Call handler->fire(time) once the cycle counter reaches time. The
+    // handler is not owned.
+    void schedule(uint64_t time, EventHandler* handler);
+
+    // Drop every pending event of handler
+    void cancel(EventHandler* handler);
+    void clear() { heap.clear(); }
+
+    // Earliest pending event, or UINT64_MAX when there is none
+    uint64_t next_time() const { return heap.empty() ? UINT64_MAX : heap.front().time; }
+    bool empty() const { return heap.empty(); }
+
+    // Fire every event due at or before now, earliest first, including any
+    // the handlers schedule for no later than now
+    void run_due(uint64_t now);
+
+    // Report every new earliest event to the watcher (which is not owned)
+    void set_watcher(ScheduleWatcher* w) { watcher = w; }
+
+private:
+    struct Event {
+        uint64_t time;
+        uint64_t sequence; // Keeps events due at the same time in order
+        EventHandler* handler;
+    };
+    // Orders the heap so the earliest event is at the front
+    static bool later(const Event& a, const Event& b) {
+        return a.time != b.time ? a.time > b.time : a.sequence > b.sequence;
+    }
+
+    std::vector<Event> heap;
+    uint64_t sequence;
+    ScheduleWatcher* watcher;
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,110 @@
+#include "TraceRecorder.h"
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+static const char TRACE_MAGIC[8] = "6502TRC";
+// Version 1 traces predate interrupt records; every record in them is an
+// instruction, so they read the same
+static const uint32_t TRACE_VERSION = 2;
+
+TraceRecorder::TraceRecorder(const string& path, size_t capacity)
+    : capacity(1), write_failed(false), tail_seen(0), head(0), tail(0), closing(false) {
+    while (this->capacity < capacity) {
+        this->capacity <<= 1;
+    }
+    mask = this->capacity - 1;
+    ring.reset(new TraceRecord[this->capacity]);
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        throw runtime_error("cannot create trace " + path);
+    }
+    TraceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    write_failed = fwrite(&header, sizeof(header), 1, file) != 1;
+    writer = thread(&TraceRecorder::drain, this);
+}
+
+TraceRecorder::~TraceRecorder() {
+    try {
+        close();
+    } catch (const exception&) {
+        // Nothing to report to from a destructor; call close() to find out
+    }
+}
+
+void TraceRecorder::close() {
+    if (!file) {
+        return;
+    }
+    closing.store(true, memory_order_release);
+    writer.join();
+    bool failed = fclose(file) != 0 || write_failed;
+    file = nullptr;
+    if (failed) {
+        throw runtime_error("error writing trace");
+    }
+}
+
+void TraceRecorder::wait_for_space(uint64_t h) {
+    for (;;) {
+        tail_seen = tail.load(memory_order_acquire);
+        if (h - tail_seen < capacity) {
+            return;
+        }
+        this_thread::yield();
+    }
+}
+
+// Writer thread: copies out everything published so far, at most up to the
+// end of the ring per fwrite, then hands the slots back
+void TraceRecorder::drain() {
+    uint64_t t = tail.load(memory_order_relaxed);
+    for (;;) {
+        // Read closing first so a record published before close() is seen
+        bool last = closing.load(memory_order_acquire);
+        uint64_t h = head.load(memory_order_acquire);
+        if (h == t) {
+            if (last) {
+                return;
+            }
+            this_thread::sleep_for(chrono::microseconds(200));
+            continue;
+        }
+        while (t != h) {
+            size_t start = t & mask;
+            size_t count = min<uint64_t>(h - t, capacity - start);
+            if (fwrite(&ring[start], sizeof(TraceRecord), count, file) != count) {
+                write_failed = true;
+            }
+            t += count;
+            tail.store(t, memory_order_release);
+        }
+    }
+}
+
+TraceReader::TraceReader(const string& path) {
+    file = fopen(path.c_str(), "rb");
+    if (!file) {
+        throw runtime_error("cannot open trace " + path);
+    }
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version < 1 || header.version > TRACE_VERSION || header.record_size != sizeof(TraceRecord)) {
+        fclose(file);
+        throw runtime_error(path + " is not a trace this version can read");
+    }
+}
+
+TraceReader::~TraceReader() {
+    fclose(file);
+}
+
+bool TraceReader::next(TraceRecord& record) {
+    return fread(&record, sizeof(record), 1, file) == 1;
+}
@@ -0,0 +1,98 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Record kinds. An interrupt record is the entry into an IRQ or NMI
+// handler, which no instruction accounts for: pc is where it was taken,
+// opcode the low byte of the vector ($FA or $FE), operand the handler's
+// address and cycles the 7 entry cycles.
+static const uint8_t TRACE_INSTRUCTION = 0;
+static const uint8_t TRACE_INTERRUPT = 1;
+
+// One executed instruction, as the CPU was before it ran. Records are a
+// fixed 12 bytes so a trace can be read back by offset and stays small
+// enough to keep billions of them.
+struct TraceRecord {
+    uint16_t pc;
+    uint8_t opcode;
+    uint8_t operand[2]; // The two bytes after the opcode, whatever its length
+    uint8_t A, X, Y, S, P;
+    uint8_t cycles; // Cycles the instruction took
+    uint8_t kind; // TRACE_INSTRUCTION or TRACE_INTERRUPT
+};
+static_assert(sizeof(TraceRecord) == 12, "trace records are written as-is");
+
+// File layout: a TraceHeader followed by TraceRecords, little-endian
+struct TraceHeader {
+    char magic[8]; // "6502TRC\0"
+    uint32_t version;
+    uint32_t record_size;
+};
+
+// Writes a binary instruction trace. The CPU thread appends records to a
+// single-producer single-consumer ring buffer, and a background thread
+// drains it to the file in large writes. append() is a store and an
+// atomic index update; it only waits when the writer falls a whole buffer
+// behind, so no record is ever dropped.
+class TraceRecorder {
+public:
+    // Throws std::runtime_error if path cannot be created. capacity is in
+    // records and is rounded up to a power of two.
+    explicit TraceRecorder(const std::string& path, size_t capacity = 1 << 20);
+    ~TraceRecorder(); // Calls close()
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    void append(const TraceRecord& record) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail_seen == capacity) {
+            wait_for_space(h);
+        }
+        ring[h & mask] = record;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    // Drain what is left and close the file. Throws std::runtime_error if
+    // any write failed.
+    void close();
+    uint64_t get_records() const { return head.load(std::memory_order_relaxed); }
+
+private:
+    void wait_for_space(uint64_t h);
+    void drain();
+
+    std::unique_ptr<TraceRecord[]> ring;
+    size_t capacity;
+    size_t mask;
+    FILE* file;
+    bool write_failed;
+    uint64_t tail_seen; // Producer's copy of tail, refreshed only when full
+    alignas(64) std::atomic<uint64_t> head; // Next slot to fill; written by append()
+    alignas(64) std::atomic<uint64_t> tail; // Next slot to write out; written by drain()
+    std::atomic<bool> closing;
+    std::thread writer;
+};
+
+// Reads a trace written by TraceRecorder
+class TraceReader {
+public:
+    // Throws std::runtime_error if path is missing or not a trace
+    explicit TraceReader(const std::string& path);
+    ~TraceReader();
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    // False at the end of the trace
+    bool next(TraceRecord& record);
+
+private:
+    FILE* file;
+};
+
+#endif // TRACE_RECORDER_H
@@ -0,0 +1,850 @@
+#include "WideCPU.h"
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+// What the wide core does with each opcode, classified from its handler's
+// name in the opcode map
+enum class Op : uint8_t {
+    None, // Left to the lanes' own engines
+    LDA, LDX, LDY, STA, STX, STY, STZ,
+    ADC, SBC, AND, ORA, EOR, CMP, CPX, CPY, BIT,
+    ASL, LSR, ROL, ROR, INC, DEC,
+    TAX, TAY, TXA, TYA, TSX, TXS, INX, INY, DEX, DEY,
+    CLC, SEC, CLD, SED, CLI, SEI, CLV,
+    PHA, PHX, PHY, PHP, PLA, PLX, PLY, PLP,
+    BCC, BCS, BEQ, BNE, BMI, BPL, BVC, BVS, BRA,
+    JMP, JSR, RTS, NOP
+};
+
+enum class Mode : uint8_t {
+    Implied, Accumulator, Immediate, ZeroPage, ZeroPageX, ZeroPageY,
+    Absolute, AbsoluteX, AbsoluteY, IndirectX, IndirectY, Indirect, Other
+};
+
+struct WideOp {
+    Op op;
+    Mode mode; // Implied for anything that does not read or write memory
+    uint8_t bytes, cycles;
+    bool reads;   // Takes an operand from memory, A or the instruction
+    bool writes;  // Stores a result to memory, or to A for Accumulator
+    bool penalty; // Costs a cycle when indexing crosses a page
+};
+
+struct Mnemonic {
+    const char* name;
+    Op op;
+};
+
+constexpr Mnemonic mnemonics[] = {
+    { "LDA", Op::LDA }, { "LDX", Op::LDX }, { "LDY", Op::LDY }, { "STA", Op::STA },
+    { "STX", Op::STX }, { "STY", Op::STY }, { "STZ", Op::STZ }, { "ADC", Op::ADC },
+    { "SBC", Op::SBC }, { "AND", Op::AND }, { "ORA", Op::ORA }, { "EOR", Op::EOR },
+    { "CMP", Op::CMP }, { "CPX", Op::CPX }, { "CPY", Op::CPY }, { "BIT", Op::BIT },
+    { "ASL", Op::ASL }, { "LSR", Op::LSR }, { "ROL", Op::ROL }, { "ROR", Op::ROR },
+    { "INC", Op::INC }, { "DEC", Op::DEC }, { "TAX", Op::TAX }, { "TAY", Op::TAY },
+    { "TXA", Op::TXA }, { "TYA", Op::TYA }, { "TSX", Op::TSX }, { "TXS", Op::TXS },
+    { "INX", Op::INX }, { "INY", Op::INY }, { "DEX", Op::DEX }, { "DEY", Op::DEY },
+    { "CLC", Op::CLC }, { "SEC", Op::SEC }, { "CLD", Op::CLD }, { "SED", Op::SED },
+    { "CLI", Op::CLI }, { "SEI", Op::SEI }, { "CLV", Op::CLV }, { "PHA", Op::PHA },
+    { "PHX", Op::PHX }, { "PHY", Op::PHY }, { "PHP", Op::PHP }, { "PLA", Op::PLA },
+    { "PLX", Op::PLX }, { "PLY", Op::PLY }, { "PLP", Op::PLP }, { "BCC", Op::BCC },
+    { "BCS", Op::BCS }, { "BEQ", Op::BEQ }, { "BNE", Op::BNE }, { "BMI", Op::BMI },
+    { "BPL", Op::BPL }, { "BVC", Op::BVC }, { "BVS", Op::BVS }, { "BRA", Op::BRA },
+    { "JMP", Op::JMP }, { "JSR", Op::JSR }, { "RTS", Op::RTS }, { "NOP", Op::NOP }
+};
+
+struct Suffix {
+    const char* name;
+    Mode mode;
+};
+
+constexpr Suffix suffixes[] = {
+    { "", Mode::Implied }, { "_ACC", Mode::Accumulator }, { "_IMM", Mode::Immediate },
+    { "_ZP", Mode::ZeroPage }, { "_ZP_X", Mode::ZeroPageX }, { "_ZP_Y", Mode::ZeroPageY },
+    { "_ABS", Mode::Absolute }, { "_ABS_X", Mode::AbsoluteX }, { "_ABS_Y", Mode::AbsoluteY },
+    { "_PRE_IND_X", Mode::IndirectX }, { "_POST_IND_Y", Mode::IndirectY }, { "_IND", Mode::Indirect }
+};
+
+// Whether text starts with prefix, or equals it when whole is set
+constexpr bool matches(const char* text, const char* prefix, bool whole) {
+    while (*prefix) {
+        if (*text++ != *prefix++) {
+            return false;
+        }
+    }
+    return !whole || *text == '\0';
+}
+
+constexpr WideOp classify(const char* fn, uint8_t bytes, uint8_t cycles) {
+    WideOp w = { Op::None, Mode::Other, bytes, cycles, false, false, false };
+    for (const Mnemonic& m : mnemonics) {
+        if (matches(fn, m.name, false) && (fn[3] == '\0' || fn[3] == '_')) {
+            w.op = m.op;
+        }
+    }
+    for (const Suffix& s : suffixes) {
+        if (matches(fn + 3, s.name, true)) {
+            w.mode = s.mode;
+        }
+    }
+    if (w.op == Op::None || w.mode == Mode::Other) {
+        return { Op::None, Mode::Other, bytes, cycles, false, false, false };
+    }
+    Op op = w.op;
+    // JMP and JSR only use their operand as an address, and the unassigned
+    // NOPs skip theirs without a read
+    if (op == Op::JMP || op == Op::JSR || op == Op::NOP) {
+        w.mode = Mode::Implied;
+    }
+    bool store = op == Op::STA || op == Op::STX || op == Op::STY || op == Op::STZ;
+    bool modify = op == Op::ASL || op == Op::LSR || op == Op::ROL || op == Op::ROR ||
+                  op == Op::INC || op == Op::DEC;
+    w.reads = w.mode != Mode::Implied && !store;
+    w.writes = store || (modify && w.mode != Mode::Implied);
+    w.penalty = (w.mode == Mode::AbsoluteX || w.mode == Mode::AbsoluteY || w.mode == Mode::IndirectY) &&
+                !store && op != Op::INC && op != Op::DEC;
+    return w;
+}
+
+constexpr WideOp wide_ops[256] = {
+    #define OPCODE(op, fn, bytes, cycles) classify(#fn, bytes, cycles),
+    #include "CPU65C02_opcodes.def"
+};
+
+static_assert(wide_ops[0xB1].op == Op::LDA && wide_ops[0xB1].mode == Mode::IndirectY && wide_ops[0xB1].penalty,
+              "LDA (zp),Y must classify as a penalised indirect load");
+static_assert(wide_ops[0x1A].op == Op::INC && wide_ops[0x1A].mode == Mode::Accumulator && wide_ops[0x1A].writes,
+              "INC A must classify as an accumulator read-modify-write");
+static_assert(wide_ops[0x6C].op == Op::None && wide_ops[0x0F].op == Op::None,
+              "JMP (abs) and the bit branches must be left to the lanes");
+
+unsigned lowest_lane(uint32_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(bits);
+#else
+    unsigned i = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+unsigned lane_count(uint32_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount(bits);
+#else
+    unsigned n = 0;
+    for (; bits; bits &= bits - 1) {
+        n++;
+    }
+    return n;
+#endif
+}
+
+// Bytes of a where mask is 0xFF, of b where it is 0; vectorizes to a blend
+CPU65C02_INLINE uint8_t select(uint8_t mask, uint8_t a, uint8_t b) {
+    return (a & mask) | (b & ~mask);
+}
+
+} // namespace
+
+WideCPU::WideCPU(unsigned lane_count)
+    : lanes(lane_count < MAX_LANES ? lane_count : MAX_LANES), state(new Lanes()), active(0), code_checks(),
+      code_generation(1), wide_instructions(0), scalar_instructions(0) {
+    for (unsigned i = 0; i < MAX_LANES; i++) {
+        memories[i] = nullptr;
+        stop_reasons[i] = CPU65C02::StopReason::Budget;
+    }
+    for (unsigned i = 0; i < lanes; i++) {
+        cpus[i].reset(new CPU65C02());
+        memories[i] = &cpus[i]->memory;
+    }
+}
+
+WideCPU::~WideCPU() {
+}
+
+void WideCPU::run_cycles(uint64_t n) {
+    run<false>(n);
+}
+
+void WideCPU::run_instructions(uint64_t n) {
+    run<true>(n);
+}
+
+bool WideCPU::runs_alone(unsigned i) const {
+    const CPU65C02& cpu = *cpus[i];
+    if (cpu.debug || cpu.waiting || cpu.nmi_pending || cpu.irq_lines || cpu.recorder || cpu.profiler ||
+        !cpu.scheduler.empty() || !cpu.breakpoints.empty() || cpu.memory.has_traps()) {
+        return true;
+    }
+    for (unsigned p = 0; p < Memory::PAGE_COUNT; p++) {
+        if (cpu.memory.is_io(p)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Lanes that step together run wide while they agree; whenever they do
+// not, the lanes at the lowest PC go on alone (wide between themselves)
+// until they catch up with the others, which is where lanes that split on
+// a forward branch, or left a loop after different counts, meet again.
+template <bool CountInstructions>
+void WideCPU::run(uint64_t n) {
+    Lanes& l = *state;
+    uint32_t loaded = 0;
+    active = 0;
+    for (unsigned i = 0; i < lanes; i++) {
+        CPU65C02& cpu = *cpus[i];
+        stop_reasons[i] = CPU65C02::StopReason::Budget;
+        if (runs_alone(i)) {
+            stop_reasons[i] = CountInstructions ? cpu.run_instructions(n) : cpu.run_cycles(n);
+            continue;
+        }
+        load_lane(i);
+        loaded |= 1u << i;
+        if (CountInstructions) {
+            l.budget[i] = n;
+        } else {
+            l.budget[i] = n > UINT64_MAX - cpu.cycles ? UINT64_MAX : cpu.cycles + n;
+        }
+        if (l.budget[i] != 0 && (CountInstructions || l.cycles[i] < l.budget[i])) {
+            active |= 1u << i;
+        }
+    }
+
+    code_generation++;  // The lanes may have been changed since the last run
+    while (active) {
+        uint16_t low = 0xFFFF;
+        for (uint32_t bits = active; bits; bits &= bits - 1) {
+            unsigned i = lowest_lane(bits);
+            low = l.PC[i] < low ? l.PC[i] : low;
+        }
+        uint32_t group = 0;
+        unsigned parked = 0x10000; // Lowest PC of the lanes left behind
+        for (uint32_t bits = active; bits; bits &= bits - 1) {
+            unsigned i = lowest_lane(bits);
+            if (l.PC[i] == low) {
+                group |= 1u << i;
+            } else if (l.PC[i] < parked) {
+                parked = l.PC[i];
+            }
+        }
+        uint64_t executed = run_wide(group, parked, CountInstructions);
+        wide_instructions += executed;
+        if (executed == 0) {
+            for (uint32_t bits = group; bits; bits &= bits - 1) {
+                step_scalar(lowest_lane(bits), CountInstructions);
+            }
+            code_generation++;
+        }
+    }
+
+    for (uint32_t bits = loaded; bits; bits &= bits - 1) {
+        unsigned i = lowest_lane(bits);
+        CPU65C02& cpu = *cpus[i];
+        cpu.regs = { l.PC[i], l.A[i], l.X[i], l.Y[i], l.S[i], l.status[i],
+                     l.flag_n[i], l.flag_z[i], l.flag_c[i], l.flag_v[i] };
+        cpu.cycles = l.cycles[i];
+    }
+}
+
+void WideCPU::load_lane(unsigned i) {
+    Lanes& l = *state;
+    const CPU65C02& cpu = *cpus[i];
+    const CPU65C02::Registers& r = cpu.regs;
+    l.PC[i] = r.PC;
+    l.A[i] = r.A;
+    l.X[i] = r.X;
+    l.Y[i] = r.Y;
+    l.S[i] = r.S;
+    l.status[i] = r.status;
+    l.flag_n[i] = r.flag_n;
+    l.flag_z[i] = r.flag_z;
+    l.flag_c[i] = r.flag_c;
+    l.flag_v[i] = r.flag_v;
+    l.cycles[i] = cpu.cycles;
+}
+
+void WideCPU::stop_lane(unsigned i, CPU65C02::StopReason reason) {
+    stop_reasons[i] = reason;
+    active &= ~(1u << i);
+    state->live[i] = 0;
+}
+
+// One instruction on the lane's own engine, for everything run_wide()
+// leaves alone
+void WideCPU::step_scalar(unsigned i, bool count_instructions) {
+    Lanes& l = *state;
+    CPU65C02& cpu = *cpus[i];
+    cpu.regs = { l.PC[i], l.A[i], l.X[i], l.Y[i], l.S[i], l.status[i],
+                 l.flag_n[i], l.flag_z[i], l.flag_c[i], l.flag_v[i] };
+    cpu.cycles = l.cycles[i];
+    CPU65C02::StopReason reason = cpu.run_instructions(1);
+    load_lane(i);
+    scalar_instructions++;
+    bool spent = count_instructions ? --l.budget[i] == 0 : l.cycles[i] >= l.budget[i];
+    // As in CPU65C02::run(), a WAI that spends the last of a cycle budget
+    // ends the run on the budget
+    if (reason == CPU65C02::StopReason::Wait && !count_instructions && spent) {
+        reason = CPU65C02::StopReason::Budget;
+    }
+    if (reason != CPU65C02::StopReason::Budget || spent) {
+        stop_lane(i, reason);
+    }
+}
+
+// Whether every lane in group holds the same bytes in page. Lanes reading
+// one shared copy of it trivially do; lanes that loaded the program into
+// private copies are compared once, and the answer holds until the next
+// write to the page.
+bool WideCPU::same_page(uint32_t group, unsigned page) {
+    CodeCheck& check = code_checks[page];
+    bool known = check.generation == code_generation &&
+                 (check.group == group || (check.same && (check.group & group) == group));
+    if (known) {
+        return check.same;
+    }
+    const uint8_t* bytes = memories[lowest_lane(group)]->read_page(page);
+    bool same = bytes != nullptr;
+    for (uint32_t bits = group & (group - 1); bits && same; bits &= bits - 1) {
+        const uint8_t* other = memories[lowest_lane(bits)]->read_page(page);
+        same = other == bytes || (other && memcmp(other, bytes, Memory::PAGE_SIZE) == 0);
+    }
+    check = { group, code_generation, same };
+    return same;
+}
+
+// The instruction at pc, if every lane in group has the same one. Where
+// the lanes differ somewhere in the page, or the instruction runs into the
+// next one, its bytes are compared lane by lane.
+bool WideCPU::fetch_shared(uint32_t group, uint16_t pc, uint8_t* bytes) {
+    unsigned page = pc >> 8, offset = pc & 0xFF;
+    unsigned first = lowest_lane(group);
+    if (offset <= 0xFD && same_page(group, page)) {
+        memcpy(bytes, memories[first]->read_page(page) + offset, 3);
+        return true;
+    }
+    bytes[0] = memories[first]->read(pc);
+    unsigned length = wide_ops[bytes[0]].bytes;
+    for (unsigned k = 0; k < 3; k++) {
+        uint16_t addr = pc + k;
+        bytes[k] = k < length ? memories[first]->read(addr) : 0;
+        for (uint32_t bits = group & (group - 1); bits && k < length; bits &= bits - 1) {
+            if (memories[lowest_lane(bits)]->read(addr) != bytes[k]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Charge every live lane cycles, and instructions against its budget
+void WideCPU::charge(uint64_t cycles, uint64_t instructions) {
+    Lanes& l = *state;
+    for (unsigned i = 0; i < MAX_LANES; i++) {
+        uint64_t live = (uint64_t)(int64_t)(int8_t)l.live[i];
+        l.cycles[i] += cycles & live;
+        l.budget[i] -= instructions & live;
+    }
+}
+
+// The fewest instructions, or cycles, any lane in group has left
+uint64_t WideCPU::budget_slack(uint32_t group, bool count_instructions) const {
+    const Lanes& l = *state;
+    uint64_t slack = UINT64_MAX;
+    for (uint32_t bits = group; bits; bits &= bits - 1) {
+        unsigned i = lowest_lane(bits);
+        uint64_t left = count_instructions ? l.budget[i] : l.budget[i] - l.cycles[i];
+        slack = left < slack ? left : slack;
+    }
+    return slack;
+}
+
+// Runs the lanes in group, which are all at one PC, for as long as they
+// share their instructions and the wide core handles them. Register and
+// flag updates are loops over every lane, blended on live so the others
+// keep their state, which the compiler turns into a few vector operations
+// each; memory accesses go lane by lane. Stops when the lanes split up,
+// the last of them spends its budget, or they reach parked, where other
+// lanes wait to join them. Returns the instructions executed, summed over
+// the lanes.
+uint64_t WideCPU::run_wide(uint32_t group, unsigned parked, bool count_instructions) {
+    Lanes& l = *state;
+    const unsigned N = MAX_LANES;
+    uint16_t pc = l.PC[lowest_lane(group)];
+    for (unsigned i = 0; i < N; i++) {
+        l.live[i] = (group >> i) & 1 ? 0xFF : 0;
+    }
+    alignas(32) uint8_t m[N] = {}, r[N] = {}, extra[N] = {}, taken[N] = {};
+    alignas(32) uint16_t ea[N] = {};
+    uint64_t executed = 0;
+    bool split = false;
+    // Cycles every lane has taken but not been charged yet, and the
+    // instructions or cycles until the first lane could spend its budget;
+    // until then a step only adds to these
+    uint64_t pending = 0, steps = 0, spent = 0;
+    uint64_t slack = budget_slack(group, count_instructions);
+    while (group && pc < parked && !split) {
+        uint8_t code[3];
+        if (!fetch_shared(group, pc, code)) {
+            break;
+        }
+        const WideOp& w = wide_ops[code[0]];
+        if (w.op == Op::None) {
+            break;
+        }
+        if (w.op == Op::ADC || w.op == Op::SBC) {
+            uint8_t decimal = 0;
+            for (unsigned i = 0; i < N; i++) {
+                decimal |= l.status[i] & l.live[i];
+            }
+            if (decimal & 0x08) {
+                break;  // Decimal results come from the lanes' BCD tables
+            }
+        }
+        uint8_t zp = code[1];
+        uint16_t operand = code[1] | (code[2] << 8);
+        uint16_t next = pc + w.bytes;
+        unsigned cycles = w.cycles;  // The same for every lane
+        bool penalised = false;      // Lanes add extra[] to it
+
+        // Effective addresses
+        switch (w.mode) {
+        case Mode::ZeroPage:
+            for (unsigned i = 0; i < N; i++) ea[i] = zp;
+            break;
+        case Mode::ZeroPageX:
+            for (unsigned i = 0; i < N; i++) ea[i] = (uint8_t)(zp + l.X[i]);
+            break;
+        case Mode::ZeroPageY:
+            for (unsigned i = 0; i < N; i++) ea[i] = (uint8_t)(zp + l.Y[i]);
+            break;
+        case Mode::Absolute:
+            for (unsigned i = 0; i < N; i++) ea[i] = operand;
+            break;
+        case Mode::AbsoluteX:
+        case Mode::AbsoluteY: {
+            const uint8_t* index = w.mode == Mode::AbsoluteX ? l.X : l.Y;
+            for (unsigned i = 0; i < N; i++) {
+                ea[i] = operand + index[i];
+                extra[i] = w.penalty & (((operand ^ ea[i]) >> 8) & 1);
+            }
+            penalised = w.penalty;
+            break;
+        }
+        case Mode::IndirectX:
+        case Mode::IndirectY:
+        case Mode::Indirect:
+            for (uint32_t bits = group; bits; bits &= bits - 1) {
+                unsigned i = lowest_lane(bits);
+                uint8_t pointer = w.mode == Mode::IndirectX ? (uint8_t)(zp + l.X[i]) : zp;
+                uint16_t base = memories[i]->read(pointer) | (memories[i]->read((uint8_t)(pointer + 1)) << 8);
+                ea[i] = w.mode == Mode::IndirectY ? (uint16_t)(base + l.Y[i]) : base;
+                extra[i] = w.penalty & (((base ^ ea[i]) >> 8) & 1);
+            }
+            penalised = w.penalty;
+            break;
+        default:
+            break;
+        }
+
+        // Operands
+        if (w.reads) {
+            if (w.mode == Mode::Immediate) {
+                for (unsigned i = 0; i < N; i++) m[i] = zp;
+            } else if (w.mode == Mode::Accumulator) {
+                for (unsigned i = 0; i < N; i++) m[i] = l.A[i];
+            } else {
+                for (uint32_t bits = group; bits; bits &= bits - 1) {
+                    unsigned i = lowest_lane(bits);
+                    m[i] = memories[i]->read(ea[i]);
+                }
+            }
+        }
+
+        // Sets a register and N/Z to r on the live lanes
+        #define WIDE_LOAD(reg)                                      \
+            for (unsigned i = 0; i < N; i++) {                      \
+                l.reg[i] = select(l.live[i], r[i], l.reg[i]);       \
+                l.flag_n[i] = select(l.live[i], r[i], l.flag_n[i]); \
+                l.flag_z[i] = select(l.live[i], r[i], l.flag_z[i]); \
+            }
+        // N/Z and C from comparing reg with the operand
+        #define WIDE_COMPARE(reg)                                              \
+            for (unsigned i = 0; i < N; i++) {                                 \
+                uint8_t result = l.reg[i] - m[i];                              \
+                l.flag_n[i] = select(l.live[i], result, l.flag_n[i]);          \
+                l.flag_z[i] = select(l.live[i], result, l.flag_z[i]);          \
+                l.flag_c[i] = select(l.live[i], l.reg[i] >= m[i], l.flag_c[i]); \
+            }
+        // Result and carry of a shift or rotate on the live lanes, then N/Z
+        #define WIDE_SHIFT(result, carry)                                 \
+            for (unsigned i = 0; i < N; i++) {                            \
+                uint8_t c = l.flag_c[i];                                  \
+                r[i] = (uint8_t)(result);                                 \
+                l.flag_c[i] = select(l.live[i], (uint8_t)(carry), c);     \
+                l.flag_n[i] = select(l.live[i], r[i], l.flag_n[i]);       \
+                l.flag_z[i] = select(l.live[i], r[i], l.flag_z[i]);       \
+            }
+        #define WIDE_FLAGS_FROM_R()                                 \
+            for (unsigned i = 0; i < N; i++) {                      \
+                l.flag_n[i] = select(l.live[i], r[i], l.flag_n[i]); \
+                l.flag_z[i] = select(l.live[i], r[i], l.flag_z[i]); \
+            }
+        #define WIDE_SET(field, value)                                         \
+            for (unsigned i = 0; i < N; i++) {                                 \
+                l.field[i] = select(l.live[i], (uint8_t)(value), l.field[i]);  \
+            }
+        // Conditional branches: taken[i] is 0 or 1
+        #define WIDE_BRANCH(condition)                     \
+            for (unsigned i = 0; i < N; i++) {             \
+                taken[i] = (condition) ? 1 : 0;            \
+            }
+
+        bool branch = false;
+        uint16_t target = next;
+        switch (w.op) {
+        case Op::LDA:
+            for (unsigned i = 0; i < N; i++) r[i] = m[i];
+            WIDE_LOAD(A);
+            break;
+        case Op::LDX:
+            for (unsigned i = 0; i < N; i++) r[i] = m[i];
+            WIDE_LOAD(X);
+            break;
+        case Op::LDY:
+            for (unsigned i = 0; i < N; i++) r[i] = m[i];
+            WIDE_LOAD(Y);
+            break;
+        case Op::STA:
+            for (unsigned i = 0; i < N; i++) r[i] = l.A[i];
+            break;
+        case Op::STX:
+            for (unsigned i = 0; i < N; i++) r[i] = l.X[i];
+            break;
+        case Op::STY:
+            for (unsigned i = 0; i < N; i++) r[i] = l.Y[i];
+            break;
+        case Op::STZ:
+            for (unsigned i = 0; i < N; i++) r[i] = 0;
+            break;
+        case Op::AND:
+            for (unsigned i = 0; i < N; i++) r[i] = l.A[i] & m[i];
+            WIDE_LOAD(A);
+            break;
+        case Op::ORA:
+            for (unsigned i = 0; i < N; i++) r[i] = l.A[i] | m[i];
+            WIDE_LOAD(A);
+            break;
+        case Op::EOR:
+            for (unsigned i = 0; i < N; i++) r[i] = l.A[i] ^ m[i];
+            WIDE_LOAD(A);
+            break;
+        case Op::SBC:
+            for (unsigned i = 0; i < N; i++) m[i] = ~m[i];
+            [[fallthrough]];  // Binary SBC adds the complement
+        case Op::ADC:
+            for (unsigned i = 0; i < N; i++) {
+                uint16_t sum = l.A[i] + m[i] + l.flag_c[i];
+                r[i] = (uint8_t)sum;
+                l.flag_v[i] = select(l.live[i], (l.A[i] ^ sum) & (m[i] ^ sum), l.flag_v[i]);
+                l.flag_c[i] = select(l.live[i], sum >> 8, l.flag_c[i]);
+            }
+            WIDE_LOAD(A);
+            break;
+        case Op::CMP:
+            WIDE_COMPARE(A);
+            break;
+        case Op::CPX:
+            WIDE_COMPARE(X);
+            break;
+        case Op::CPY:
+            WIDE_COMPARE(Y);
+            break;
+        case Op::BIT:
+            for (unsigned i = 0; i < N; i++) {
+                uint8_t live = w.mode == Mode::Immediate ? 0 : l.live[i];  // BIT #imm only sets Z
+                l.flag_n[i] = select(live, m[i], l.flag_n[i]);
+                l.flag_v[i] = select(live, m[i] << 1, l.flag_v[i]);
+                l.flag_z[i] = select(l.live[i], l.A[i] & m[i], l.flag_z[i]);
+            }
+            break;
+        case Op::ASL:
+            WIDE_SHIFT(m[i] << 1, m[i] >> 7);
+            break;
+        case Op::LSR:
+            WIDE_SHIFT(m[i] >> 1, m[i] & 1);
+            break;
+        case Op::ROL:
+            WIDE_SHIFT((m[i] << 1) | c, m[i] >> 7);
+            break;
+        case Op::ROR:
+            WIDE_SHIFT((m[i] >> 1) | (c << 7), m[i] & 1);
+            break;
+        case Op::INC:
+            for (unsigned i = 0; i < N; i++) r[i] = m[i] + 1;
+            WIDE_FLAGS_FROM_R();
+            break;
+        case Op::DEC:
+            for (unsigned i = 0; i < N; i++) r[i] = m[i] - 1;
+            WIDE_FLAGS_FROM_R();
+            break;
+        case Op::TAX:
+            for (unsigned i = 0; i < N; i++) r[i] = l.A[i];
+            WIDE_LOAD(X);
+            break;
+        case Op::TAY:
+            for (unsigned i = 0; i < N; i++) r[i] = l.A[i];
+            WIDE_LOAD(Y);
+            break;
+        case Op::TXA:
+            for (unsigned i = 0; i < N; i++) r[i] = l.X[i];
+            WIDE_LOAD(A);
+            break;
+        case Op::TYA:
+            for (unsigned i = 0; i < N; i++) r[i] = l.Y[i];
+            WIDE_LOAD(A);
+            break;
+        case Op::TSX:
+            for (unsigned i = 0; i < N; i++) r[i] = l.S[i];
+            WIDE_LOAD(X);
+            break;
+        case Op::TXS:
+            WIDE_SET(S, l.X[i]);
+            break;
+        case Op::INX:
+            for (unsigned i = 0; i < N; i++) r[i] = l.X[i] + 1;
+            WIDE_LOAD(X);
+            break;
+        case Op::INY:
+            for (unsigned i = 0; i < N; i++) r[i] = l.Y[i] + 1;
+            WIDE_LOAD(Y);
+            break;
+        case Op::DEX:
+            for (unsigned i = 0; i < N; i++) r[i] = l.X[i] - 1;
+            WIDE_LOAD(X);
+            break;
+        case Op::DEY:
+            for (unsigned i = 0; i < N; i++) r[i] = l.Y[i] - 1;
+            WIDE_LOAD(Y);
+            break;
+        case Op::CLC:
+            WIDE_SET(flag_c, 0);
+            break;
+        case Op::SEC:
+            WIDE_SET(flag_c, 1);
+            break;
+        case Op::CLV:
+            WIDE_SET(flag_v, 0);
+            break;
+        // The lanes that run wide have no interrupt pending, so CLI and PLP
+        // have none to poll for
+        case Op::CLD:
+            WIDE_SET(status, l.status[i] & ~0x08);
+            break;
+        case Op::SED:
+            WIDE_SET(status, l.status[i] | 0x08);
+            break;
+        case Op::CLI:
+            WIDE_SET(status, l.status[i] & ~0x04);
+            break;
+        case Op::SEI:
+            WIDE_SET(status, l.status[i] | 0x04);
+            break;
+        case Op::PHA:
+        case Op::PHX:
+        case Op::PHY:
+        case Op::PHP: {
+            const uint8_t* source = w.op == Op::PHA ? l.A : w.op == Op::PHX ? l.X : l.Y;
+            for (unsigned i = 0; i < N; i++) {
+                uint8_t p = (l.status[i] & 0x3C) | (l.flag_n[i] & 0x80) | ((l.flag_v[i] & 0x80) >> 1) |
+                            (l.flag_z[i] ? 0 : 0x02) | l.flag_c[i] | 0x30;
+                r[i] = w.op == Op::PHP ? p : source[i];
+                ea[i] = 0x100 + l.S[i];
+            }
+            WIDE_SET(S, l.S[i] - 1);
+            break;
+        }
+        case Op::PLA:
+        case Op::PLX:
+        case Op::PLY:
+        case Op::PLP:
+            WIDE_SET(S, l.S[i] + 1);
+            for (uint32_t bits = group; bits; bits &= bits - 1) {
+                unsigned i = lowest_lane(bits);
+                r[i] = memories[i]->read(0x100 + l.S[i]);
+            }
+            if (w.op == Op::PLA) {
+                WIDE_LOAD(A);
+            } else if (w.op == Op::PLX) {
+                WIDE_LOAD(X);
+            } else if (w.op == Op::PLY) {
+                WIDE_LOAD(Y);
+            } else {
+                WIDE_SET(status, r[i] & 0x3C);
+                WIDE_SET(flag_n, r[i]);
+                WIDE_SET(flag_z, ~r[i] & 0x02);
+                WIDE_SET(flag_c, r[i] & 0x01);
+                WIDE_SET(flag_v, r[i] << 1);
+            }
+            break;
+        case Op::BCC:
+            WIDE_BRANCH(!l.flag_c[i]);
+            branch = true;
+            break;
+        case Op::BCS:
+            WIDE_BRANCH(l.flag_c[i]);
+            branch = true;
+            break;
+        case Op::BEQ:
+            WIDE_BRANCH(!l.flag_z[i]);
+            branch = true;
+            break;
+        case Op::BNE:
+            WIDE_BRANCH(l.flag_z[i]);
+            branch = true;
+            break;
+        case Op::BMI:
+            WIDE_BRANCH(l.flag_n[i] & 0x80);
+            branch = true;
+            break;
+        case Op::BPL:
+            WIDE_BRANCH(!(l.flag_n[i] & 0x80));
+            branch = true;
+            break;
+        case Op::BVC:
+            WIDE_BRANCH(!(l.flag_v[i] & 0x80));
+            branch = true;
+            break;
+        case Op::BVS:
+            WIDE_BRANCH(l.flag_v[i] & 0x80);
+            branch = true;
+            break;
+        case Op::BRA:
+            target = next + (int8_t)zp;
+            break;
+        case Op::JMP:
+            target = operand;
+            break;
+        case Op::JSR:
+            // Pushes the address of its own last byte, high byte first
+            for (uint32_t bits = group; bits; bits &= bits - 1) {
+                unsigned i = lowest_lane(bits);
+                memories[i]->write(0x100 + l.S[i], (next - 1) >> 8);
+                memories[i]->write(0x100 + (uint8_t)(l.S[i] - 1), (next - 1) & 0xFF);
+            }
+            WIDE_SET(S, l.S[i] - 2);
+            code_checks[0x01].generation = 0;
+            target = operand;
+            break;
+        case Op::RTS: {
+            uint32_t bits = group;
+            unsigned first = lowest_lane(bits);
+            for (; bits; bits &= bits - 1) {
+                unsigned i = lowest_lane(bits);
+                uint16_t low = memories[i]->read(0x100 + (uint8_t)(l.S[i] + 1));
+                uint16_t high = memories[i]->read(0x100 + (uint8_t)(l.S[i] + 2));
+                ea[i] = ((high << 8) | low) + 1;
+                split |= ea[i] != ea[first];
+            }
+            WIDE_SET(S, l.S[i] + 2);
+            if (split) {
+                for (uint32_t bits = group; bits; bits &= bits - 1) {
+                    unsigned i = lowest_lane(bits);
+                    l.PC[i] = ea[i];
+                }
+            }
+            target = ea[first];
+            break;
+        }
+        default:
+            break;
+        }
+
+        // Results to memory, or to A
+        if (w.writes && w.mode == Mode::Accumulator) {
+            for (unsigned i = 0; i < N; i++) l.A[i] = select(l.live[i], r[i], l.A[i]);
+        } else if (w.writes || w.op == Op::PHA || w.op == Op::PHX || w.op == Op::PHY || w.op == Op::PHP) {
+            for (uint32_t bits = group; bits; bits &= bits - 1) {
+                unsigned i = lowest_lane(bits);
+                memories[i]->write(ea[i], r[i]);
+                code_checks[ea[i] >> 8].generation = 0;
+            }
+        }
+
+        // Branches, taken by all the lanes, none of them, or some of each
+        if (branch) {
+            uint8_t any = 0, all = 1;
+            for (unsigned i = 0; i < N; i++) {
+                any |= taken[i] & l.live[i];
+                all &= taken[i] | (uint8_t)~l.live[i];
+            }
+            uint16_t destination = next + (int8_t)zp;
+            uint8_t penalty = 1 + (((next ^ destination) >> 8) & 1);
+            if (any && !all) {
+                split = true;
+                penalised = true;
+                for (unsigned i = 0; i < N; i++) {
+                    extra[i] = taken[i] ? penalty : 0;
+                }
+                for (uint32_t bits = group; bits; bits &= bits - 1) {
+                    unsigned i = lowest_lane(bits);
+                    l.PC[i] = taken[i] ? destination : next;
+                }
+            } else if (any) {
+                cycles += penalty;
+            }
+            target = any ? destination : next;
+        }
+        if (w.op == Op::BRA) {
+            cycles += 1 + (((next ^ target) >> 8) & 1);
+        }
+
+        #undef WIDE_LOAD
+        #undef WIDE_COMPARE
+        #undef WIDE_SHIFT
+        #undef WIDE_FLAGS_FROM_R
+        #undef WIDE_SET
+        #undef WIDE_BRANCH
+
+        // Cycles and budgets
+        executed += lane_count(group);
+        pc = target;
+        pending += cycles;
+        steps++;
+        spent += cycles + (penalised ? 2 : 0);
+        if (penalised) {
+            for (unsigned i = 0; i < N; i++) {
+                l.cycles[i] += extra[i] & l.live[i];
+            }
+        }
+        if ((count_instructions ? steps : spent) >= slack) {
+            charge(pending, count_instructions ? steps : 0);
+            pending = steps = spent = 0;
+            for (uint32_t bits = group; bits; bits &= bits - 1) {
+                unsigned i = lowest_lane(bits);
+                if (count_instructions ? l.budget[i] == 0 : l.cycles[i] >= l.budget[i]) {
+                    l.PC[i] = split ? l.PC[i] : pc;
+                    stop_lane(i, CPU65C02::StopReason::Budget);
+                    group &= ~(1u << i);
+                }
+            }
+            slack = budget_slack(group, count_instructions);
+        }
+    }
+    charge(pending, count_instructions ? steps : 0);
+    // Lanes that split up already hold their own PCs
+    if (!split) {
+        for (uint32_t bits = group; bits; bits &= bits - 1) {
+            l.PC[lowest_lane(bits)] = pc;
+        }
+    }
+    return executed;
+}
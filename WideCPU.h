@@ -0,0 +1,105 @@
+#ifndef WIDE_CPU_H
+#define WIDE_CPU_H
+
+#include "CPU65C02.h"
+#include <cstdint>
+#include <memory>
+
+// The wide core's lane loops are compiled twice, for AVX2 and for the
+// baseline ISA, and the loader picks one on the running CPU. That needs
+// GCC/Clang's target_clones, which resolves through an ELF ifunc.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__) && defined(__linux__)
+#define CPU65C02_WIDE_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define CPU65C02_WIDE_CLONES
+#endif
+
+// Runs up to MAX_LANES CPUs that share a program but not their data, such
+// as the cases of a fuzz or Monte Carlo run, and executes the instructions
+// they have in common once for all of them.
+//
+// Each lane is an ordinary CPU65C02 holding that lane's memory and state
+// between runs; set lanes up and read results through lane(). During a run
+// the registers are kept as a struct of arrays, one byte per lane in the
+// same raw form as CPU65C02::Registers, so an instruction is a handful of
+// vector operations over every lane. Memory accesses are still made lane
+// by lane, through each lane's page table.
+//
+// Lanes step together while they sit at the same PC on the same code. A
+// branch taken by some lanes and not others, a return to different
+// addresses, or an instruction the wide core leaves alone (decimal ADC and
+// SBC, BRK, RTI, WAI, STP, JMP indirect, TRB, TSB and the bit instructions)
+// runs lane by lane on the lane's own engine instead. Once lanes have split
+// up, those at the lowest PC run on (wide between themselves) until they
+// catch up with the rest.
+//
+// Lanes with anything a wide step cannot see run alone, on their own
+// engine: I/O pages, scheduled events, a pending interrupt, a WAI, debug
+// output, a recorder, a profiler, breakpoints or watchpoints.
+class WideCPU {
+public:
+    static const unsigned MAX_LANES = 32; // One AVX2 register of bytes
+
+    explicit WideCPU(unsigned lanes = MAX_LANES);
+    ~WideCPU();
+    WideCPU(const WideCPU&) = delete;
+    WideCPU& operator=(const WideCPU&) = delete;
+
+    unsigned get_lanes() const { return lanes; }
+    CPU65C02& lane(unsigned i) { return *cpus[i]; }
+
+    // Give every lane the budget CPU65C02::run_cycles()/run_instructions()
+    // would, and run until each has spent it or stopped. Each lane ends in
+    // the state running it alone would leave it in.
+    void run_cycles(uint64_t n);
+    void run_instructions(uint64_t n);
+    CPU65C02::StopReason get_stop_reason(unsigned i) const { return stop_reasons[i]; }
+
+    // Instructions executed for all lanes at once, and lane by lane, summed
+    // over the lanes and every run so far
+    uint64_t get_wide_instructions() const { return wide_instructions; }
+    uint64_t get_scalar_instructions() const { return scalar_instructions; }
+
+private:
+    // Lane state for the duration of a run, copied back to the lanes' CPUs
+    // at its end. Lanes that stopped keep the state they stopped in.
+    struct alignas(32) Lanes {
+        uint8_t A[MAX_LANES], X[MAX_LANES], Y[MAX_LANES], S[MAX_LANES], status[MAX_LANES];
+        uint8_t flag_n[MAX_LANES], flag_z[MAX_LANES], flag_c[MAX_LANES], flag_v[MAX_LANES];
+        uint8_t live[MAX_LANES]; // 0xFF for the lanes run_wide() is running, else 0
+        uint16_t PC[MAX_LANES];
+        uint64_t cycles[MAX_LANES];
+        uint64_t budget[MAX_LANES]; // Cycle deadline, or instructions left
+    };
+
+    unsigned lanes;
+    std::unique_ptr<CPU65C02> cpus[MAX_LANES];
+    Memory* memories[MAX_LANES];
+    CPU65C02::StopReason stop_reasons[MAX_LANES];
+    std::unique_ptr<Lanes> state;
+    uint32_t active; // Bit per lane still running
+    // Whether the lanes of group hold the same bytes in a page, as of
+    // generation. Any write to the page resets its generation; anything run
+    // lane by lane may have written anywhere, so it bumps code_generation.
+    struct CodeCheck {
+        uint32_t group;
+        uint32_t generation;
+        bool same;
+    };
+    CodeCheck code_checks[Memory::PAGE_COUNT];
+    uint32_t code_generation;
+    uint64_t wide_instructions, scalar_instructions;
+
+    bool runs_alone(unsigned i) const;
+    template <bool CountInstructions> void run(uint64_t n);
+    void load_lane(unsigned i);
+    void stop_lane(unsigned i, CPU65C02::StopReason reason);
+    void step_scalar(unsigned i, bool count_instructions);
+    void charge(uint64_t cycles, uint64_t instructions);
+    uint64_t budget_slack(uint32_t group, bool count_instructions) const;
+    bool same_page(uint32_t group, unsigned page);
+    bool fetch_shared(uint32_t group, uint16_t pc, uint8_t* bytes);
+    CPU65C02_WIDE_CLONES uint64_t run_wide(uint32_t group, unsigned parked, bool count_instructions);
+};
+
+#endif // WIDE_CPU_H
@@ -0,0 +1,66 @@
+#include "BatchRunner.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+static void usage() {
+    cerr << "usage: 6502batch [-j threads] manifest" << endl;
+}
+
+int main(int argc, char** argv) {
+    unsigned threads = 0;
+    const char* manifest_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = strtoul(argv[++i], nullptr, 10);
+        } else if (argv[i][0] != '-' && !manifest_path) {
+            manifest_path = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!manifest_path) {
+        usage();
+        return 2;
+    }
+
+    vector<BatchJob> jobs;
+    try {
+        ifstream manifest(manifest_path);
+        if (!manifest) {
+            cerr << "cannot open manifest " << manifest_path << endl;
+            return 1;
+        }
+        string path = manifest_path;
+        size_t slash = path.rfind('/');
+        jobs = load_manifest(manifest, slash == string::npos ? "" : path.substr(0, slash));
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    BatchRunner runner(threads);
+    auto start = chrono::steady_clock::now();
+    vector<BatchResult> results = runner.run(jobs);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    uint64_t total_cycles = 0;
+    cout << "name,stop,pc,a,x,y,s,p,cycles,digest" << endl;
+    for (const BatchResult& r : results) {
+        const CPU65C02::Registers& regs = r.regs;
+        cout << r.name << ',' << CPU65C02::stop_reason_name(r.reason) << hex << setfill('0')
+             << ",$" << setw(4) << regs.PC << ",$" << setw(2) << (int)regs.A << ",$" << setw(2) << (int)regs.X
+             << ",$" << setw(2) << (int)regs.Y << ",$" << setw(2) << (int)regs.S << ",$" << setw(2) << (int)regs.P()
+             << dec << ',' << r.cycles << ',' << hex << setw(16) << r.memory_digest << dec << endl;
+        total_cycles += r.cycles;
+    }
+    cerr << results.size() << " jobs on " << runner.get_threads() << " threads in " << seconds << " s, "
+         << total_cycles / seconds / 1e6 << " emulated MHz aggregate" << endl;
+    return 0;
+}
@@ -0,0 +1,354 @@
+#include "CPU65C02.h"
+#include "Profiler.h"
+#include "WideCPU.h"
+#include "crc_program.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// Every benchmark runs one 6502 program at $0200 from start to BRK per
+// iteration, on the engine given as its argument. Instruction and cycle
+// counts come from one profiled run up front, so the timed runs carry no
+// instrumentation. The instructions and cycles counters are the raw counts
+// as rates, so they read as emulated instructions and cycles per second:
+// cycles=345M/s is a 345 MHz 6502.
+
+namespace {
+
+const char* const engine_names[] = { "table", "switch", "threaded", "block", "jit" };
+
+struct Kernel {
+    vector<uint8_t> code;
+    function<void(CPU65C02&)> setup; // Fills in data before the first run
+    function<bool(CPU65C02&)> check; // Whether the run computed the right thing
+    uint64_t irq_period = 0; // Cycles between timer interrupts, or 0 for none
+};
+
+// A timer on page $C0 that raises IRQ every period cycles through the
+// scheduler. Its handler at $0380 reads $C000 to acknowledge it and returns.
+class TimerIrq : public IoDevice, public EventHandler {
+public:
+    TimerIrq(CPU65C02& cpu, uint64_t period) : cpu(cpu), period(period) {
+        const uint8_t handler[] = { 0x2C, 0x00, 0xC0, 0x40 };  // BIT $C000; RTI
+        const uint8_t vector[] = { 0x80, 0x03 };
+        cpu.load_program(handler, sizeof(handler), 0x0380);
+        cpu.load_program(vector, sizeof(vector), 0xFFFE);
+        cpu.get_memory().map_io(0xC0, 0xC0, this);
+        cpu.get_scheduler().schedule(cpu.get_cycles() + period, this);
+    }
+
+    uint8_t read(uint16_t) override {
+        cpu.release_irq();
+        return 0;
+    }
+    void write(uint16_t, uint8_t) override {}
+
+    void fire(uint64_t time) override {
+        cpu.assert_irq();
+        cpu.get_scheduler().schedule(time + period, this);
+    }
+
+private:
+    CPU65C02& cpu;
+    uint64_t period;
+};
+
+// The kernel with CLI in front, run under a timer interrupt every period
+// cycles. Its counts include the interrupt handler.
+Kernel with_timer_irq(const Kernel& kernel, uint64_t period) {
+    Kernel timed = kernel;
+    timed.code.insert(timed.code.begin(), 0x58);  // CLI
+    timed.irq_period = period;
+    return timed;
+}
+
+// Wrap body in a loop that runs it 256 times: LDX #0; body; DEX; BNE; BRK.
+// The body is repeated as often as BNE can still reach back over it, up to
+// eight times.
+vector<uint8_t> loop_256(std::initializer_list<uint8_t> body) {
+    vector<uint8_t> code = { 0xA2, 0x00 };                 // LDX #$00
+    for (int i = 0; i < 8 && (i + 1) * body.size() + 3 <= 128; i++) {
+        code.insert(code.end(), body);
+    }
+    int back = -(int)(code.size() - 2 + 3);
+    code.insert(code.end(), { 0xCA, 0xD0, (uint8_t)back }); // DEX; BNE body
+    code.push_back(0x00);                                  // BRK
+    return code;
+}
+
+// ($20) points at $1000, for the (zp),Y forms
+void point_at_data(CPU65C02& cpu) {
+    cpu.get_memory().write(0x20, 0x00);
+    cpu.get_memory().write(0x21, 0x10);
+}
+
+void run_kernel(benchmark::State& state, const Kernel& kernel) {
+    CPU65C02::Engine engine = (CPU65C02::Engine)state.range(0);
+    CPU65C02 cpu;
+    cpu.set_engine(engine);
+    cpu.load_program(kernel.code.data(), kernel.code.size(), 0x0200);
+    if (kernel.setup) {
+        kernel.setup(cpu);
+    }
+    unique_ptr<TimerIrq> timer;
+    if (kernel.irq_period) {
+        timer.reset(new TimerIrq(cpu, kernel.irq_period));
+    }
+    state.SetLabel(engine_names[state.range(0)]);
+
+    Profiler profiler;
+    cpu.set_profiler(&profiler);
+    cpu.set_PC(0x0200);
+    uint64_t start = cpu.get_cycles();
+    if (cpu.run_cycles(100000000) != CPU65C02::StopReason::Brk) {
+        state.SkipWithError("kernel did not reach its BRK");
+        return;
+    }
+    cpu.set_profiler(nullptr);
+    uint64_t cycles = cpu.get_cycles() - start;
+    uint64_t instructions = 0;
+    for (unsigned op = 0; op < 256; op++) {
+        instructions += profiler.get_opcode_count(op);
+    }
+    if (kernel.check && !kernel.check(cpu)) {
+        state.SkipWithError("kernel computed the wrong result");
+        return;
+    }
+
+    for (auto _ : state) {
+        cpu.set_PC(0x0200);
+        cpu.run_cycles(UINT64_MAX);
+    }
+    state.counters["instructions"] = benchmark::Counter(instructions * state.iterations(),
+                                                        benchmark::Counter::kIsRate);
+    state.counters["cycles"] = benchmark::Counter(cycles * state.iterations(), benchmark::Counter::kIsRate);
+}
+
+// Instruction groups
+
+const Kernel loads = { loop_256({
+    0xA9, 0x12,        // LDA #$12
+    0xA5, 0x10,        // LDA $10
+    0xB5, 0x10,        // LDA $10,X
+    0xAD, 0x00, 0x10,  // LDA $1000
+    0xBD, 0x80, 0x10,  // LDA $1080,X (crosses a page half the time)
+    0xB1, 0x20,        // LDA ($20),Y
+    0xA0, 0x34,        // LDY #$34
+    0xA4, 0x10,        // LDY $10
+}), point_at_data, nullptr };
+
+const Kernel stores = { loop_256({
+    0x85, 0x10,        // STA $10
+    0x95, 0x10,        // STA $10,X
+    0x8D, 0x00, 0x10,  // STA $1000
+    0x9D, 0x00, 0x10,  // STA $1000,X
+    0x91, 0x20,        // STA ($20),Y
+    0x86, 0x11,        // STX $11
+    0x84, 0x12,        // STY $12
+    0x64, 0x13,        // STZ $13
+}), point_at_data, nullptr };
+
+const Kernel adc_sbc = { loop_256({
+    0x18,              // CLC
+    0x69, 0x01,        // ADC #$01
+    0x65, 0x10,        // ADC $10
+    0x7D, 0x00, 0x10,  // ADC $1000,X
+    0x38,              // SEC
+    0xE9, 0x01,        // SBC #$01
+    0xE5, 0x10,        // SBC $10
+    0xFD, 0x00, 0x10,  // SBC $1000,X
+}), nullptr, nullptr };
+
+const Kernel shifts = { loop_256({
+    0x2A,              // ROL A
+    0x6A,              // ROR A
+    0x26, 0x10,        // ROL $10
+    0x66, 0x10,        // ROR $10
+    0x2E, 0x00, 0x10,  // ROL $1000
+    0x7E, 0x00, 0x10,  // ROR $1000,X
+    0x0A,              // ASL A
+    0x4A,              // LSR A
+}), nullptr, nullptr };
+
+const Kernel branches = { loop_256({
+    0xD0, 0x00,        // BNE +0 (taken)
+    0xF0, 0x00,        // BEQ +0 (not taken)
+    0x90, 0x00,        // BCC +0
+    0xB0, 0x00,        // BCS +0
+    0x10, 0x00,        // BPL +0
+    0x30, 0x00,        // BMI +0
+    0x80, 0x00,        // BRA +0
+}), nullptr, nullptr };
+
+const Kernel stack_ops = { loop_256({
+    0x48,              // PHA
+    0xDA,              // PHX
+    0x5A,              // PHY
+    0x08,              // PHP
+    0x28,              // PLP
+    0x7A,              // PLY
+    0xFA,              // PLX
+    0x68,              // PLA
+}), nullptr, nullptr };
+
+// Realistic kernels
+
+// Copy 4KB from $1000 to $2000 a byte at a time through (zp),Y pointers
+const Kernel memcpy_4k = {
+    {
+        0xA9, 0x00,        // $0200 LDA #$00
+        0x85, 0xF0,        //       STA $F0      source
+        0x85, 0xF2,        //       STA $F2      destination
+        0xA9, 0x10,        //       LDA #$10
+        0x85, 0xF1,        //       STA $F1
+        0xA9, 0x20,        //       LDA #$20
+        0x85, 0xF3,        //       STA $F3
+        0xA2, 0x10,        //       LDX #$10     pages
+        0xA0, 0x00,        //       LDY #$00
+        0xB1, 0xF0,        // $0212 LDA ($F0),Y
+        0x91, 0xF2,        //       STA ($F2),Y
+        0xC8,              //       INY
+        0xD0, 0xF9,        //       BNE $0212
+        0xE6, 0xF1,        //       INC $F1
+        0xE6, 0xF3,        //       INC $F3
+        0xCA,              //       DEX
+        0xD0, 0xF2,        //       BNE $0212
+        0x00               //       BRK
+    },
+    [](CPU65C02& cpu) {
+        for (unsigned i = 0; i < 0x1000; i++) {
+            cpu.get_memory().write(0x1000 + i, (uint8_t)(i * 7 + 3));
+        }
+    },
+    [](CPU65C02& cpu) {
+        for (unsigned i = 0; i < 0x1000; i++) {
+            if (cpu.get_RAM(0x2000 + i) != (uint8_t)(i * 7 + 3)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// 16x16 -> 32-bit shift-and-add multiply of $1234 by every Y * $0101,
+// leaving the last product in $F4-$F7
+const Kernel multiply_16 = {
+    {
+        0xA0, 0x00,        // $0200 LDY #$00
+        0x84, 0xF2,        // $0202 STY $F2      multiplier = Y * $0101
+        0x84, 0xF3,        //       STY $F3
+        0xA9, 0x34,        //       LDA #$34
+        0x85, 0xF0,        //       STA $F0      multiplicand = $1234
+        0xA9, 0x12,        //       LDA #$12
+        0x85, 0xF1,        //       STA $F1
+        0x64, 0xF6,        //       STZ $F6      high half of the product
+        0x64, 0xF7,        //       STZ $F7
+        0xA2, 0x10,        //       LDX #16
+        0x18,              // $0214 CLC
+        0x66, 0xF3,        //       ROR $F3      multiplier >> 1
+        0x66, 0xF2,        //       ROR $F2
+        0x90, 0x0D,        //       BCC $0228
+        0x18,              //       CLC
+        0xA5, 0xF6,        //       LDA $F6      high half += multiplicand
+        0x65, 0xF0,        //       ADC $F0
+        0x85, 0xF6,        //       STA $F6
+        0xA5, 0xF7,        //       LDA $F7
+        0x65, 0xF1,        //       ADC $F1
+        0x85, 0xF7,        //       STA $F7
+        0x66, 0xF7,        // $0228 ROR $F7      product >> 1, with the carry
+        0x66, 0xF6,        //       ROR $F6
+        0x66, 0xF5,        //       ROR $F5
+        0x66, 0xF4,        //       ROR $F4
+        0xCA,              //       DEX
+        0xD0, 0xE1,        //       BNE $0214
+        0xC8,              //       INY
+        0xD0, 0xCC,        //       BNE $0202
+        0x00               //       BRK
+    },
+    nullptr,
+    [](CPU65C02& cpu) {
+        uint32_t product = cpu.get_RAM(0xF4) | (cpu.get_RAM(0xF5) << 8) |
+                           (cpu.get_RAM(0xF6) << 16) | ((uint32_t)cpu.get_RAM(0xF7) << 24);
+        return product == 0x1234u * 0xFFFFu;
+    }
+};
+
+// CRC-16/CCITT (polynomial $1021, initial $FFFF) of 1KB at $1000, bit by bit
+const Kernel crc16_1k = {
+    vector<uint8_t>(crc_program, crc_program + sizeof(crc_program)),
+    [](CPU65C02& cpu) { load_crc_data(cpu, 4, 0); },
+    [](CPU65C02& cpu) {
+        uint16_t crc = crc_expected(4, 0);
+        return cpu.get_RAM(0xF0) == (crc & 0xFF) && cpu.get_RAM(0xF1) == (crc >> 8);
+    }
+};
+
+// Interrupt-driven firmware: the same CRC under a 256-cycle timer IRQ
+const Kernel crc16_1k_irq256 = with_timer_irq(crc16_1k, 256);
+
+// The kernel on every lane of a WideCPU at once, each lane with its own
+// first data byte at $1000 so data-dependent branches split the lanes up.
+// Instructions and cycles are summed over the lanes. Kernels with an interrupt need
+// devices, which would make each lane run alone.
+void run_wide_kernel(benchmark::State& state, const Kernel& kernel) {
+    WideCPU wide;
+    for (unsigned i = 0; i < wide.get_lanes(); i++) {
+        CPU65C02& cpu = wide.lane(i);
+        cpu.load_program(kernel.code.data(), kernel.code.size(), 0x0200);
+        if (kernel.setup) {
+            kernel.setup(cpu);
+        }
+        if (i != 0) {
+            cpu.get_memory().write(0x1000, (uint8_t)(cpu.get_RAM(0x1000) + i));
+        }
+    }
+    uint64_t instructions = 0, cycles = 0;
+    for (auto _ : state) {
+        uint64_t start = 0;
+        for (unsigned i = 0; i < wide.get_lanes(); i++) {
+            wide.lane(i).set_PC(0x0200);
+            start += wide.lane(i).get_cycles();
+        }
+        uint64_t executed = wide.get_wide_instructions() + wide.get_scalar_instructions();
+        wide.run_cycles(100000000);
+        instructions += wide.get_wide_instructions() + wide.get_scalar_instructions() - executed;
+        for (unsigned i = 0; i < wide.get_lanes(); i++) {
+            cycles += wide.lane(i).get_cycles();
+        }
+        cycles -= start;
+    }
+    if (wide.get_stop_reason(0) != CPU65C02::StopReason::Brk || (kernel.check && !kernel.check(wide.lane(0)))) {
+        state.SkipWithError("kernel did not compute the right result");
+        return;
+    }
+    state.SetLabel("wide");
+    state.counters["instructions"] = benchmark::Counter(instructions, benchmark::Counter::kIsRate);
+    state.counters["cycles"] = benchmark::Counter(cycles, benchmark::Counter::kIsRate);
+}
+
+} // namespace
+
+#define BENCHMARK_KERNEL(name) \
+    BENCHMARK_CAPTURE(run_kernel, name, name)->DenseRange(0, 4)->ArgName("engine")
+
+BENCHMARK_KERNEL(loads);
+BENCHMARK_KERNEL(stores);
+BENCHMARK_KERNEL(adc_sbc);
+BENCHMARK_KERNEL(shifts);
+BENCHMARK_KERNEL(branches);
+BENCHMARK_KERNEL(stack_ops);
+BENCHMARK_KERNEL(memcpy_4k);
+BENCHMARK_KERNEL(multiply_16);
+BENCHMARK_KERNEL(crc16_1k);
+BENCHMARK_KERNEL(crc16_1k_irq256);
+
+BENCHMARK_CAPTURE(run_wide_kernel, loads, loads);
+BENCHMARK_CAPTURE(run_wide_kernel, multiply_16, multiply_16);
+BENCHMARK_CAPTURE(run_wide_kernel, crc16_1k, crc16_1k);
+
+BENCHMARK_MAIN();
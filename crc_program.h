@@ -0,0 +1,98 @@
+#ifndef CRC_PROGRAM_H
+#define CRC_PROGRAM_H
+
+#include "CPU65C02.h"
+#include <cstdint>
+
+// CRC-16/CCITT of the pages * 256 bytes at $1000 into $F0 (low) and $F1
+// (high), then BRK. The page count is read from $F5. It first calls a
+// subroutine at $0280 doing decimal arithmetic and stack operations, which
+// leaves $47 at $01FD, just below its return address. Shared by the tests
+// and bench_6502.
+static const uint8_t crc_program[] = {
+    0x20, 0x80, 0x02,  // $0200 JSR $0280
+    0xA9, 0xFF,        //       LDA #$FF
+    0x85, 0xF0,        //       STA $F0      CRC low
+    0x85, 0xF1,        //       STA $F1      CRC high
+    0x64, 0xF2,        //       STZ $F2      pointer = $1000
+    0xA9, 0x10,        //       LDA #$10
+    0x85, 0xF3,        //       STA $F3
+    0xA6, 0xF5,        //       LDX $F5      pages
+    0xA0, 0x00,        //       LDY #$00
+    0xB1, 0xF2,        // $0213 LDA ($F2),Y
+    0x45, 0xF1,        //       EOR $F1
+    0x85, 0xF1,        //       STA $F1
+    0xA9, 0x08,        //       LDA #$08
+    0x85, 0xF4,        //       STA $F4      bit count
+    0x18,              // $021D CLC
+    0x26, 0xF0,        //       ROL $F0      CRC << 1
+    0x26, 0xF1,        //       ROL $F1
+    0x90, 0x0C,        //       BCC $0230
+    0xA5, 0xF1,        //       LDA $F1      CRC ^= $1021
+    0x49, 0x10,        //       EOR #$10
+    0x85, 0xF1,        //       STA $F1
+    0xA5, 0xF0,        //       LDA $F0
+    0x49, 0x21,        //       EOR #$21
+    0x85, 0xF0,        //       STA $F0
+    0xC6, 0xF4,        // $0230 DEC $F4
+    0xD0, 0xE9,        //       BNE $021D
+    0xC8,              //       INY
+    0xD0, 0xDC,        //       BNE $0213
+    0xE6, 0xF3,        //       INC $F3
+    0xCA,              //       DEX
+    0xD0, 0xD7,        //       BNE $0213
+    0x00               //       BRK
+};
+
+static const uint8_t crc_subroutine[] = {
+    0xF8,              // $0280 SED
+    0xA9, 0x19,        //       LDA #$19
+    0x18,              //       CLC
+    0x69, 0x28,        //       ADC #$28     $47
+    0xD8,              //       CLD
+    0x48,              //       PHA
+    0x08,              //       PHP
+    0x28,              //       PLP
+    0x68,              //       PLA
+    0xBA,              //       TSX
+    0x9D, 0x00, 0x01,  //       STA $0100,X
+    0x60               //       RTS
+};
+
+// Byte i of the data; a different seed changes every byte, so CPUs given
+// different seeds take different branches
+inline uint8_t crc_data(unsigned i, unsigned seed) {
+    return (uint8_t)((i ^ (i >> 3)) + seed * 13 + (seed >> 2) * i);
+}
+
+// Everything but the program itself: the subroutine, the data and the
+// page count
+inline void load_crc_data(CPU65C02& cpu, uint8_t pages, unsigned seed) {
+    cpu.load_program(crc_subroutine, sizeof(crc_subroutine), 0x0280);
+    for (unsigned i = 0; i < pages * 256u; i++) {
+        cpu.get_memory().write(0x1000 + i, crc_data(i, seed));
+    }
+    cpu.get_memory().write(0xF5, pages);
+}
+
+// The program and its data, ready to run from $0200 with an empty stack
+inline void load_crc(CPU65C02& cpu, uint8_t pages = 1, unsigned seed = 0) {
+    cpu.load_program(crc_program, sizeof(crc_program), 0x0200);
+    load_crc_data(cpu, pages, seed);
+    cpu.set_PC(0x0200);
+    cpu.set_SP(0xFF);
+}
+
+// The CRC the program should leave at $F0/$F1
+inline uint16_t crc_expected(uint8_t pages, unsigned seed) {
+    uint16_t crc = 0xFFFF;
+    for (unsigned i = 0; i < pages * 256u; i++) {
+        crc ^= crc_data(i, seed) << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+#endif // CRC_PROGRAM_H
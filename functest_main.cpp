@@ -0,0 +1,136 @@
+#include "CPU65C02.h"
+#include "ImageFile.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+static void usage() {
+    cerr << "usage: 6502functest [options] image" << endl;
+    cerr << "  -e engine        table, switch, threaded, block or jit (default switch)" << endl;
+    cerr << "  -l addr          where a raw image is loaded (default $0000)" << endl;
+    cerr << "  -r addr          start address, written to the reset vector" << endl;
+    cerr << "  -s addr          the trap that means success (default $0403)" << endl;
+    cerr << "  -t addr          where the image keeps its test number (default $0200)" << endl;
+    cerr << "  -c cycles        give up after this many cycles (default 1000000000)" << endl;
+}
+
+// $hex, 0xhex or decimal
+static bool parse_number(const char* text, uint64_t max, uint64_t& value) {
+    char* end = nullptr;
+    if (*text == '$') {
+        value = strtoull(text + 1, &end, 16);
+    } else {
+        value = strtoull(text, &end, 0);
+    }
+    return *text != '\0' && end != text && *end == '\0' && value <= max;
+}
+
+// Runs a functional test image, such as roms/65C02_functional_test.hex, to
+// the trap it ends in. Such images never stop: every check that fails, and
+// the end of the run, is an instruction that jumps or branches to itself.
+// The CPU runs freely in slices and looks for one between slices, so the
+// check costs nothing per instruction and the emulated clock rate reported
+// is the engine's own.
+int main(int argc, char** argv) {
+    const char* image_path = nullptr;
+    bool start_given = false;
+    uint64_t load_address = 0, start = 0, success = 0x0403, test_case = 0x0200, max_cycles = 1000000000;
+    CPU65C02::Engine engine = CPU65C02::Engine::Switch;
+    for (int i = 1; i < argc; i++) {
+        bool ok = true;
+        if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            ok = false;
+            for (CPU65C02::Engine e : { CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+                                        CPU65C02::Engine::Block, CPU65C02::Engine::Jit }) {
+                if (strcmp(name, CPU65C02::engine_name(e)) == 0) {
+                    engine = e;
+                    ok = true;
+                }
+            }
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            ok = parse_number(argv[++i], 0xFFFF, load_address);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            ok = parse_number(argv[++i], 0xFFFF, start);
+            start_given = true;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            ok = parse_number(argv[++i], 0xFFFF, success);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            ok = parse_number(argv[++i], 0xFFFF, test_case);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            ok = parse_number(argv[++i], UINT64_MAX, max_cycles);
+        } else if (argv[i][0] != '-' && !image_path) {
+            image_path = argv[i];
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            usage();
+            return 2;
+        }
+    }
+    if (!image_path) {
+        usage();
+        return 2;
+    }
+
+    CPU65C02 cpu(false);
+    cpu.set_engine(engine);
+    cpu.set_brk_stops(false);  // Test images check BRK through their IRQ handler
+    try {
+        load_image_file(cpu, image_path, image_format_for(image_path), load_address);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    if (start_given) {
+        uint8_t vector[] = { (uint8_t)start, (uint8_t)(start >> 8) };
+        cpu.load_program(vector, sizeof(vector), 0xFFFC);
+    }
+    cpu.reset();
+
+    // Long enough to amortize the check, short enough that a trap is
+    // noticed within a few milliseconds
+    const uint64_t SLICE = 1000000;
+    bool trapped = false;
+    CPU65C02::StopReason reason = CPU65C02::StopReason::Budget;
+    auto begin = chrono::steady_clock::now();
+    while (cpu.get_cycles() < max_cycles) {
+        reason = cpu.run_cycles(SLICE);
+        if (reason != CPU65C02::StopReason::Budget) {
+            break;
+        }
+        uint16_t pc = cpu.get_PC();
+        reason = cpu.run_instructions(1);
+        if (reason != CPU65C02::StopReason::Budget) {
+            break;
+        }
+        if (cpu.get_PC() == pc) {
+            trapped = true;
+            break;
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    bool passed = trapped && cpu.get_PC() == success;
+    cout << hex << uppercase << setfill('0');
+    if (passed) {
+        cout << "passed";
+    } else if (trapped) {
+        cout << "FAILED: trapped at $" << setw(4) << cpu.get_PC() << " in test " << dec
+             << (int)cpu.get_RAM(test_case);
+    } else if (reason != CPU65C02::StopReason::Budget) {
+        cout << "FAILED: stopped (" << CPU65C02::stop_reason_name(reason) << ") at $" << setw(4) << cpu.get_PC();
+    } else {
+        cout << "FAILED: no trap within " << dec << max_cycles << " cycles, at $" << setw(4) << cpu.get_PC();
+    }
+    cout << dec << setfill(' ') << " on " << CPU65C02::engine_name(engine) << ", " << cpu.get_cycles()
+         << " cycles in " << fixed << setprecision(3) << seconds << " s, " << setprecision(1)
+         << cpu.get_cycles() / seconds / 1e6 << " MHz" << endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+#include "Fuzzer.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+static void usage() {
+    cerr << "usage: 6502fuzz [-j threads] [-n cases] [-s seed] [-i instructions] [-e engine] [-r case]" << endl;
+    cerr << "  -e  fuzz only this engine (table, switch, threaded, block or jit)" << endl;
+    cerr << "  -r  rerun one case and show it" << endl;
+}
+
+int main(int argc, char** argv) {
+    FuzzOptions options;
+    bool rerun = false;
+    uint64_t rerun_index = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            options.threads = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            options.cases = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            options.seed = strtoull(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            options.instructions = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            vector<CPU65C02::Engine> engines;
+            for (CPU65C02::Engine engine : options.engines) {
+                if (strcmp(name, CPU65C02::engine_name(engine)) == 0) {
+                    engines.push_back(engine);
+                }
+            }
+            if (engines.empty()) {
+                usage();
+                return 2;
+            }
+            options.engines = engines;
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            rerun = true;
+            rerun_index = strtoull(argv[++i], nullptr, 10);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    Fuzzer fuzzer(options);
+    if (rerun) {
+        fuzzer.print_case(rerun_index, cout);
+        vector<FuzzFailure> failures = fuzzer.run_case(rerun_index);
+        for (const FuzzFailure& f : failures) {
+            cout << CPU65C02::engine_name(f.engine) << ": " << f.what << endl;
+        }
+        if (failures.empty()) {
+            cout << "every engine agrees with the model" << endl;
+        }
+        return failures.empty() ? 0 : 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    FuzzReport report = fuzzer.run();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    for (const FuzzFailure& f : report.failures) {
+        cout << "case " << f.index << " on " << CPU65C02::engine_name(f.engine) << ": " << f.what << endl;
+    }
+    cerr << report.cases << " cases on " << options.engines.size() << " engines, " << report.instructions
+         << " model instructions in " << seconds << " s, " << report.cases / seconds << " cases/s" << endl;
+    return report.failures.empty() ? 0 : 1;
+}
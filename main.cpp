@@ -1,43 +1,223 @@
 #include "CPU65C02.h"
-#include <iostream>
+#include "ImageFile.h"
+#include "Lockstep.h"
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <iomanip>
+#include <iostream>
+#include <vector>
 
 using namespace std;
 
-int main() {
-    cout << "Hello, World!" << endl;
-    // cout << hex << uppercase;
-    // cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    
+static void usage() {
+    cerr << "usage: 6502cpu [options] image" << endl;
+    cerr << "  -f raw|hex|ines  image format (default: from the extension)" << endl;
+    cerr << "  -l addr          where a raw image is loaded (default $0000)" << endl;
+    cerr << "  -r addr          start address, written to the reset vector" << endl;
+    cerr << "  -c cycles        cycle budget (default 1000000000)" << endl;
+    cerr << "  -n count         run count instructions instead of a cycle budget" << endl;
+    cerr << "  -e engine        table, switch, threaded, block or jit" << endl;
+    cerr << "  -d addr:len      dump memory when the run stops; may be repeated" << endl;
+    cerr << "  -b addr          stop before the instruction at addr; may be repeated" << endl;
+    cerr << "  -w addr:len      stop after an instruction writes the range; may be repeated" << endl;
+    cerr << "  -R addr:len      stop after an instruction reads the range; may be repeated" << endl;
+    cerr << "  -v cycles        check the run against the table core every cycles cycles," << endl;
+    cerr << "                   or every instruction with 0; exits 3 if they diverge" << endl;
+    cerr << "  -q               do not print the final CPU state" << endl;
+}
+
+// $hex, 0xhex or decimal
+static bool parse_number(const char* text, uint64_t max, uint64_t& value) {
+    char* end = nullptr;
+    if (*text == '$') {
+        value = strtoull(text + 1, &end, 16);
+    } else {
+        value = strtoull(text, &end, 0);
+    }
+    return *text != '\0' && end != text && *end == '\0' && value <= max;
+}
+
+// addr:len, as first and last address
+static bool parse_range(const string& range, pair<uint16_t, uint16_t>& parsed) {
+    size_t colon = range.find(':');
+    uint64_t address = 0, length = 0;
+    bool ok = colon != string::npos && parse_number(range.substr(0, colon).c_str(), 0xFFFF, address) &&
+              parse_number(range.substr(colon + 1).c_str(), 0x10000 - address, length) && length > 0;
+    parsed = make_pair((uint16_t)address, (uint16_t)(address + length - 1));
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    const char* image_path = nullptr;
+    bool format_given = false, start_given = false, count_instructions = false, quiet = false, validate = false;
+    ImageFormat format = ImageFormat::Raw;
+    uint64_t load_address = 0, start = 0, cycles = 1000000000, instructions = 0, chunk_cycles = 0;
+    CPU65C02::Engine engine = CPU65C02::Engine::Switch;
+    vector<pair<uint16_t, uint32_t>> dumps;
+    vector<uint16_t> breakpoints;
+    vector<pair<uint16_t, uint16_t>> write_watches, read_watches;
+    for (int i = 1; i < argc; i++) {
+        bool ok = true;
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            format_given = true;
+            if (strcmp(name, "raw") == 0) {
+                format = ImageFormat::Raw;
+            } else if (strcmp(name, "hex") == 0) {
+                format = ImageFormat::IntelHex;
+            } else if (strcmp(name, "ines") == 0) {
+                format = ImageFormat::INes;
+            } else {
+                ok = false;
+            }
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            ok = parse_number(argv[++i], 0xFFFF, load_address);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            ok = parse_number(argv[++i], 0xFFFF, start);
+            start_given = true;
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            ok = parse_number(argv[++i], UINT64_MAX, cycles);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            ok = parse_number(argv[++i], UINT64_MAX, instructions);
+            count_instructions = true;
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (strcmp(name, "table") == 0) {
+                engine = CPU65C02::Engine::Table;
+            } else if (strcmp(name, "switch") == 0) {
+                engine = CPU65C02::Engine::Switch;
+            } else if (strcmp(name, "threaded") == 0) {
+                engine = CPU65C02::Engine::Threaded;
+            } else if (strcmp(name, "block") == 0) {
+                engine = CPU65C02::Engine::Block;
+            } else if (strcmp(name, "jit") == 0) {
+                engine = CPU65C02::Engine::Jit;
+            } else {
+                ok = false;
+            }
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            string range = argv[++i];
+            size_t colon = range.find(':');
+            uint64_t address = 0, length = 0;
+            ok = colon != string::npos && parse_number(range.substr(0, colon).c_str(), 0xFFFF, address) &&
+                 parse_number(range.substr(colon + 1).c_str(), 0x10000 - address, length);
+            dumps.emplace_back(address, length);
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            uint64_t address = 0;
+            ok = parse_number(argv[++i], 0xFFFF, address);
+            breakpoints.push_back((uint16_t)address);
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            write_watches.emplace_back();
+            ok = parse_range(argv[++i], write_watches.back());
+        } else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc) {
+            read_watches.emplace_back();
+            ok = parse_range(argv[++i], read_watches.back());
+        } else if (strcmp(argv[i], "-v") == 0 && i + 1 < argc) {
+            ok = parse_number(argv[++i], UINT64_MAX, chunk_cycles);
+            validate = true;
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = true;
+        } else if (argv[i][0] != '-' && !image_path) {
+            image_path = argv[i];
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            usage();
+            return 2;
+        }
+    }
+    if (!image_path) {
+        usage();
+        return 2;
+    }
+    if (!format_given) {
+        format = image_format_for(image_path);
+    }
+
     #ifdef CPU_DEBUG
     CPU65C02 cpu(true);
     #else
     CPU65C02 cpu(false);
     #endif
-    
-    // Test program
-    uint8_t program[] = {
-        0xA9, 0x42,       // LDA #$42
-        0x69, 0x37,       // ADC #$37 (should result in $79)
-        0x85, 0x20,       // STA $20
-        0xE9, 0x15,       // SBC #$15 (should result in $64)
-        0x85, 0x21,       // STA $21
-        
-        0xA2, 0x05,       // LDX #$05
-        0xE8,             // INX (should be $06)
-        0x86, 0x22,       // STX $22
-        
-        0xA0, 0x0A,       // LDY #$0A
-        0x88,             // DEY (should be $09)
-        0x84, 0x23,       // STY $23
-        
-        0xE6, 0x20,       // INC $20 (should be $7A)
-        0xC6, 0x21,       // DEC $21 (should be $63)
-        
-        0x00              // BRK
+    cpu.set_engine(engine);
+
+    // Load the image and reset into it
+    auto boot = [&](CPU65C02& target) {
+        ImageInfo info = load_image_file(target, image_path, format, load_address);
+        // Without -r, a HEX start record, or a raw image that leaves the
+        // reset vector empty starting where it was loaded, decide where the
+        // run begins. iNES images always have their own vector.
+        uint64_t entry = start;
+        bool entry_given = start_given;
+        if (!entry_given && info.has_entry) {
+            entry = info.entry;
+            entry_given = true;
+        } else if (!entry_given && format == ImageFormat::Raw && (info.first > 0xFFFC || info.last < 0xFFFD)) {
+            entry = load_address;
+            entry_given = true;
+        }
+        if (entry_given) {
+            uint8_t vector[] = { (uint8_t)entry, (uint8_t)(entry >> 8) };
+            target.load_program(vector, sizeof(vector), 0xFFFC);
+        }
+        target.reset();
+        for (uint16_t address : breakpoints) {
+            target.add_breakpoint(address);
+        }
+        for (const auto& range : write_watches) {
+            target.add_watchpoint(range.first, range.second, false, true);
+        }
+        for (const auto& range : read_watches) {
+            target.add_watchpoint(range.first, range.second, true, false);
+        }
     };
 
-    cpu.load_program(program, sizeof(program));
-    cpu.execute();
+    CPU65C02::StopReason reason;
+    Divergence divergence;
+    try {
+        boot(cpu);
+        if (validate) {
+            CPU65C02 reference(false);
+            boot(reference);
+            Lockstep lockstep(reference, cpu);
+            lockstep.set_chunk_cycles(chunk_cycles);
+            divergence = count_instructions ? lockstep.run(UINT64_MAX, instructions) : lockstep.run(cycles);
+            reason = lockstep.get_stop_reason();
+        } else {
+            reason = count_instructions ? cpu.run_instructions(instructions) : cpu.run_cycles(cycles);
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    if (divergence.diverged()) {
+        divergence.print(cout);
+        return 3;
+    }
+
+    cout << hex << uppercase << setfill('0');
+    for (const auto& dump : dumps) {
+        for (uint32_t offset = 0; offset < dump.second; offset += 16) {
+            cout << setw(4) << dump.first + offset << ':';
+            for (uint32_t i = offset; i < dump.second && i < offset + 16; i++) {
+                cout << ' ' << setw(2) << (int)cpu.get_RAM(dump.first + i);
+            }
+            cout << endl;
+        }
+    }
+    if (!quiet) {
+        if (reason == CPU65C02::StopReason::Watchpoint) {
+            const CPU65C02::WatchHit& hit = cpu.get_watch_hit();
+            cout << (hit.write ? "write $" : "read $") << setw(4) << hit.address << " value=$" << setw(2)
+                 << (int)hit.value << endl;
+        }
+        CPU65C02::Registers regs = cpu.get_registers();
+        cout << CPU65C02::stop_reason_name(reason) << " pc=$" << setw(4) << regs.PC << " a=$" << setw(2)
+             << (int)regs.A << " x=$" << setw(2) << (int)regs.X << " y=$" << setw(2) << (int)regs.Y << " s=$"
+             << setw(2) << (int)regs.S << " p=$" << setw(2) << (int)regs.P() << dec << " cycles=" << cpu.get_cycles()
+             << endl;
+    }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,288 @@
+#!/usr/bin/env python3
+# Two-pass 65C02 assembler for the subset of 64tass syntax the functional
+# test uses: labels, name = expr, * = expr, .byte, .word, .macro/.endm with
+# \1..\9 and _local labels, #macro calls, <expr, >expr, $hex, %bin, 'c' and
+# * as the PC. Output is Intel HEX in ascending address order, 16 bytes a
+# record, so the checked-in image can be rebuilt and compared byte for byte.
+#
+#   asm65.py 65C02_functional_test.a65 65C02_functional_test.hex [-l listing]
+#   asm65.py --check 65C02_functional_test.a65 65C02_functional_test.hex
+import argparse
+import re
+import sys
+
+OPS = {}
+def add(m, mode, code): OPS.setdefault(m, {})[mode] = code
+
+for m, codes in {
+    'adc': (0x69,0x65,0x75,0x6d,0x7d,0x79,0x61,0x71,0x72),
+    'and': (0x29,0x25,0x35,0x2d,0x3d,0x39,0x21,0x31,0x32),
+    'cmp': (0xc9,0xc5,0xd5,0xcd,0xdd,0xd9,0xc1,0xd1,0xd2),
+    'eor': (0x49,0x45,0x55,0x4d,0x5d,0x59,0x41,0x51,0x52),
+    'lda': (0xa9,0xa5,0xb5,0xad,0xbd,0xb9,0xa1,0xb1,0xb2),
+    'ora': (0x09,0x05,0x15,0x0d,0x1d,0x19,0x01,0x11,0x12),
+    'sbc': (0xe9,0xe5,0xf5,0xed,0xfd,0xf9,0xe1,0xf1,0xf2),
+    'sta': (None,0x85,0x95,0x8d,0x9d,0x99,0x81,0x91,0x92),
+}.items():
+    for mode, c in zip(('imm','zp','zpx','abs','abx','aby','izx','izy','izp'), codes):
+        if c is not None: add(m, mode, c)
+for m, codes in {'asl':(0x0a,0x06,0x16,0x0e,0x1e),'lsr':(0x4a,0x46,0x56,0x4e,0x5e),
+                 'rol':(0x2a,0x26,0x36,0x2e,0x3e),'ror':(0x6a,0x66,0x76,0x6e,0x7e),
+                 'inc':(0x1a,0xe6,0xf6,0xee,0xfe),'dec':(0x3a,0xc6,0xd6,0xce,0xde)}.items():
+    for mode, c in zip(('acc','zp','zpx','abs','abx'), codes): add(m, mode, c)
+for m, d in {
+    'bit': {'imm':0x89,'zp':0x24,'zpx':0x34,'abs':0x2c,'abx':0x3c},
+    'cpx': {'imm':0xe0,'zp':0xe4,'abs':0xec}, 'cpy': {'imm':0xc0,'zp':0xc4,'abs':0xcc},
+    'ldx': {'imm':0xa2,'zp':0xa6,'zpy':0xb6,'abs':0xae,'aby':0xbe},
+    'ldy': {'imm':0xa0,'zp':0xa4,'zpx':0xb4,'abs':0xac,'abx':0xbc},
+    'stx': {'zp':0x86,'zpy':0x96,'abs':0x8e}, 'sty': {'zp':0x84,'zpx':0x94,'abs':0x8c},
+    'stz': {'zp':0x64,'zpx':0x74,'abs':0x9c,'abx':0x9e},
+    'trb': {'zp':0x14,'abs':0x1c}, 'tsb': {'zp':0x04,'abs':0x0c},
+    'jmp': {'abs':0x4c,'ind':0x6c,'iax':0x7c}, 'jsr': {'abs':0x20},
+}.items():
+    for mode, c in d.items(): add(m, mode, c)
+for m, c in {'bpl':0x10,'bmi':0x30,'bvc':0x50,'bvs':0x70,'bcc':0x90,'bcs':0xb0,'bne':0xd0,'beq':0xf0,'bra':0x80}.items():
+    add(m, 'rel', c)
+for m, c in {'brk':0x00,'rti':0x40,'rts':0x60,'php':0x08,'plp':0x28,'pha':0x48,'pla':0x68,'dey':0x88,
+             'tay':0xa8,'iny':0xc8,'inx':0xe8,'clc':0x18,'sec':0x38,'cli':0x58,'sei':0x78,'tya':0x98,
+             'clv':0xb8,'cld':0xd8,'sed':0xf8,'txa':0x8a,'txs':0x9a,'tax':0xaa,'tsx':0xba,'dex':0xca,
+             'nop':0xea,'phy':0x5a,'ply':0x7a,'phx':0xda,'plx':0xfa,'wai':0xcb,'stp':0xdb}.items():
+    add(m, 'imp', c)
+for n in range(8):
+    add('rmb%d' % n, 'zp', 0x07 + n * 16); add('smb%d' % n, 'zp', 0x87 + n * 16)
+    add('bbr%d' % n, 'zpr', 0x0f + n * 16); add('bbs%d' % n, 'zpr', 0x8f + n * 16)
+
+SIZE = {'imp':1,'acc':1,'imm':2,'zp':2,'zpx':2,'zpy':2,'izx':2,'izy':2,'izp':2,'rel':2,
+        'abs':3,'abx':3,'aby':3,'ind':3,'iax':3,'zpr':3}
+
+class Asm:
+    def __init__(self):
+        self.syms = {}
+        self.mem = {}
+        self.macros = {}
+        self.listing = []
+
+    def ev(self, e, pc, final):
+        e = e.strip()
+        if e.startswith('<'): return self.ev(e[1:], pc, final) & 0xff
+        if e.startswith('>'): return (self.ev(e[1:], pc, final) >> 8) & 0xff
+        s = re.sub(r"'(.)'", lambda m: str(ord(m.group(1))), e)
+        s = re.sub(r'\$([0-9a-fA-F]+)', lambda m: str(int(m.group(1), 16)), s)
+        s = re.sub(r'%([01]+)', lambda m: str(int(m.group(1), 2)), s)
+        s = re.sub(r'(?<![\w)])\*(?![\w(])', str(pc), s)
+        def sym(m):
+            name = m.group(0)
+            if name in self.syms: return str(self.syms[name])
+            if final: raise Exception('undefined ' + name)
+            self.unknown = True
+            return '0'
+        s = re.sub(r'[A-Za-z_][A-Za-z_0-9]*', sym, s)
+        return int(eval(s))
+
+    def expand(self, lines):
+        out = []
+        count = [0]
+        def rec(lines, depth):
+            i = 0
+            while i < len(lines):
+                src, line = lines[i]
+                code = strip(line)
+                m = re.match(r'^([A-Za-z_]\w*)\s+\.macro\b', code)
+                if m:
+                    body = []
+                    i += 1
+                    while strip(lines[i][1]).strip() != '.endm':
+                        body.append(lines[i]); i += 1
+                    self.macros[m.group(1)] = body
+                    i += 1
+                    continue
+                m = re.match(r'^\s+#(\w+)\s*(.*)$', code)
+                if m:
+                    name = m.group(1)
+                    args = [a.strip() for a in split_args(m.group(2))] if m.group(2).strip() else []
+                    count[0] += 1
+                    n = count[0]
+                    body = []
+                    for s2, b in self.macros[name]:
+                        for k, a in enumerate(args):
+                            b = b.replace('\\%d' % (k + 1), a)
+                        b = re.sub(r'\b(_\w+)', lambda mm: '%s__%d' % (mm.group(1), n), b)
+                        body.append((src, b))
+                    out.append((src, ';' + code.strip()))
+                    rec(body, depth + 1)
+                    i += 1
+                    continue
+                out.append((src, line))
+                i += 1
+        rec(lines, 0)
+        return out
+
+    def run(self, lines, final):
+        pc = 0
+        for src, line in lines:
+            code = strip(line)
+            if not code.strip():
+                continue
+            m = re.match(r'^([A-Za-z_]\w*)\s*=\s*(.+)$', code.strip())
+            if m and not code[0].isspace():
+                self.unknown = False
+                v = self.ev(m.group(2), pc, final)
+                self.syms[m.group(1)] = v
+                continue
+            m = re.match(r'^\*\s*=\s*(.+)$', code.strip())
+            if m:
+                pc = self.ev(m.group(1), pc, True)
+                continue
+            if not code[0].isspace():
+                parts = code.split(None, 1)
+                label = parts[0]
+                if final and self.syms.get(label) != pc:
+                    raise Exception('phase error at %s' % label)
+                self.syms[label] = pc
+                code = ' ' + (parts[1] if len(parts) > 1 else '')
+                if not code.strip():
+                    continue
+            code = code.strip()
+            start = pc
+            if code.startswith('.byte') or code.startswith('.word'):
+                w = 2 if code.startswith('.word') else 1
+                for a in split_args(code[5:]):
+                    v = self.ev(a, pc, final) if final else 0
+                    for k in range(w):
+                        self.emit(pc, (v >> (8 * k)) & 0xff, final); pc += 1
+            else:
+                parts = code.split(None, 1)
+                mn = parts[0].lower()
+                opnd = parts[1].strip() if len(parts) > 1 else ''
+                if mn not in OPS:
+                    raise Exception('%s: unknown %s' % (src, code))
+                modes = OPS[mn]
+                bytes_ = self.encode(mn, modes, opnd, pc, final, src)
+                for b in bytes_:
+                    self.emit(pc, b, final); pc += 1
+            if final:
+                self.listing.append('%04X  %-12s %s' % (start, ' '.join('%02X' % self.mem[a] for a in range(start, min(pc, start + 4))), line.rstrip()))
+
+    def emit(self, pc, b, final):
+        if final:
+            if pc in self.mem: raise Exception('overlap at %04X' % pc)
+            self.mem[pc] = b
+
+    def encode(self, mn, modes, o, pc, final, src):
+        low = o.lower().replace(' ', '')
+        def val(e):
+            self.unknown = False
+            return self.ev(e, pc, final)
+        if 'zpr' in modes:
+            zp, target = split_args(o)
+            t = val(target); off = t - (pc + 3)
+            if final and not -128 <= off <= 127: raise Exception('%s: branch range' % src)
+            return [modes['zpr'], val(zp) & 0xff, off & 0xff]
+        if 'rel' in modes:
+            t = val(o); off = t - (pc + 2)
+            if final and not -128 <= off <= 127: raise Exception('%s: branch range' % src)
+            return [modes['rel'], off & 0xff]
+        if o == '' or low == 'a':
+            mode = 'acc' if 'acc' in modes else 'imp'
+            return [modes[mode]]
+        if o.startswith('#'):
+            return [modes['imm'], val(o[1:]) & 0xff]
+        if low.startswith('(') and low.endswith(',x)'):
+            v = val(o.strip()[1:o.strip().lower().rindex(',')])
+            if 'iax' in modes: return [modes['iax'], v & 0xff, v >> 8]
+            return [modes['izx'], v & 0xff]
+        if low.startswith('(') and low.endswith('),y'):
+            v = val(o.strip()[1:o.strip().index(')')])
+            return [modes['izy'], v & 0xff]
+        if low.startswith('(') and low.endswith(')') and self._paren_wraps(o.strip()):
+            v = val(o.strip()[1:-1])
+            if 'ind' in modes: return [modes['ind'], v & 0xff, v >> 8]
+            return [modes['izp'], v & 0xff]
+        idx = ''
+        e = o
+        if low.endswith(',x') or low.endswith(',y'):
+            idx = low[-1]; e = o.strip()[:-2]
+        v = val(e)
+        short = not self.unknown and v < 256
+        zpm, absm = {'': ('zp', 'abs'), 'x': ('zpx', 'abx'), 'y': ('zpy', 'aby')}[idx]
+        if short and zpm in modes:
+            return [modes[zpm], v]
+        if absm not in modes: raise Exception('%s: no mode %s for %s' % (src, absm, mn))
+        return [modes[absm], v & 0xff, (v >> 8) & 0xff]
+
+    def _paren_wraps(self, s):
+        depth = 0
+        for k, ch in enumerate(s):
+            depth += ch == '('
+            depth -= ch == ')'
+            if depth == 0 and k != len(s) - 1: return False
+        return True
+
+def strip(line):
+    """The line without its comment; a ';' between quotes is a character"""
+    out = ''
+    for k, ch in enumerate(line):
+        if ch == ';' and not (k > 0 and line[k - 1] == "'" and k + 1 < len(line) and line[k + 1] == "'"):
+            break
+        out += ch
+    return out.rstrip()
+
+def split_args(s):
+    parts, depth, cur = [], 0, ''
+    for ch in s:
+        if ch == '(' : depth += 1
+        if ch == ')' : depth -= 1
+        if ch == ',' and depth == 0:
+            parts.append(cur); cur = ''
+        else:
+            cur += ch
+    parts.append(cur)
+    return [p.strip() for p in parts]
+
+def intel_hex(mem):
+    addrs = sorted(mem)
+    out = []
+    k = 0
+    while k < len(addrs):
+        start = addrs[k]
+        chunk = [mem[start]]
+        k += 1
+        while k < len(addrs) and addrs[k] == start + len(chunk) and len(chunk) < 16:
+            chunk.append(mem[addrs[k]]); k += 1
+        rec = [len(chunk), start >> 8, start & 0xff, 0] + chunk
+        out.append(':' + ''.join('%02X' % b for b in rec) + '%02X' % ((-sum(rec)) & 0xff))
+    out.append(':00000001FF')
+    return '\n'.join(out) + '\n'
+
+def main():
+    parser = argparse.ArgumentParser(description='Assemble a 65C02 source file to Intel HEX')
+    parser.add_argument('source')
+    parser.add_argument('image')
+    parser.add_argument('-l', '--listing', help='also write a listing here')
+    parser.add_argument('--check', action='store_true',
+                        help='compare with image instead of writing it')
+    args = parser.parse_args()
+
+    lines = [(i + 1, l.rstrip('\n')) for i, l in enumerate(open(args.source))]
+    a = Asm()
+    lines = a.expand(lines)
+    a.run(lines, False)  # Two passes settle forward references and zero page
+    a.run(lines, False)
+    a.run(lines, True)
+    image = intel_hex(a.mem)
+    if args.listing:
+        open(args.listing, 'w').write('\n'.join(a.listing) + '\n')
+    if args.check:
+        if open(args.image).read() != image:
+            print('%s does not match %s' % (args.image, args.source))
+            return 1
+        print('%s matches %s' % (args.image, args.source))
+        return 0
+    open(args.image, 'w').write(image)
+    for name in ('success', 'start'):
+        if name in a.syms:
+            print('%s = $%04X' % (name, a.syms[name]))
+    print('%d bytes' % len(a.mem))
+    return 0
+
+sys.exit(main())
@@ -0,0 +1,102 @@
+#include "BatchRunner.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+// Test jobs run on several threads give the same results as one at a time
+void test_parallel_matches_serial() {
+    print_test_header("Parallel Batch");
+
+    auto image = make_shared<vector<uint8_t>>(vector<uint8_t>{
+        0x86, 0x10,  // STX $10
+        0xC8,        // INY
+        0xCA,        // DEX
+        0xD0, 0xFC,  // BNE $0202
+        0x00         // BRK
+    });
+
+    vector<BatchJob> jobs;
+    for (int i = 0; i < 64; i++) {
+        BatchJob job;
+        job.name = "job" + to_string(i);
+        job.image = image;
+        job.load_address = 0x0200;
+        job.PC = 0x0200;
+        job.X = i + 1;
+        jobs.push_back(job);
+    }
+
+    vector<BatchResult> results = BatchRunner(4).run(jobs);
+    bool ok = results.size() == jobs.size();
+    for (size_t i = 0; ok && i < jobs.size(); i++) {
+        BatchResult serial = BatchRunner::run_job(jobs[i]);
+        ok = results[i].name == jobs[i].name &&
+             results[i].reason == CPU65C02::StopReason::Brk &&
+             results[i].regs.Y == i + 1 && results[i].regs.X == 0 &&
+             results[i].cycles == serial.cycles &&
+             results[i].memory_digest == serial.memory_digest;
+    }
+    print_test_result(ok);
+}
+
+// Test the manifest parser
+void test_manifest() {
+    print_test_header("Manifest Parsing");
+
+    {
+        istringstream in("# comment only\n\nname=a image=/dev/null load=0x8000 pc=0x8000 s=0xFD cycles=500 # trailing\n");
+        vector<BatchJob> jobs = load_manifest(in, "");
+        print_test_result(jobs.size() == 1 && jobs[0].name == "a" && jobs[0].load_address == 0x8000 &&
+                          jobs[0].PC == 0x8000 && jobs[0].S == 0xFD && jobs[0].max_cycles == 500);
+    }
+    {
+        istringstream in("image=/dev/null a=0x100\n");
+        bool threw = false;
+        try {
+            load_manifest(in, "");
+        } catch (const exception&) {
+            threw = true;
+        }
+        print_test_result(threw);
+    }
+}
+
+// Test a job without pc= starts where the reset vector points
+void test_reset_vector() {
+    print_test_header("Start From Reset Vector");
+
+    vector<uint8_t> rom(0x10000 - 0xF000, 0xEA);
+    rom[0x0000] = 0xA2;  // $F000 LDX #$5A
+    rom[0x0001] = 0x5A;
+    rom[0x0002] = 0x00;  //       BRK
+    rom[0x0FFC] = 0x00;  // Reset vector $F000
+    rom[0x0FFD] = 0xF0;
+
+    istringstream in("image=/dev/null load=0xF000\n");
+    vector<BatchJob> jobs = load_manifest(in, "");
+    jobs[0].image = make_shared<vector<uint8_t>>(rom);
+    BatchResult result = BatchRunner::run_job(jobs[0]);
+    print_test_result(jobs[0].PC == BatchJob::RESET_VECTOR && result.reason == CPU65C02::StopReason::Brk &&
+                      result.regs.X == 0x5A && result.regs.PC == 0xF002);
+}
+
+int main() {
+    cout << "Starting Batch Runner Tests\n";
+
+    test_parallel_matches_serial();
+    test_manifest();
+    test_reset_vector();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include "CPU65C02.h"
+#include "Profiler.h"
+#include <iostream>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+static CPU65C02::Engine engines[] = {
+    CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+    CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+};
+
+// Stores and loads X = 1..10, then BRK
+static const uint8_t loop_program[] = {
+    0xA2, 0x00,        // $0000 LDX #$00
+    0xE8,              // $0002 INX
+    0x8E, 0x10, 0x02,  // $0003 STX $0210
+    0xBD, 0x00, 0x03,  // $0006 LDA $0300,X
+    0xE0, 0x0A,        // $0009 CPX #$0A
+    0xD0, 0xF5,        // $000B BNE $0002
+    0x00               // $000D BRK
+};
+
+static void load_loop(CPU65C02& cpu, CPU65C02::Engine engine) {
+    uint8_t data[16];
+    for (unsigned i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(0x40 + i);
+    }
+    cpu.load_program(loop_program, sizeof(loop_program));
+    cpu.load_program(data, sizeof(data), 0x0300);
+    cpu.reset();
+    cpu.set_engine(engine);
+}
+
+// Test a breakpoint stops before its instruction, and the next run steps over it
+void test_breakpoint() {
+    print_test_header("PC Breakpoint");
+
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        load_loop(cpu, engine);
+        cpu.add_breakpoint(0x0002);
+        CPU65C02::StopReason first = cpu.run_cycles(100000);
+        bool ok = first == CPU65C02::StopReason::Breakpoint && cpu.get_PC() == 0x0002 && cpu.get_X() == 0 &&
+                  cpu.get_cycles() == 2;
+        // LDX, then INX STX LDA CPX BNE once round the loop
+        CPU65C02::StopReason second = cpu.run_cycles(100000);
+        ok = ok && second == CPU65C02::StopReason::Breakpoint && cpu.get_PC() == 0x0002 && cpu.get_X() == 1 &&
+             cpu.get_cycles() == 2 + 15;
+        cpu.remove_breakpoint(0x0002);
+        CPU65C02::StopReason third = cpu.run_cycles(100000);
+        print_test_result(ok && third == CPU65C02::StopReason::Brk && cpu.get_X() == 10 &&
+                          cpu.get_RAM(0x0210) == 10);
+    }
+}
+
+// Test a breakpoint only stops when its condition holds
+void test_conditional_breakpoint() {
+    print_test_header("Conditional Breakpoint");
+
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        load_loop(cpu, engine);
+        cpu.add_breakpoint(0x0006, [](CPU65C02& c) { return c.get_X() == 7; });
+        CPU65C02::StopReason reason = cpu.run_cycles(100000);
+        print_test_result(reason == CPU65C02::StopReason::Breakpoint && cpu.get_PC() == 0x0006 &&
+                          cpu.get_X() == 7 && cpu.get_RAM(0x0210) == 7);
+    }
+}
+
+// Test a breakpoint added after the JIT has translated the loop
+void test_breakpoint_in_translated_code() {
+    print_test_header("Breakpoint in Translated Code");
+
+    CPU65C02 cpu;
+    uint8_t program[] = {
+        0xE8,        // $0000 INX
+        0xC8,        // $0001 INY
+        0x80, 0xFC   // $0002 BRA $0000
+    };
+    cpu.load_program(program, sizeof(program));
+    cpu.reset();
+    cpu.set_engine(CPU65C02::Engine::Jit);
+    CPU65C02::StopReason before = cpu.run_cycles(10000);
+    cpu.add_breakpoint(0x0001);
+    CPU65C02::StopReason reason = cpu.run_cycles(10000);
+    bool ok = before == CPU65C02::StopReason::Budget && reason == CPU65C02::StopReason::Breakpoint &&
+              cpu.get_PC() == 0x0001 && cpu.get_X() == (uint8_t)(cpu.get_Y() + 1);
+    cpu.clear_breakpoints();
+    uint64_t cycles = cpu.get_cycles();
+    reason = cpu.run_cycles(10000);
+    print_test_result(ok && reason == CPU65C02::StopReason::Budget && cpu.get_cycles() >= cycles + 10000);
+}
+
+// Test write watchpoints stop after the write, and conditions see the value
+void test_write_watchpoint() {
+    print_test_header("Write Watchpoint");
+
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        load_loop(cpu, engine);
+        cpu.add_watchpoint(0x0210, 0x0210, false, true,
+                           [](CPU65C02& c) { return c.get_watch_hit().value == 4; });
+        CPU65C02::StopReason reason = cpu.run_cycles(100000);
+        const CPU65C02::WatchHit& hit = cpu.get_watch_hit();
+        bool ok = reason == CPU65C02::StopReason::Watchpoint && cpu.get_PC() == 0x0006 && cpu.get_X() == 4 &&
+                  cpu.get_RAM(0x0210) == 4 && hit.address == 0x0210 && hit.value == 4 && hit.write;
+        cpu.clear_watchpoints();
+        reason = cpu.run_cycles(100000);
+        print_test_result(ok && reason == CPU65C02::StopReason::Brk && cpu.get_X() == 10);
+    }
+}
+
+// Test read watchpoints cover a range of data, and not instruction fetches
+void test_read_watchpoint() {
+    print_test_header("Read Watchpoint");
+
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        load_loop(cpu, engine);
+        cpu.add_watchpoint(0x0000, 0x000D, true, false);
+        cpu.add_watchpoint(0x0305, 0x0306, true, false);
+        CPU65C02::StopReason first = cpu.run_cycles(100000);
+        const CPU65C02::WatchHit& hit = cpu.get_watch_hit();
+        bool ok = first == CPU65C02::StopReason::Watchpoint && cpu.get_PC() == 0x0009 && cpu.get_X() == 5 &&
+                  cpu.get_A() == 0x45 && hit.address == 0x0305 && hit.value == 0x45 && !hit.write;
+        CPU65C02::StopReason second = cpu.run_cycles(100000);
+        ok = ok && second == CPU65C02::StopReason::Watchpoint && cpu.get_X() == 6 && hit.address == 0x0306;
+        CPU65C02::StopReason third = cpu.run_cycles(100000);
+        print_test_result(ok && third == CPU65C02::StopReason::Brk && cpu.get_X() == 10);
+    }
+}
+
+// Test breakpoints also stop runs being profiled
+void test_breakpoint_while_profiling() {
+    print_test_header("Breakpoint While Profiling");
+
+    CPU65C02 cpu;
+    Profiler profiler;
+    load_loop(cpu, CPU65C02::Engine::Threaded);
+    cpu.set_profiler(&profiler);
+    cpu.add_breakpoint(0x0009, [](CPU65C02& c) { return c.get_X() == 3; });
+    CPU65C02::StopReason reason = cpu.run_cycles(100000);
+    print_test_result(reason == CPU65C02::StopReason::Breakpoint && cpu.get_PC() == 0x0009 && cpu.get_X() == 3 &&
+                      profiler.get_count(0x0002) == 3 && profiler.get_count(0x0009) == 2);
+}
+
+// Overwrites the operand of the LDX after it with $42
+static const uint8_t patch_program[] = {
+    0xA9, 0x42,        // $0000 LDA #$42
+    0x8D, 0x06, 0x00,  // $0002 STA $0006
+    0xA2, 0x00,        // $0005 LDX #$00
+    0x00               // $0007 BRK
+};
+
+// Test code written inside the running block is seen on every engine, also
+// while a breakpoint elsewhere has them all running from the block cache
+void test_code_write_with_breakpoint() {
+    print_test_header("Code Write With Breakpoint Set");
+
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        cpu.load_program(patch_program, sizeof(patch_program));
+        cpu.reset();
+        cpu.set_engine(engine);
+        cpu.add_breakpoint(0x0100);
+        CPU65C02::StopReason reason = cpu.run_cycles(100000);
+        print_test_result(reason == CPU65C02::StopReason::Brk && cpu.get_PC() == 0x0007 && cpu.get_X() == 0x42);
+    }
+}
+
+// Test a counted run stops on its count when it ends just after a code write
+void test_counted_run_across_code_write() {
+    print_test_header("Counted Run Across Code Write");
+
+    for (CPU65C02::Engine engine : engines) {
+        bool ok = true;
+        for (bool breakpoint : { false, true }) {
+            CPU65C02 cpu;
+            cpu.load_program(patch_program, sizeof(patch_program));
+            cpu.reset();
+            cpu.set_engine(engine);
+            if (breakpoint) {
+                cpu.add_breakpoint(0x0100);
+            }
+            CPU65C02::StopReason first = cpu.run_instructions(2);
+            ok = ok && first == CPU65C02::StopReason::Budget && cpu.get_PC() == 0x0005;
+            CPU65C02::StopReason second = cpu.run_instructions(1);
+            ok = ok && second == CPU65C02::StopReason::Budget && cpu.get_PC() == 0x0007 && cpu.get_X() == 0x42;
+        }
+        print_test_result(ok);
+    }
+}
+
+int main() {
+    cout << "Starting Breakpoint Tests\n";
+
+    test_breakpoint();
+    test_conditional_breakpoint();
+    test_breakpoint_in_translated_code();
+    test_write_watchpoint();
+    test_read_watchpoint();
+    test_breakpoint_while_profiling();
+    test_code_write_with_breakpoint();
+    test_counted_run_across_code_write();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "CPU65C02.h"
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+static CPU65C02::Engine engines[] = {
+    CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+    CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+};
+
+// Run a program to its BRK and return the cycles it took
+static uint64_t cycles_for(const uint8_t* program, size_t size, uint16_t address, CPU65C02::Engine engine) {
+    CPU65C02 cpu;
+    cpu.set_engine(engine);
+    cpu.load_program(program, size, address);
+    cpu.set_PC(address);
+    cpu.run_cycles(100000);
+    return cpu.get_cycles();
+}
+
+// Test indexed reads cost one more cycle when they cross a page, and stores do not
+void test_page_cross() {
+    print_test_header("Page-Crossing Penalties");
+
+    for (CPU65C02::Engine engine : engines) {
+        uint8_t same_page[] = {
+            0xA2, 0x0F,        // LDX #$0F        (2 cycles)
+            0xBD, 0xF0, 0x02,  // LDA $02F0,X     (4 cycles, reads $02FF)
+            0x00               // BRK
+        };
+        uint8_t other_page[] = {
+            0xA2, 0x10,        // LDX #$10        (2 cycles)
+            0xBD, 0xF0, 0x02,  // LDA $02F0,X     (5 cycles, reads $0300)
+            0x00               // BRK
+        };
+        uint8_t indirect[] = {
+            0xA9, 0xFF,        // LDA #$FF        (2 cycles)
+            0x85, 0x20,        // STA $20         (3 cycles)
+            0xA0, 0x01,        // LDY #$01        (2 cycles)
+            0xB1, 0x20,        // LDA ($20),Y     (6 cycles, reads $0100)
+            0x00               // BRK
+        };
+        uint8_t store[] = {
+            0xA2, 0x10,        // LDX #$10        (2 cycles)
+            0x9D, 0xF0, 0x02,  // STA $02F0,X     (5 cycles either way)
+            0x00               // BRK
+        };
+        print_test_result(cycles_for(same_page, sizeof(same_page), 0x0200, engine) == 6 &&
+                          cycles_for(other_page, sizeof(other_page), 0x0200, engine) == 7 &&
+                          cycles_for(indirect, sizeof(indirect), 0x0200, engine) == 13 &&
+                          cycles_for(store, sizeof(store), 0x0200, engine) == 7);
+    }
+}
+
+// Test taken branches cost one more cycle, and one more again across a page
+void test_branch_penalties() {
+    print_test_header("Branch Penalties");
+
+    for (CPU65C02::Engine engine : engines) {
+        uint8_t not_taken[] = {
+            0xA2, 0x00,        // $02FB LDX #$00  (2 cycles)
+            0xD0, 0x10,        // $02FD BNE $030F (2 cycles)
+            0x00               // $02FF BRK
+        };
+        uint8_t taken_across[] = {
+            0xA2, 0x01,        // $02FB LDX #$01  (2 cycles)
+            0xD0, 0x10,        // $02FD BNE $030F (4 cycles)
+            0x00               // $02FF BRK, and $030F is BRK too
+        };
+        uint8_t taken_within[] = {
+            0xA2, 0x01,        // $0200 LDX #$01  (2 cycles)
+            0xD0, 0x01,        // $0202 BNE $0205 (3 cycles)
+            0xEA,              // $0204 NOP
+            0x00               // $0205 BRK
+        };
+        print_test_result(cycles_for(not_taken, sizeof(not_taken), 0x02FB, engine) == 4 &&
+                          cycles_for(taken_across, sizeof(taken_across), 0x02FB, engine) == 6 &&
+                          cycles_for(taken_within, sizeof(taken_within), 0x0200, engine) == 5);
+    }
+}
+
+// Test the cycle counter carries on past 2^32
+void test_wide_counter() {
+    print_test_header("64-bit Cycle Counter");
+
+    uint8_t program[] = {
+        0xE8,        // INX
+        0x80, 0xFD   // BRA $0000
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        cpu.set_engine(engine);
+        cpu.load_program(program, sizeof(program));
+        cpu.reset();
+        CPU65C02::Snapshot snap = cpu.snapshot();
+        snap.cycles = 0xFFFFFFF0;
+        cpu.restore(snap);
+        cpu.run_cycles(100);
+        print_test_result(cpu.get_cycles() == 0xFFFFFFF0ULL + 100 && cpu.get_X() == 20);
+    }
+}
+
+int main() {
+    cout << "Starting Cycle Tests\n";
+
+    test_page_cross();
+    test_branch_penalties();
+    test_wide_counter();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
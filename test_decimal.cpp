@@ -0,0 +1,129 @@
+#include "CPU65C02.h"
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+static unsigned to_bcd(unsigned n) {
+    return ((n / 10) << 4) | (n % 10);
+}
+
+// Run one ADC/SBC #imm with the given accumulator and status and return
+// the cycles it took
+static uint64_t run_one(CPU65C02& cpu, uint8_t opcode, uint8_t a, uint8_t operand, uint8_t p) {
+    uint8_t program[] = { opcode, operand };
+    cpu.load_program(program, sizeof(program), 0x0200);
+    cpu.set_PC(0x0200);
+    cpu.set_A(a);
+    cpu.set_P(p);
+    uint64_t before = cpu.get_cycles();
+    cpu.run_instructions(1);
+    return cpu.get_cycles() - before;
+}
+
+// Test decimal ADC and SBC against decimal arithmetic for every pair of
+// valid BCD operands and both carries, with N and Z from the result
+void test_valid_bcd() {
+    print_test_header("Decimal ADC/SBC");
+
+    CPU65C02 cpu;
+    cpu.set_engine(CPU65C02::Engine::Switch);
+    bool ok = true;
+    for (unsigned a = 0; a < 100 && ok; a++) {
+        for (unsigned m = 0; m < 100 && ok; m++) {
+            for (unsigned c = 0; c < 2 && ok; c++) {
+                unsigned sum = a + m + c;
+                uint64_t taken = run_one(cpu, 0x69, to_bcd(a), to_bcd(m), 0x08 | c);
+                uint8_t status = cpu.get_status();
+                ok = taken == 3 && cpu.get_A() == to_bcd(sum % 100) && (status & 0x01) == (sum >= 100) &&
+                     ((status & 0x02) != 0) == (sum % 100 == 0) && (status & 0x80) == (to_bcd(sum % 100) & 0x80);
+
+                int difference = (int)a - (int)m - (1 - (int)c);
+                taken = run_one(cpu, 0xE9, to_bcd(a), to_bcd(m), 0x08 | c);
+                status = cpu.get_status();
+                unsigned expected = to_bcd((difference + 100) % 100);
+                ok = ok && taken == 3 && cpu.get_A() == expected && (status & 0x01) == (difference >= 0) &&
+                     ((status & 0x02) != 0) == (expected == 0) && (status & 0x80) == (expected & 0x80);
+            }
+        }
+    }
+    print_test_result(ok);
+}
+
+// Test the decimal path on every engine, including the D flag set and
+// cleared by SED and CLD inside the program
+void test_decimal_program() {
+    print_test_header("Decimal Mode Program");
+
+    uint8_t program[] = {
+        0xF8,        // SED
+        0x18,        // CLC
+        0xA9, 0x58,  // LDA #$58
+        0x69, 0x46,  // ADC #$46     $04, carry set
+        0x85, 0x10,  // STA $10
+        0xA9, 0x00,  // LDA #$00
+        0xE9, 0x00,  // SBC #$00     $00, no borrow
+        0xE9, 0x01,  // SBC #$01     $99, borrow
+        0x85, 0x11,  // STA $11
+        0xD8,        // CLD
+        0x38,        // SEC
+        0xA9, 0x09,  // LDA #$09
+        0x69, 0x01,  // ADC #$01     binary: $0B
+        0x00         // BRK
+    };
+    CPU65C02::Engine engines[] = {
+        CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+        CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        cpu.set_engine(engine);
+        cpu.load_program(program, sizeof(program), 0x0200);
+        cpu.set_PC(0x0200);
+        cpu.run_cycles(1000);
+        print_test_result(cpu.get_RAM(0x10) == 0x04 && cpu.get_RAM(0x11) == 0x99 && cpu.get_A() == 0x0B &&
+                          cpu.get_cycles() == 2 + 2 + 2 + 3 + 3 + 2 + 3 + 3 + 3 + 2 + 2 + 2 + 2);
+    }
+}
+
+// Test binary ADC and SBC set V on signed overflow only
+void test_binary_overflow() {
+    print_test_header("Binary Overflow");
+
+    CPU65C02 cpu;
+    struct Case { uint8_t opcode, a, operand, carry, result, flags; } cases[] = {
+        { 0x69, 0x50, 0x50, 0, 0xA0, 0xC0 },  // ADC: positive + positive = negative
+        { 0x69, 0xD0, 0x90, 0, 0x60, 0x41 },  // ADC: negative + negative = positive
+        { 0x69, 0x50, 0xD0, 0, 0x20, 0x01 },  // ADC: mixed signs never overflow
+        { 0x69, 0x7F, 0x00, 1, 0x80, 0xC0 },  // ADC: carry in overflows
+        { 0xE9, 0x50, 0xB0, 1, 0xA0, 0xC0 },  // SBC: positive - negative = negative
+        { 0xE9, 0xD0, 0x70, 1, 0x60, 0x41 },  // SBC: negative - positive = positive
+        { 0xE9, 0x50, 0x30, 1, 0x20, 0x01 },  // SBC: no borrow
+        { 0xE9, 0x00, 0x00, 0, 0xFF, 0x80 },  // SBC: borrow in
+    };
+    bool ok = true;
+    for (const Case& c : cases) {
+        uint64_t taken = run_one(cpu, c.opcode, c.a, c.operand, c.carry);
+        ok = ok && taken == 2 && cpu.get_A() == c.result && (cpu.get_status() & 0xC3) == c.flags;
+    }
+    print_test_result(ok);
+}
+
+int main() {
+    cout << "Starting Decimal Mode Tests\n";
+
+    test_valid_bcd();
+    test_decimal_program();
+    test_binary_overflow();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
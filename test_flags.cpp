@@ -0,0 +1,155 @@
+#include "CPU65C02.h"
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+// Run a program at $0200 to its BRK and return the status register
+static uint8_t status_after(const uint8_t* program, size_t size, CPU65C02::Engine engine, uint8_t initial = 0) {
+    CPU65C02 cpu;
+    cpu.set_engine(engine);
+    cpu.load_program(program, size, 0x0200);
+    cpu.set_PC(0x0200);
+    cpu.set_P(initial);
+    cpu.run_cycles(100000);
+    return cpu.get_status();
+}
+
+// Test N and Z come from the last result, however many results came before
+void test_nz_flags() {
+    print_test_header("N and Z Flags");
+
+    CPU65C02::Engine engines[] = {
+        CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+        CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+    };
+    for (CPU65C02::Engine engine : engines) {
+        uint8_t negative[] = {
+            0xA9, 0x00,  // LDA #$00
+            0xA2, 0x05,  // LDX #$05
+            0xA9, 0x80,  // LDA #$80
+            0x00         // BRK
+        };
+        uint8_t zero[] = {
+            0xA0, 0x01,  // LDY #$01
+            0x88,        // DEY
+            0x00         // BRK
+        };
+        print_test_result(status_after(negative, sizeof(negative), engine) == 0x80 &&
+                          status_after(zero, sizeof(zero), engine) == 0x02);
+    }
+}
+
+// Test C and V and the flags that are not tracked lazily
+void test_other_flags() {
+    print_test_header("C, V and Mode Flags");
+
+    uint8_t carry[] = {
+        0xA9, 0xFF,  // LDA #$FF
+        0x69, 0x01,  // ADC #$01
+        0xB8,        // CLV
+        0xF8,        // SED
+        0x00         // BRK
+    };
+    // A + 1 wraps to zero with carry out; V was set on entry and cleared
+    print_test_result(status_after(carry, sizeof(carry), CPU65C02::Engine::Table, 0x44) == (0x04 | 0x08 | 0x02 | 0x01));
+
+    // The status register round-trips through set_P()
+    CPU65C02 cpu;
+    bool ok = true;
+    for (unsigned p = 0; p < 256; p++) {
+        cpu.set_P(p);
+        // Z and N cannot come from one result, but set_P() can still load both
+        ok = ok && cpu.get_status() == p;
+    }
+    print_test_result(ok);
+}
+
+// Test PHP and PLP carry every flag, lazily tracked or not, and that the
+// register file copies as a unit
+void test_php_plp() {
+    print_test_header("PHP/PLP");
+
+    CPU65C02::Engine engines[] = {
+        CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+        CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+    };
+    uint8_t program[] = {
+        0xF8,        // SED
+        0x38,        // SEC
+        0xA9, 0x80,  // LDA #$80
+        0x08,        // PHP
+        0xD8,        // CLD
+        0x18,        // CLC
+        0xA9, 0x01,  // LDA #$01
+        0x28,        // PLP
+        0x00         // BRK
+    };
+    for (CPU65C02::Engine engine : engines) {
+        uint8_t status = status_after(program, sizeof(program), engine, 0x04);
+        print_test_result(status == (0x30 | 0x80 | 0x08 | 0x04 | 0x01));
+    }
+
+    CPU65C02 cpu;
+    cpu.set_A(0x12);
+    cpu.set_P(0xC3);
+    cpu.set_PC(0x3456);
+    CPU65C02::Registers regs = cpu.get_registers();
+    CPU65C02 copy;
+    copy.set_registers(regs);
+    print_test_result(copy.get_A() == 0x12 && copy.get_P() == 0xC3 && copy.get_PC() == 0x3456 &&
+                      regs.P() == 0xC3);
+}
+
+// Test set_registers() brings flag bytes filled in by hand into range, so
+// decimal ADC sees C as 1 rather than indexing with $FF
+void test_unmasked_registers() {
+    print_test_header("Unmasked Flag Bytes");
+
+    CPU65C02::Engine engines[] = {
+        CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+        CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+    };
+    uint8_t program[] = {
+        0x69, 0x01,  // ADC #$01
+        0x00         // BRK
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        cpu.load_program(program, sizeof(program), 0x0200);
+        cpu.set_engine(engine);
+        CPU65C02::Registers regs = {};
+        regs.PC = 0x0200;
+        regs.A = 0x09;
+        regs.S = 0xFF;
+        regs.status = 0xFF;  // D and I among stray bits
+        regs.flag_n = 0x7F;
+        regs.flag_z = 0x40;
+        regs.flag_c = 0xFF;
+        regs.flag_v = 0x7F;
+        cpu.set_registers(regs);
+        uint8_t before = cpu.get_P();
+        cpu.run_cycles(100000);
+        print_test_result(before == (0x3C | 0x01) && cpu.get_registers().flag_c == 0 && cpu.get_A() == 0x11);
+    }
+}
+
+int main() {
+    cout << "Starting Flag Tests\n";
+
+    test_nz_flags();
+    test_other_flags();
+    test_php_plp();
+    test_unmasked_registers();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "CPU65C02.h"
+#include "Fuzzer.h"
+#include "ReferenceModel.h"
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+static CPU65C02::Engine engines[] = {
+    CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+    CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+};
+
+// Each of these once differed from the model: ASL and LSR shifted the
+// carry in, TRB and TSB set N from the result, and (zp) pointers at $FF
+// took their high byte from $0100
+static const uint8_t regression_program[] = {
+    0x38,              // $0200 SEC
+    0xA9, 0x81,        //       LDA #$81
+    0x85, 0x10,        //       STA $10
+    0x06, 0x10,        //       ASL $10      $02, C=1
+    0x0A,              //       ASL A        $02, C=1
+    0x85, 0x11,        //       STA $11
+    0x46, 0x10,        //       LSR $10      $01, C=0
+    0x38,              //       SEC
+    0x4E, 0x11, 0x00,  //       LSR $0011    $01, C=0
+    0xA9, 0x01,        //       LDA #$01
+    0x04, 0x12,        //       TSB $12      $81, Z=1, N=0
+    0x08,              //       PHP
+    0x14, 0x12,        //       TRB $12      $80, Z=0, N=0
+    0x08,              //       PHP
+    0xB2, 0xFF,        //       LDA ($FF)    pointer $FF/$00
+    0xDB               //       STP
+};
+
+static void poke(CPU65C02& cpu, uint16_t address, uint8_t value) {
+    cpu.load_program(&value, 1, address);
+}
+
+static void load_regression(CPU65C02& cpu) {
+    cpu.load_program(regression_program, sizeof(regression_program), 0x0200);
+    poke(cpu, 0x12, 0x80);
+    poke(cpu, 0xFF, 0x34);
+    poke(cpu, 0x00, 0x12);
+    poke(cpu, 0x0100, 0x56);
+    poke(cpu, 0x1234, 0x5A);
+    poke(cpu, 0x5634, 0xA5);
+    cpu.set_PC(0x0200);
+    cpu.set_SP(0xFF);
+}
+
+// Test the bugs the fuzzer found stay fixed on every engine
+void test_regressions() {
+    print_test_header("Fuzzer Regressions");
+
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        cpu.set_engine(engine);
+        load_regression(cpu);
+        CPU65C02::StopReason stop = cpu.run_instructions(100);
+        print_test_result(stop == CPU65C02::StopReason::Halt && cpu.get_RAM(0x10) == 0x01 &&
+                          cpu.get_RAM(0x11) == 0x01 && cpu.get_RAM(0x12) == 0x80 &&
+                          (cpu.get_RAM(0x01FF) & 0x83) == 0x02 && (cpu.get_RAM(0x01FE) & 0x83) == 0x00 &&
+                          cpu.get_A() == 0x5A);
+    }
+}
+
+// Test the model runs the same program to the same state
+void test_model() {
+    print_test_header("Reference Model");
+
+    CPU65C02 cpu;
+    load_regression(cpu);
+    static ReferenceModel model;
+    vector<uint8_t> memory(0x10000);
+    for (unsigned address = 0; address < memory.size(); address++) {
+        memory[address] = cpu.get_RAM(address);
+    }
+    model.set_memory(memory.data());
+    model.state = ReferenceModel::State{ 0x0200, 0, 0, 0, 0xFF, 0x34, 0 };
+    CPU65C02::StopReason stop = CPU65C02::StopReason::Budget;
+    unsigned steps = 0;
+    while (stop == CPU65C02::StopReason::Budget && steps < 100) {
+        stop = model.step();
+        steps++;
+    }
+    cpu.run_instructions(100);
+    print_test_result(stop == CPU65C02::StopReason::Halt && model.state.pc == cpu.get_PC() &&
+                      model.state.a == cpu.get_A() && model.state.cycles == cpu.get_cycles() &&
+                      model.peek(0x10) == 0x01 && model.peek(0x01FF) == cpu.get_RAM(0x01FF) &&
+                      model.peek(0x01FE) == cpu.get_RAM(0x01FE));
+
+    // Rollback leaves memory as it was set
+    model.rollback();
+    unsigned written = 0;
+    model.for_each_written([&](uint16_t) { written++; });
+    print_test_result(written == 0 && model.peek(0x10) == memory[0x10] && model.peek(0x01FF) == memory[0x01FF]);
+}
+
+// Test cases follow from the seed and case number alone
+void test_cases() {
+    print_test_header("Fuzz Cases");
+
+    FuzzOptions options;
+    Fuzzer a(options), b(options);
+    options.seed = 2;
+    Fuzzer c(options);
+    FuzzCase x = a.make_case(12345), y = b.make_case(12345), z = c.make_case(12345), w = a.make_case(12346);
+    print_test_result(memcmp(&x, &y, sizeof(x)) == 0 && memcmp(&x, &z, sizeof(x)) != 0 &&
+                      memcmp(&x, &w, sizeof(x)) != 0);
+
+    ostringstream text;
+    a.print_case(7, text);
+    print_test_result(text.str().find("case 7 (seed 1): pc=$") == 0);
+}
+
+// Test every engine agrees with the model over a short fuzz run
+void test_run() {
+    print_test_header("Fuzz Run");
+
+    FuzzOptions options;
+    options.cases = 20000;
+    options.threads = 2;
+    Fuzzer fuzzer(options);
+    FuzzReport report = fuzzer.run();
+    for (const FuzzFailure& f : report.failures) {
+        cout << "case " << f.index << " on " << CPU65C02::engine_name(f.engine) << ": " << f.what << endl;
+    }
+    print_test_result(report.failures.empty() && report.cases == options.cases &&
+                      report.instructions > options.cases);
+    print_test_result(fuzzer.run_case(4).empty());
+}
+
+int main() {
+    cout << "Starting Fuzzer Tests\n";
+
+    test_regressions();
+    test_model();
+    test_cases();
+    test_run();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "CPU65C02.h"
+#include "ImageFile.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+static void write_file(const string& path, const string& contents) {
+    ofstream file(path, ios::binary);
+    file << contents;
+}
+
+static bool throws(CPU65C02& cpu, const string& path, ImageFormat format, uint16_t address = 0) {
+    try {
+        load_image_file(cpu, path, format, address);
+    } catch (const runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+// Test formats are told apart by extension
+void test_format_for() {
+    print_test_header("Format From Extension");
+
+    print_test_result(image_format_for("rom.bin") == ImageFormat::Raw &&
+                      image_format_for("a.b/rom") == ImageFormat::Raw &&
+                      image_format_for("prog.HEX") == ImageFormat::IntelHex &&
+                      image_format_for("prog.ihx") == ImageFormat::IntelHex &&
+                      image_format_for("game.nes") == ImageFormat::INes);
+}
+
+// Test a raw image is loaded as-is at its address and runs
+void test_raw() {
+    print_test_header("Raw Image");
+
+    write_file("image_test.bin", string("\xA9\x42\x85\x10\xDB", 5));
+    CPU65C02 cpu;
+    ImageInfo info = load_image_file(cpu, "image_test.bin", ImageFormat::Raw, 0x0200);
+    cpu.set_PC(0x0200);
+    CPU65C02::StopReason reason = cpu.run_cycles(100);
+    bool ok = info.first == 0x0200 && info.last == 0x0204 && !info.has_entry &&
+              reason == CPU65C02::StopReason::Halt && cpu.get_RAM(0x10) == 0x42;
+
+    write_file("image_empty.bin", "");
+    ok = ok && throws(cpu, "image_empty.bin", ImageFormat::Raw) &&
+         throws(cpu, "image_test.bin", ImageFormat::Raw, 0xFFFC) &&
+         throws(cpu, "image_missing.bin", ImageFormat::Raw);
+    remove("image_test.bin");
+    remove("image_empty.bin");
+    print_test_result(ok);
+}
+
+// Test Intel HEX data, extended linear address and start address records,
+// and that a bad checksum is rejected
+void test_intel_hex() {
+    print_test_header("Intel HEX Image");
+
+    write_file("image_test.hex",
+               ":020000040000FA\r\n"
+               ":05030000A9428510DB9D\r\n"
+               "\r\n"
+               ":02FFFE00EFBE54\n"
+               ":0400000500000300F4\n"
+               ":00000001FF\n"
+               ":01000000FF00\n");  // After EOF, so never read
+    CPU65C02 cpu;
+    ImageInfo info = load_image_file(cpu, "image_test.hex", ImageFormat::IntelHex);
+    bool ok = info.first == 0x0300 && info.last == 0xFFFF && info.has_entry && info.entry == 0x0300 &&
+              cpu.get_RAM(0x0300) == 0xA9 && cpu.get_RAM(0x0304) == 0xDB && cpu.get_RAM(0xFFFE) == 0xEF &&
+              cpu.get_RAM(0xFFFF) == 0xBE && cpu.get_RAM(0x0000) == 0x00;
+
+    write_file("image_bad.hex", ":05030000A9428510DB9E\n");
+    ok = ok && throws(cpu, "image_bad.hex", ImageFormat::IntelHex);
+    write_file("image_bad.hex", ":020000040001F9\n:01000000EA15\n");  // Above 64KB
+    ok = ok && throws(cpu, "image_bad.hex", ImageFormat::IntelHex);
+    remove("image_test.hex");
+    remove("image_bad.hex");
+    print_test_result(ok);
+}
+
+// Test a 16KB iNES PRG ROM is mirrored at $8000 and $C000, and runs from
+// its own reset vector
+void test_ines() {
+    print_test_header("iNES Image");
+
+    string prg(0x4000, '\xEA');
+    prg.replace(0x0000, 5, "\xA9\x42\x85\x10\xDB", 5);  // $8000/$C000
+    prg.replace(0x3FFC, 2, "\x00\xC0", 2);              // Reset to $C000
+    string header("NES\x1A\x01\x01\x00\x00", 8);
+    header.append(8, '\0');
+    write_file("image_test.nes", header + prg + string(0x2000, '\0'));
+    CPU65C02 cpu;
+    ImageInfo info = load_image_file(cpu, "image_test.nes", ImageFormat::INes);
+    cpu.reset();
+    CPU65C02::StopReason reason = cpu.run_cycles(100);
+    bool ok = info.first == 0x8000 && info.last == 0xFFFF && cpu.get_RAM(0x8000) == 0xA9 &&
+              reason == CPU65C02::StopReason::Halt && cpu.get_PC() == 0xC004 && cpu.get_RAM(0x10) == 0x42;
+
+    header[4] = 4;  // 64KB of PRG ROM needs a mapper
+    write_file("image_bad.nes", header + string(0x10000, '\0'));
+    ok = ok && throws(cpu, "image_bad.nes", ImageFormat::INes);
+    write_file("image_bad.nes", "NES");
+    ok = ok && throws(cpu, "image_bad.nes", ImageFormat::INes);
+    remove("image_test.nes");
+    remove("image_bad.nes");
+    print_test_result(ok);
+}
+
+int main() {
+    cout << "Starting Image File Tests\n";
+
+    test_format_for();
+    test_raw();
+    test_intel_hex();
+    test_ines();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
@@ -0,0 +1,200 @@
+#include "CPU65C02.h"
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+static CPU65C02::Engine engines[] = {
+    CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+    CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+};
+
+// Load a program at $0200 and a handler at $0300, point the reset, NMI and
+// IRQ/BRK vectors at them and reset the CPU
+static void load(CPU65C02& cpu, CPU65C02::Engine engine, const uint8_t* program, size_t size,
+                 const uint8_t* handler, size_t handler_size) {
+    uint8_t vectors[] = { 0x00, 0x03, 0x00, 0x02, 0x00, 0x03 };  // NMI, reset, IRQ/BRK
+    cpu.set_engine(engine);
+    cpu.load_program(program, size, 0x0200);
+    cpu.load_program(handler, handler_size, 0x0300);
+    cpu.load_program(vectors, sizeof(vectors), 0xFFFA);
+    cpu.reset();
+}
+
+// Test reset takes PC from the vector and masks interrupts
+void test_reset() {
+    print_test_header("Reset");
+
+    CPU65C02 cpu;
+    uint8_t vector[] = { 0x34, 0x12 };
+    cpu.load_program(vector, sizeof(vector), 0xFFFC);
+    cpu.reset();
+    print_test_result(cpu.get_PC() == 0x1234 && cpu.get_SP() == 0xFF && (cpu.get_status() & 0x0C) == 0x04);
+}
+
+// Test an IRQ is taken once CLI unmasks it, pushing the return address and
+// P with B clear, and entering the handler with I set and D clear
+void test_irq() {
+    print_test_header("IRQ");
+
+    uint8_t program[] = {
+        0xF8,        // $0200 SED
+        0x58,        //       CLI
+        0xE8,        // $0202 INX
+        0x80, 0xFD   //       BRA $0202
+    };
+    uint8_t handler[] = {
+        0xC8,        // $0300 INY
+        0xDB         //       STP
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        load(cpu, engine, program, sizeof(program), handler, sizeof(handler));
+        cpu.assert_irq();
+        CPU65C02::StopReason reason = cpu.run_cycles(1000);
+        print_test_result(reason == CPU65C02::StopReason::Halt && cpu.get_X() == 0 && cpu.get_Y() == 1 &&
+                          cpu.get_PC() == 0x0301 && cpu.get_SP() == 0xFC &&
+                          cpu.get_RAM(0x01FF) == 0x02 && cpu.get_RAM(0x01FE) == 0x02 &&
+                          cpu.get_RAM(0x01FD) == 0x28 && (cpu.get_status() & 0x0C) == 0x04 &&
+                          cpu.get_cycles() == 2 + 2 + 7 + 2);
+    }
+}
+
+// Test IRQ is a level shared by several sources, and is ignored while I is
+// set
+void test_irq_lines() {
+    print_test_header("IRQ Lines");
+
+    uint8_t program[] = {
+        0xE8,        // $0200 INX
+        0x80, 0xFD   //       BRA $0200
+    };
+    uint8_t handler[] = {
+        0xC8,        // $0300 INY
+        0x40         //       RTI
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        load(cpu, engine, program, sizeof(program), handler, sizeof(handler));
+        cpu.assert_irq(0x02);
+        cpu.assert_irq(0x04);
+        cpu.run_cycles(1000);  // Masked by reset
+        bool ok = cpu.get_Y() == 0 && cpu.get_X() != 0;
+        cpu.set_P(0x00);
+        cpu.release_irq(0x02);
+        cpu.run_cycles(100);  // Still held by source $04
+        ok = ok && cpu.get_Y() != 0;
+        cpu.release_irq(0x04);
+        uint8_t y = cpu.get_Y();
+        cpu.run_cycles(1000);
+        print_test_result(ok && cpu.get_Y() == y && cpu.get_SP() == 0xFF);
+    }
+}
+
+// Test NMIs raised between runs are taken through their own vector even
+// with I set, and RTI resumes the interrupted loop each time
+void test_nmi() {
+    print_test_header("NMI");
+
+    uint8_t program[] = {
+        0xE8,        // $0200 INX
+        0x80, 0xFD   //       BRA $0200
+    };
+    uint8_t handler[] = {
+        0xE6, 0x10,  // $0300 INC $10
+        0x40         //       RTI
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        load(cpu, engine, program, sizeof(program), handler, sizeof(handler));
+        uint8_t x = 0;
+        bool ok = true;
+        for (int i = 0; i < 50; i++) {
+            cpu.nmi();
+            cpu.run_cycles(200);
+            ok = ok && cpu.get_X() != x;
+            x = cpu.get_X();
+        }
+        print_test_result(ok && cpu.get_RAM(0x10) == 50 && cpu.get_SP() == 0xFF &&
+                          (cpu.get_status() & 0x04) == 0x04);
+    }
+}
+
+// Test WAI ends the run until an interrupt is raised. A masked IRQ resumes
+// after it without taking the interrupt; an NMI is taken first.
+void test_wai() {
+    print_test_header("WAI");
+
+    uint8_t program[] = {
+        0xCB,        // $0200 WAI
+        0xE8,        //       INX
+        0x58,        //       CLI
+        0xCB,        //       WAI
+        0xE8,        //       INX
+        0xDB         //       STP
+    };
+    uint8_t handler[] = {
+        0xC8,        // $0300 INY
+        0x40         //       RTI
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        load(cpu, engine, program, sizeof(program), handler, sizeof(handler));
+        bool ok = cpu.run_cycles(1000) == CPU65C02::StopReason::Wait && cpu.get_PC() == 0x0201;
+        ok = ok && cpu.run_cycles(1000) == CPU65C02::StopReason::Wait && cpu.get_cycles() == 3;
+        cpu.assert_irq();
+        ok = ok && cpu.run_instructions(1) == CPU65C02::StopReason::Budget && cpu.get_X() == 1 && cpu.get_Y() == 0;
+        cpu.release_irq();
+        ok = ok && cpu.run_cycles(1000) == CPU65C02::StopReason::Wait && cpu.get_PC() == 0x0204;
+        cpu.nmi();
+        ok = ok && cpu.run_cycles(1000) == CPU65C02::StopReason::Halt;
+        print_test_result(ok && cpu.get_X() == 2 && cpu.get_Y() == 1 && cpu.get_PC() == 0x0205);
+    }
+}
+
+// Test BRK as a software interrupt: it skips its signature byte and pushes
+// P with B set
+void test_brk() {
+    print_test_header("BRK");
+
+    uint8_t program[] = {
+        0x00, 0xEA,  // $0200 BRK
+        0xE8,        //       INX
+        0xDB         //       STP
+    };
+    uint8_t handler[] = {
+        0xC8,        // $0300 INY
+        0x40         //       RTI
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        load(cpu, engine, program, sizeof(program), handler, sizeof(handler));
+        cpu.set_brk_stops(false);
+        CPU65C02::StopReason reason = cpu.run_cycles(1000);
+        print_test_result(reason == CPU65C02::StopReason::Halt && cpu.get_X() == 1 && cpu.get_Y() == 1 &&
+                          cpu.get_RAM(0x01FE) == 0x02 && (cpu.get_RAM(0x01FD) & 0x30) == 0x30 &&
+                          cpu.get_cycles() == 7 + 2 + 6 + 2);
+    }
+}
+
+int main() {
+    cout << "Starting Interrupt Tests\n";
+
+    test_reset();
+    test_irq();
+    test_irq_lines();
+    test_nmi();
+    test_wai();
+    test_brk();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
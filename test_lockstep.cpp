@@ -0,0 +1,174 @@
+#include "CPU65C02.h"
+#include "Lockstep.h"
+#include "crc_program.h"
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+static CPU65C02::Engine engines[] = {
+    CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+    CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+};
+
+// Stands in for a bug: reads of page $C0 return $C0 on the subject and
+// writes to it are lost, while the reference sees plain RAM there
+class Ghost : public IoDevice {
+public:
+    uint8_t read(uint16_t) override { return 0xC0; }
+    void write(uint16_t, uint8_t) override {}
+};
+
+// Run program at $0200 on a Table reference and a subject on engine with
+// page $C0 haunted
+static Divergence run_haunted(CPU65C02::Engine engine, const uint8_t* program, size_t size,
+                              uint64_t chunk_cycles = 0) {
+    CPU65C02 reference, subject;
+    Ghost ghost;
+    subject.set_engine(engine);
+    subject.get_memory().map_io(0xC0, 0xC0, &ghost);
+    for (CPU65C02* cpu : { &reference, &subject }) {
+        cpu->load_program(program, size, 0x0200);
+        cpu->set_PC(0x0200);
+    }
+    Lockstep lockstep(reference, subject);
+    lockstep.set_chunk_cycles(chunk_cycles);
+    return lockstep.run(100000);
+}
+
+// Test every engine agrees with the reference instruction by instruction
+void test_agreement() {
+    print_test_header("Lockstep Agreement");
+
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 reference, subject;
+        subject.set_engine(engine);
+        load_crc(reference);
+        load_crc(subject);
+        Lockstep lockstep(reference, subject);
+        Divergence d = lockstep.run(UINT64_MAX);
+        print_test_result(!d.diverged() && lockstep.get_stop_reason() == CPU65C02::StopReason::Brk &&
+                          lockstep.get_instructions() > 10000 && reference.get_RAM(0x01FD) == 0x47);
+    }
+}
+
+// Test every engine agrees running freely in chunks, where Jit executes
+// translated code
+void test_chunk_agreement() {
+    print_test_header("Lockstep Chunks");
+
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 reference, subject;
+        subject.set_engine(engine);
+        load_crc(reference);
+        load_crc(subject);
+        Lockstep lockstep(reference, subject);
+        lockstep.set_chunk_cycles(200);
+        Divergence d = lockstep.run(10000);  // Stops after a chunk, and resumes
+        uint64_t instructions = lockstep.get_instructions();
+        if (!d.diverged()) {
+            d = lockstep.run(UINT64_MAX);
+        }
+        print_test_result(!d.diverged() && lockstep.get_stop_reason() == CPU65C02::StopReason::Brk &&
+                          instructions > 1000 && reference.get_cycles() == subject.get_cycles() &&
+                          reference.get_cycles() > 10000);
+    }
+}
+
+// Test registers, flags, memory and stops that differ are each reported at
+// the instruction that caused them
+void test_divergence_kinds() {
+    print_test_header("Divergence Kinds");
+
+    uint8_t load[] = { 0xA9, 0x01, 0xAD, 0x00, 0xC0, 0xDB };   // LDA #1, LDA $C000, STP
+    uint8_t bit[] = { 0xA9, 0x01, 0x2C, 0x00, 0xC0, 0xDB };    // LDA #1, BIT $C000, STP
+    uint8_t store[] = { 0xA9, 0x01, 0x8D, 0x00, 0xC0, 0xDB };  // LDA #1, STA $C000, STP
+    for (CPU65C02::Engine engine : engines) {
+        Divergence r = run_haunted(engine, load, sizeof(load));
+        Divergence f = run_haunted(engine, bit, sizeof(bit));
+        Divergence m = run_haunted(engine, store, sizeof(store));
+        print_test_result(r.kind == Divergence::Kind::Registers && r.instruction == 2 && r.pc == 0x0202 &&
+                          r.exact && r.reference.A == 0x00 && r.subject.A == 0xC0 &&
+                          f.kind == Divergence::Kind::Flags && f.instruction == 2 &&
+                          (f.reference.P() & 0xC0) == 0x00 && (f.subject.P() & 0xC0) == 0xC0 &&
+                          m.kind == Divergence::Kind::Memory && m.instruction == 2 && m.address == 0xC000 &&
+                          m.reference_byte == 0x01 && m.subject_byte == 0x00);
+    }
+
+    // BRK stops one but not the other
+    uint8_t brk[] = { 0xEA, 0x00 };
+    CPU65C02 reference, subject;
+    for (CPU65C02* cpu : { &reference, &subject }) {
+        cpu->load_program(brk, sizeof(brk), 0x0200);
+        cpu->set_PC(0x0200);
+    }
+    subject.set_brk_stops(false);
+    Lockstep lockstep(reference, subject);
+    Divergence s = lockstep.run(UINT64_MAX);
+    ostringstream text;
+    s.print(text);
+    print_test_result(s.kind == Divergence::Kind::Stop && s.instruction == 1 && s.pc == 0x0201 &&
+                      s.reference_stop == CPU65C02::StopReason::Brk &&
+                      s.subject_stop == CPU65C02::StopReason::Budget &&
+                      text.str().find("stop reason diverged after 1 instructions") == 0);
+}
+
+// Test CPUs that already differ are caught before running anything
+void test_initial_divergence() {
+    print_test_header("Initial Divergence");
+
+    uint8_t program[] = { 0xEA, 0xEA, 0xDB };
+    CPU65C02 reference, subject;
+    for (CPU65C02* cpu : { &reference, &subject }) {
+        cpu->load_program(program, sizeof(program), 0x0200);
+        cpu->set_PC(0x0200);
+    }
+    subject.run_instructions(1);
+    subject.set_PC(0x0200);
+    Lockstep lockstep(reference, subject);
+    Divergence d = lockstep.run(UINT64_MAX);
+    print_test_result(d.kind == Divergence::Kind::Cycles && d.instruction == 0 &&
+                      d.reference_cycles == 0 && d.subject_cycles == 2);
+}
+
+// Test a divergence inside a chunk is replayed down to its instruction
+void test_chunk_divergence() {
+    print_test_header("Chunk Divergence");
+
+    uint8_t program[] = {
+        0xA2, 0x00,        // $0200 LDX #$00
+        0xE8,              // $0202 INX
+        0xD0, 0xFD,        //       BNE $0202
+        0x8E, 0x00, 0xC0,  // $0205 STX $C000
+        0xE8,              //       INX
+        0x8E, 0x00, 0xC0,  //       STX $C000
+        0xDB               //       STP
+    };
+    for (CPU65C02::Engine engine : engines) {
+        Divergence d = run_haunted(engine, program, sizeof(program), 1000);
+        print_test_result(d.kind == Divergence::Kind::Memory && d.exact && d.pc == 0x0209 &&
+                          d.instruction == 1 + 2 * 256 + 2 + 1 && d.address == 0xC000 &&
+                          d.reference_byte == 0x01 && d.subject_byte == 0x00);
+    }
+}
+
+int main() {
+    cout << "Starting Lockstep Tests\n";
+
+    test_agreement();
+    test_chunk_agreement();
+    test_divergence_kinds();
+    test_initial_divergence();
+    test_chunk_divergence();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include "CPU65C02.h"
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+// Test instances mapping one image only copy the pages they write
+void test_shared_image() {
+    print_test_header("Shared Image");
+
+    uint8_t program[] = {
+        0xA9, 0x42,        // LDA #$42
+        0x8D, 0x00, 0x30,  // STA $3000
+        0x00               // BRK
+    };
+    MemoryImage image(program, sizeof(program), 0x0200);
+
+    CPU65C02 first;
+    CPU65C02 second;
+    first.load_image(image);
+    second.load_image(image);
+    print_test_result(first.get_memory().private_pages() == 0 && second.get_RAM(0x0200) == 0xA9);
+
+    first.set_PC(0x0200);
+    first.execute();
+    // Only page $30 was written; the program page is still shared
+    print_test_result(first.get_RAM(0x3000) == 0x42 && second.get_RAM(0x3000) == 0x00 &&
+                      first.get_memory().private_pages() == 1 &&
+                      second.get_memory().private_pages() == 0);
+}
+
+// Test loads across a page boundary and clearing
+void test_load_and_clear() {
+    print_test_header("Load and Clear");
+
+    Memory memory;
+    uint8_t data[] = { 1, 2, 3, 4 };
+    memory.load(data, sizeof(data), 0x12FE);
+    print_test_result(memory.read(0x12FE) == 1 && memory.read(0x1301) == 4 && memory.private_pages() == 2);
+
+    memory.clear();
+    print_test_result(memory.read(0x12FE) == 0 && memory.private_pages() == 0);
+}
+
+// Test rolling back to a snapshot, repeatedly and out of order
+void test_snapshot_restore() {
+    print_test_header("Snapshot and Restore");
+
+    uint8_t program[] = {
+        0xE8,              // INX
+        0x8E, 0x00, 0x40,  // STX $4000
+        0x00               // BRK
+    };
+    CPU65C02 cpu;
+    cpu.load_program(program, sizeof(program), 0x0200);
+    cpu.set_PC(0x0200);
+    CPU65C02::Snapshot start = cpu.snapshot();
+    print_test_result(cpu.get_memory().private_pages() == 0);
+
+    // Fork three scenarios from the same starting point
+    bool ok = true;
+    uint64_t cycles = 0;
+    for (uint8_t x = 1; x <= 3; x++) {
+        cpu.restore(start);
+        cpu.set_X(x * 10);
+        cpu.run_cycles(1000);
+        if (x == 1) {
+            cycles = cpu.get_cycles();
+        }
+        ok = ok && cpu.get_RAM(0x4000) == x * 10 + 1 && cpu.get_cycles() == cycles &&
+             cpu.get_memory().private_pages() == 1;
+    }
+    print_test_result(ok);
+
+    CPU65C02::Snapshot after = cpu.snapshot();
+    cpu.restore(start);
+    print_test_result(cpu.get_RAM(0x4000) == 0 && cpu.get_X() == 0 && cpu.get_PC() == 0x0200);
+    cpu.restore(after);
+    print_test_result(cpu.get_RAM(0x4000) == 31 && cpu.get_X() == 31 && cpu.get_PC() == 0x0204);
+}
+
+// A UART-like device: writes to $D000 are collected, reads of $D001 count up
+struct TestUart : IoDevice {
+    uint8_t received[16];
+    unsigned count = 0;
+    uint8_t status = 0;
+    uint8_t read(uint16_t addr) override { return addr == 0xD001 ? status++ : 0xFF; }
+    void write(uint16_t addr, uint8_t value) override {
+        if (addr == 0xD000 && count < sizeof(received)) {
+            received[count++] = value;
+        }
+    }
+};
+
+// Test loads and stores on an I/O page reach the device and not RAM
+void test_io_device() {
+    print_test_header("Memory-Mapped I/O");
+
+    uint8_t program[] = {
+        0xA9, 0x48,        // LDA #$48
+        0x8D, 0x00, 0xD0,  // STA $D000
+        0xA9, 0x69,        // LDA #$69
+        0x8D, 0x00, 0xD0,  // STA $D000
+        0xAD, 0x01, 0xD0,  // LDA $D001
+        0xAD, 0x01, 0xD0,  // LDA $D001
+        0x00               // BRK
+    };
+    TestUart uart;
+    CPU65C02 cpu;
+    cpu.load_program(program, sizeof(program), 0x0200);
+    cpu.get_memory().map_io(0xD0, 0xD0, &uart);
+    cpu.set_PC(0x0200);
+    cpu.run_cycles(1000);
+    print_test_result(uart.count == 2 && uart.received[0] == 'H' && uart.received[1] == 'i' &&
+                      cpu.get_A() == 1 && uart.status == 2);
+    // The RAM behind the device is untouched and still visible to peek()
+    print_test_result(cpu.get_RAM(0xD000) == 0 && cpu.get_memory().private_pages() == 1);
+
+    // Unmapping hands the page back to RAM, keeping private pages writable
+    cpu.get_memory().map_io(0xD0, 0xD0, nullptr);
+    cpu.get_memory().write(0xD000, 0x55);
+    cpu.get_memory().write(0x0200, 0xEA);
+    print_test_result(cpu.get_memory().read(0xD000) == 0x55 && cpu.get_RAM(0x0200) == 0xEA &&
+                      uart.count == 2 && cpu.get_memory().private_pages() == 2);
+}
+
+int main() {
+    cout << "Starting Memory Tests\n";
+
+    test_shared_image();
+    test_load_and_clear();
+    test_snapshot_restore();
+    test_io_device();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
@@ -0,0 +1,207 @@
+#include "CPU65C02.h"
+#include "Disassembler.h"
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+static CPU65C02::Engine engines[] = {
+    CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+    CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+};
+
+// Load a program at $0200 and run it to its BRK on the given engine
+static void run_program(CPU65C02& cpu, const uint8_t* program, size_t size, CPU65C02::Engine engine) {
+    cpu.set_engine(engine);
+    cpu.load_program(program, size, 0x0200);
+    cpu.set_PC(0x0200);
+    cpu.set_SP(0xFF);
+    cpu.run_cycles(100000);
+}
+
+// Test JSR and RTS, called often enough for the JIT to translate the loop
+void test_jsr_rts() {
+    print_test_header("JSR/RTS");
+
+    uint8_t program[] = {
+        0xA2, 0x00,        // $0200 LDX #$00
+        0xA0, 0x20,        //       LDY #$20
+        0x20, 0x0E, 0x02,  // $0204 JSR $020E
+        0x88,              //       DEY
+        0xD0, 0xFA,        //       BNE $0204
+        0x8E, 0x00, 0x03,  //       STX $0300
+        0x00,              // $020D BRK
+        0xE8,              // $020E INX
+        0x20, 0x13, 0x02,  //       JSR $0213
+        0x60,              //       RTS
+        0xE8,              // $0213 INX
+        0x60               //       RTS
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        run_program(cpu, program, sizeof(program), engine);
+        print_test_result(cpu.get_X() == 0x40 && cpu.get_RAM(0x0300) == 0x40 &&
+                          cpu.get_SP() == 0xFF && cpu.get_PC() == 0x020D);
+    }
+}
+
+// Test JMP absolute, indirect and indexed indirect
+void test_jumps() {
+    print_test_header("JMP");
+
+    uint8_t program[] = {
+        0x4C, 0x05, 0x02,  // $0200 JMP $0205
+        0x00,              //       BRK
+        0x00,              //       BRK
+        0xA2, 0x02,        // $0205 LDX #$02
+        0x7C, 0x20, 0x02,  //       JMP ($0220,X)
+        0x00               //       BRK
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        cpu.get_memory().write(0x0222, 0x00);  // ($0222) = $0300
+        cpu.get_memory().write(0x0223, 0x03);
+        cpu.get_memory().write(0x0300, 0x6C);  // $0300 JMP ($03FF)
+        cpu.get_memory().write(0x0301, 0xFF);
+        cpu.get_memory().write(0x0302, 0x03);
+        cpu.get_memory().write(0x03FF, 0x10);  // ($03FF) = $0310, read across the page
+        cpu.get_memory().write(0x0400, 0x03);
+        cpu.get_memory().write(0x0310, 0xE8);  // $0310 INX
+        cpu.get_memory().write(0x0311, 0x00);  //       BRK
+        run_program(cpu, program, sizeof(program), engine);
+        print_test_result(cpu.get_X() == 0x03 && cpu.get_PC() == 0x0311 && cpu.get_cycles() == 3 + 2 + 6 + 6 + 2);
+    }
+}
+
+// Test BIT sets N and V from memory and Z from A AND memory, and BIT #imm
+// only changes Z
+void test_bit() {
+    print_test_header("BIT");
+
+    uint8_t program[] = {
+        0xA9, 0xC0,        // LDA #$C0
+        0x85, 0x10,        // STA $10
+        0xA9, 0x01,        // LDA #$01
+        0x24, 0x10,        // BIT $10      N=1 V=1 Z=1
+        0xF0, 0x01,        // BEQ +1
+        0xE8,              // INX          skipped
+        0x89, 0x01,        // BIT #$01     Z=0, N and V unchanged
+        0x00               // BRK
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        run_program(cpu, program, sizeof(program), engine);
+        print_test_result((cpu.get_status() & 0xC2) == 0xC0 && cpu.get_X() == 0x00);
+    }
+}
+
+// Test register transfers and INC A/DEC A
+void test_transfers() {
+    print_test_header("Transfers");
+
+    uint8_t program[] = {
+        0xA9, 0x80,        // LDA #$80
+        0xAA,              // TAX
+        0xE8,              // INX          X=$81
+        0x8A,              // TXA          A=$81
+        0xA8,              // TAY          Y=$81
+        0x1A,              // INC A        A=$82
+        0x1A,              // INC A        A=$83
+        0x98,              // TYA          A=$81
+        0x3A,              // DEC A        A=$80
+        0x00               // BRK
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        run_program(cpu, program, sizeof(program), engine);
+        print_test_result(cpu.get_A() == 0x80 && cpu.get_X() == 0x81 && cpu.get_Y() == 0x81 &&
+                          (cpu.get_status() & 0x82) == 0x80);
+    }
+}
+
+// Test RMB/SMB change one bit and BBR/BBS branch on one
+void test_bit_branches() {
+    print_test_header("RMB/SMB/BBR/BBS");
+
+    uint8_t program[] = {
+        0xA9, 0xFF,        // $0200 LDA #$FF
+        0x85, 0x10,        //       STA $10
+        0x57, 0x10,        //       RMB5 $10     $10 = $DF
+        0x87, 0x10,        //       SMB0 $10     (already set)
+        0x5F, 0x10, 0x02,  //       BBR5 $10,+2  taken
+        0xA2, 0x01,        //       LDX #$01     skipped
+        0xDF, 0x10, 0x02,  //       BBS5 $10,+2  not taken
+        0xA0, 0x01,        //       LDY #$01
+        0x00               //       BRK
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        run_program(cpu, program, sizeof(program), engine);
+        print_test_result(cpu.get_RAM(0x10) == 0xDF && cpu.get_X() == 0x00 && cpu.get_Y() == 0x01 &&
+                          cpu.get_cycles() == 2 + 3 + 5 + 5 + 6 + 5 + 2);
+    }
+}
+
+// Test every opcode has a handler that consumes its operands: each one run
+// alone leaves PC after it, unless it is a jump, and costs the cycles its
+// NOP form documents
+void test_all_opcodes() {
+    print_test_header("All Opcodes");
+
+    bool ok = true;
+    for (unsigned op = 0; op < 256; op++) {
+        if (op == 0x00 || op == 0xCB || op == 0xDB) {
+            continue;  // BRK, WAI and STP stop instead
+        }
+        CPU65C02 cpu;
+        uint8_t program[] = { (uint8_t)op, 0x00, 0x00 };
+        cpu.load_program(program, sizeof(program), 0x0200);
+        cpu.set_PC(0x0200);
+        cpu.set_SP(0xFF);
+        CPU65C02::StopReason reason = cpu.run_instructions(1);
+        bool jumps = op == 0x20 || op == 0x40 || op == 0x4C || op == 0x60 || op == 0x6C || op == 0x7C ||
+                     (op & 0x1F) == 0x10 || (op & 0x0F) == 0x0F || op == 0x80;
+        if (reason != CPU65C02::StopReason::Budget || cpu.get_cycles() == 0 ||
+            (!jumps && cpu.get_PC() != 0x0200 + opcode_length(op))) {
+            cout << "Opcode $" << hex << op << " failed" << endl;
+            ok = false;
+        }
+    }
+    CPU65C02 cpu;
+    uint8_t nops[] = {
+        0x02, 0x00,        // NOP #         2 cycles
+        0x03,              // NOP           1 cycle
+        0x44, 0x00,        // NOP zp        3 cycles
+        0xF4, 0x00,        // NOP zp,X      4 cycles
+        0x5C, 0x00, 0x00,  // NOP abs       8 cycles
+        0xFC, 0x00, 0x00,  // NOP abs       4 cycles
+        0xDB               // STP
+    };
+    cpu.load_program(nops, sizeof(nops), 0x0200);
+    cpu.set_PC(0x0200);
+    ok = ok && cpu.run_cycles(1000) == CPU65C02::StopReason::Halt && cpu.get_PC() == 0x020D &&
+         cpu.get_cycles() == 2 + 1 + 3 + 4 + 8 + 4;
+    print_test_result(ok);
+}
+
+int main() {
+    cout << "Starting Opcode Tests\n";
+
+    test_jsr_rts();
+    test_jumps();
+    test_bit();
+    test_transfers();
+    test_bit_branches();
+    test_all_opcodes();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include "CPU65C02.h"
+#include "Profiler.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+// Test per-PC and per-opcode counts from a profiled run
+void test_counts() {
+    print_test_header("Profile Counts");
+
+    uint8_t program[] = {
+        0xA2, 0x03,        // $0200 LDX #$03
+        0xCA,              // $0202 DEX
+        0xD0, 0xFD,        // $0203 BNE $0202
+        0x00               // $0205 BRK
+    };
+    CPU65C02::Engine engines[] = { CPU65C02::Engine::Switch, CPU65C02::Engine::Jit };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        Profiler profiler;
+        cpu.set_engine(engine);
+        cpu.set_profiler(&profiler);
+        cpu.load_program(program, sizeof(program), 0x0200);
+        cpu.set_PC(0x0200);
+        cpu.run_cycles(1000);
+        // BNE is taken twice (3 cycles each) and falls through once (2)
+        bool ok = profiler.get_count(0x0202) == 3 && profiler.get_cycles(0x0202) == 6 &&
+                  profiler.get_count(0x0203) == 3 && profiler.get_cycles(0x0203) == 8 &&
+                  profiler.get_count(0x0205) == 0 &&
+                  profiler.get_opcode_count(0xCA) == 3 && profiler.get_opcode_cycles(0xA2) == 2;
+        ostringstream report;
+        profiler.report(report);
+        ok = ok && report.str().find("Profile: 7 instructions, 16 cycles") != string::npos &&
+             report.str().find("$0203  BNE $0202") != string::npos &&
+             report.str().find("IMM") != string::npos;
+        print_test_result(ok);
+    }
+}
+
+// Test cycles are charged to the call stack JSR and RTS describe
+void test_folded_stacks() {
+    print_test_header("Folded Call Stacks");
+
+    Profiler profiler;
+    profiler.count(0x0200, 0xA9, 0x01, 0x00, 2);  // LDA #$01
+    profiler.count(0x0202, 0x20, 0x00, 0x10, 6);  // JSR $1000
+    profiler.count(0x1000, 0xE8, 0x00, 0x00, 2);  //   INX
+    profiler.count(0x1001, 0x20, 0x00, 0x20, 6);  //   JSR $2000
+    profiler.count(0x2000, 0xEA, 0x00, 0x00, 2);  //     NOP
+    profiler.count(0x2001, 0x60, 0x00, 0x00, 6);  //     RTS
+    profiler.count(0x1004, 0x60, 0x00, 0x00, 6);  //   RTS
+    profiler.count(0x0205, 0x20, 0x00, 0x20, 6);  // JSR $2000
+    profiler.count(0x2000, 0xEA, 0x00, 0x00, 2);  //   NOP
+    profiler.count(0x2001, 0x60, 0x00, 0x00, 6);  //   RTS
+    profiler.count(0x0208, 0x60, 0x00, 0x00, 6);  // RTS with nothing to return to
+    ostringstream folded;
+    profiler.write_folded(folded);
+    print_test_result(folded.str() ==
+                      "root 20\n"
+                      "root;$1000 14\n"
+                      "root;$1000;$2000 8\n"
+                      "root;$2000 8\n");
+}
+
+// Raises the IRQ at the first boundary from its time, and releases it at
+// the next one, inside the handler
+class IrqPulse : public EventHandler {
+public:
+    explicit IrqPulse(CPU65C02& cpu) : cpu(cpu), raised(false) {}
+    void fire(uint64_t time) override {
+        if (!raised) {
+            cpu.assert_irq();
+            cpu.get_scheduler().schedule(time + 1, this);
+        } else {
+            cpu.release_irq();
+        }
+        raised = !raised;
+    }
+
+private:
+    CPU65C02& cpu;
+    bool raised;
+};
+
+// A subroutine, the handler both vectors point at, and the vectors
+static void load_interrupt_program(CPU65C02& cpu, const uint8_t* main, size_t size) {
+    uint8_t subroutine[] = {
+        0xA2, 0x0A,        // $0300 LDX #$0A
+        0xCA,              // $0302 DEX
+        0xD0, 0xFD,        // $0303 BNE $0302
+        0x60               // $0305 RTS
+    };
+    uint8_t handler[] = {
+        0xC8,              // $0400 INY
+        0x40               // $0401 RTI
+    };
+    uint8_t vectors[] = { 0x00, 0x04, 0x00, 0x02, 0x00, 0x04 };
+    cpu.load_program(main, size, 0x0200);
+    cpu.load_program(subroutine, sizeof(subroutine), 0x0300);
+    cpu.load_program(handler, sizeof(handler), 0x0400);
+    cpu.load_program(vectors, sizeof(vectors), 0xFFFA);
+    cpu.set_PC(0x0200);
+}
+
+// Test interrupt entry is charged to the handler, called from where it was
+// taken, and its RTI returns to the interrupted subroutine
+void test_interrupt_stacks() {
+    print_test_header("Interrupt Call Stacks");
+
+    uint8_t program[] = {
+        0x58,              // $0200 CLI
+        0x20, 0x00, 0x03,  // $0201 JSR $0300
+        0x00               // $0204 BRK
+    };
+    CPU65C02::Engine engines[] = { CPU65C02::Engine::Switch, CPU65C02::Engine::Jit };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        Profiler profiler;
+        IrqPulse pulse(cpu);
+        cpu.set_engine(engine);
+        cpu.set_profiler(&profiler);
+        load_interrupt_program(cpu, program, sizeof(program));
+        // Taken in the DEX/BNE loop, once CLI, JSR, LDX and two rounds are done
+        cpu.get_scheduler().schedule(20, &pulse);
+        CPU65C02::StopReason reason = cpu.run_cycles(1000);
+        ostringstream folded;
+        profiler.write_folded(folded);
+        print_test_result(reason == CPU65C02::StopReason::Brk && cpu.get_Y() == 1 &&
+                          profiler.get_interrupts() == 1 && profiler.get_interrupt_cycles() == 7 &&
+                          folded.str() ==
+                          "root 8\n"
+                          "root;$0300 57\n"
+                          "root;$0300;$0400 15\n");
+    }
+}
+
+// Test a BRK taken as an interrupt calls its handler
+void test_brk_stacks() {
+    print_test_header("BRK Call Stacks");
+
+    uint8_t program[] = {
+        0x20, 0x06, 0x02,  // $0200 JSR $0206
+        0xDB,              // $0203 STP
+        0xEA, 0xEA,
+        0x00, 0xEA,        // $0206 BRK with its signature byte
+        0x60               // $0208 RTS
+    };
+    CPU65C02 cpu;
+    Profiler profiler;
+    cpu.set_engine(CPU65C02::Engine::Switch);
+    cpu.set_profiler(&profiler);
+    cpu.set_brk_stops(false);
+    load_interrupt_program(cpu, program, sizeof(program));
+    CPU65C02::StopReason reason = cpu.run_cycles(1000);
+    ostringstream folded;
+    profiler.write_folded(folded);
+    print_test_result(reason == CPU65C02::StopReason::Halt && cpu.get_Y() == 1 &&
+                      folded.str() ==
+                      "root 6\n"
+                      "root;$0206 13\n"
+                      "root;$0206;$0400 8\n");
+}
+
+int main() {
+    cout << "Starting Profiler Tests\n";
+
+    test_counts();
+    test_folded_stacks();
+    test_interrupt_stacks();
+    test_brk_stacks();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
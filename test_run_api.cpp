@@ -0,0 +1,225 @@
+#include "CPU65C02.h"
+#include <iostream>
+#include <iomanip>
+#include <cassert>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+// Endless INX loop
+static uint8_t loop_program[] = {
+    0xE8,        // INX          (2 cycles)
+    0x80, 0xFD   // BRA $0000    (3 cycles)
+};
+
+// Test run_instructions() stops after exactly N instructions
+void test_run_instructions() {
+    print_test_header("run_instructions");
+
+    CPU65C02::Engine engines[] = {
+        CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+        CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        cpu.load_program(loop_program, sizeof(loop_program));
+        cpu.reset();
+        cpu.set_engine(engine);
+        CPU65C02::StopReason reason = cpu.run_instructions(11);
+        // Six INX and five BRA
+        print_test_result(reason == CPU65C02::StopReason::Budget &&
+                          cpu.get_X() == 6 && cpu.get_PC() == 0x0001 &&
+                          cpu.get_cycles() == 6 * 2 + 5 * 3);
+    }
+}
+
+// Test run_cycles() stops at the first instruction boundary past the budget
+void test_run_cycles() {
+    print_test_header("run_cycles");
+
+    CPU65C02::Engine engines[] = {
+        CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+        CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        cpu.load_program(loop_program, sizeof(loop_program));
+        cpu.reset();
+        cpu.set_engine(engine);
+        CPU65C02::StopReason first = cpu.run_cycles(10);   // INX BRA INX BRA
+        bool ok = first == CPU65C02::StopReason::Budget && cpu.get_cycles() == 10 && cpu.get_X() == 2;
+        CPU65C02::StopReason second = cpu.run_cycles(1);   // INX
+        ok = ok && second == CPU65C02::StopReason::Budget && cpu.get_cycles() == 12 && cpu.get_X() == 3;
+        print_test_result(ok);
+    }
+}
+
+// Test BRK and STP end a run with the right reason
+void test_stop_reasons() {
+    print_test_header("Stop Reasons");
+
+    CPU65C02 cpu;
+    {
+        uint8_t program[] = {
+            0xA9, 0x42,  // LDA #$42
+            0x00         // BRK
+        };
+        cpu.load_program(program, sizeof(program));
+        cpu.reset();
+        CPU65C02::StopReason reason = cpu.run_cycles(1000);
+        print_test_result(reason == CPU65C02::StopReason::Brk && cpu.get_PC() == 0x0002 && cpu.get_A() == 0x42);
+    }
+    {
+        uint8_t program[] = {
+            0xE8,        // INX
+            0xDB         // STP
+        };
+        cpu.load_program(program, sizeof(program));
+        cpu.reset();
+        CPU65C02::StopReason reason = cpu.run_instructions(10);
+        print_test_result(reason == CPU65C02::StopReason::Halt && cpu.get_PC() == 0x0001);
+    }
+}
+
+// Test the block core sees code written by the program and by the host
+void test_self_modifying_code() {
+    print_test_header("Self-Modifying Code");
+
+    uint8_t program[] = {
+        0xA9, 0x07,        // $0200 LDA #$07
+        0x8D, 0x06, 0x02,  // $0202 STA $0206   (operand of the next LDX)
+        0xA2, 0x00,        // $0205 LDX #$00    (runs as LDX #$07)
+        0xE8,              // $0207 INX
+        0xEE, 0x06, 0x02,  // $0208 INC $0206
+        0x80, 0xF8,        // $020B BRA $0205
+    };
+    CPU65C02 cpu;
+    cpu.set_engine(CPU65C02::Engine::Block);
+    cpu.load_program(program, sizeof(program), 0x0200);
+    cpu.set_PC(0x0200);
+    // The store lands inside the block being run
+    cpu.run_instructions(4);
+    print_test_result(cpu.get_X() == 0x08);
+    // Each pass round the loop rewrites its own LDX
+    cpu.run_instructions(4 * 3);
+    print_test_result(cpu.get_X() == 0x0B && cpu.get_PC() == 0x0208);
+
+    // Writes from outside a run and restoring a snapshot both drop stale blocks
+    cpu.set_PC(0x0205);
+    CPU65C02::Snapshot snap = cpu.snapshot();
+    cpu.get_memory().write(0x0206, 0x40);
+    cpu.run_instructions(2);
+    bool ok = cpu.get_X() == 0x41;
+    cpu.restore(snap);
+    cpu.run_instructions(2);
+    print_test_result(ok && cpu.get_X() == 0x0B);
+}
+
+// Test the block and JIT cores stop where the reference core does, on a
+// loop that rewrites its own code, whatever slices the budget comes in
+void test_engines_agree() {
+    print_test_header("Engines Agree");
+
+    uint8_t program[] = {
+        0xA2, 0x00,        // $0200 LDX #$00
+        0xA0, 0x40,        // $0202 LDY #$40
+        0xE8,              // $0204 INX
+        0x8E, 0x00, 0x30,  // $0205 STX $3000
+        0xA9, 0x05,        // $0208 LDA #$05
+        0x85, 0x10,        // $020A STA $10
+        0xEE, 0x09, 0x02,  // $020C INC $0209
+        0x18,              // $020F CLC
+        0x88,              // $0210 DEY
+        0xD0, 0xF1,        // $0211 BNE $0204
+        0x00               // $0213 BRK
+    };
+    CPU65C02::Engine engines[] = { CPU65C02::Engine::Block, CPU65C02::Engine::Jit };
+    uint64_t slices[] = { 1, 3, 7, 1000 };
+    for (CPU65C02::Engine engine : engines) {
+        bool ok = true;
+        for (uint64_t slice : slices) {
+            CPU65C02 reference;
+            CPU65C02 cpu;
+            reference.set_engine(CPU65C02::Engine::Table);
+            cpu.set_engine(engine);
+            CPU65C02* both[] = { &reference, &cpu };
+            for (CPU65C02* c : both) {
+                c->load_program(program, sizeof(program), 0x0200);
+                c->set_PC(0x0200);
+            }
+            CPU65C02::StopReason reason = CPU65C02::StopReason::Budget;
+            while (ok && reason == CPU65C02::StopReason::Budget) {
+                reason = reference.run_cycles(slice);
+                ok = cpu.run_cycles(slice) == reason &&
+                     cpu.get_PC() == reference.get_PC() && cpu.get_cycles() == reference.get_cycles() &&
+                     cpu.get_A() == reference.get_A() && cpu.get_X() == reference.get_X() &&
+                     cpu.get_Y() == reference.get_Y() && cpu.get_status() == reference.get_status() &&
+                     cpu.get_RAM(0x3000) == reference.get_RAM(0x3000) &&
+                     cpu.get_RAM(0x0209) == reference.get_RAM(0x0209);
+            }
+            ok = ok && reason == CPU65C02::StopReason::Brk && cpu.get_RAM(0x10) == 0x44;
+        }
+        print_test_result(ok);
+    }
+}
+
+// Test blocks that carry on past conditional branches leave them when one
+// is taken, in whichever direction, and count the same cycles
+void test_branches_in_blocks() {
+    print_test_header("Branches Inside Blocks");
+
+    uint8_t program[] = {
+        0xA2, 0x00,        // $0200 LDX #$00
+        0xA0, 0x00,        // $0202 LDY #$00
+        0x8A,              // $0204 TXA
+        0x29, 0x03,        //       AND #$03
+        0xF0, 0x02,        //       BEQ $020B
+        0xC8,              //       INY
+        0xC8,              //       INY
+        0x4A,              // $020B LSR A
+        0x90, 0x01,        //       BCC $020F
+        0xC8,              //       INY
+        0xE8,              // $020F INX
+        0xD0, 0xF2,        //       BNE $0204
+        0x84, 0x10,        //       STY $10
+        0x00               //       BRK
+    };
+    CPU65C02 reference;
+    reference.set_engine(CPU65C02::Engine::Table);
+    reference.load_program(program, sizeof(program), 0x0200);
+    reference.set_PC(0x0200);
+    CPU65C02::StopReason expected = reference.run_cycles(100000);
+
+    CPU65C02::Engine engines[] = { CPU65C02::Engine::Block, CPU65C02::Engine::Jit };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        cpu.set_engine(engine);
+        cpu.load_program(program, sizeof(program), 0x0200);
+        cpu.set_PC(0x0200);
+        print_test_result(cpu.run_cycles(100000) == expected && expected == CPU65C02::StopReason::Brk &&
+                          cpu.get_PC() == reference.get_PC() && cpu.get_cycles() == reference.get_cycles() &&
+                          cpu.get_Y() == reference.get_Y() && cpu.get_status() == reference.get_status() &&
+                          cpu.get_RAM(0x10) == (uint8_t)(192 * 2 + 128));
+    }
+}
+
+int main() {
+    cout << "Starting Run API Tests\n";
+
+    test_run_instructions();
+    test_run_cycles();
+    test_stop_reasons();
+    test_self_modifying_code();
+    test_engines_agree();
+    test_branches_in_blocks();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
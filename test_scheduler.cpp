@@ -0,0 +1,191 @@
+#include "CPU65C02.h"
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+static CPU65C02::Engine engines[] = {
+    CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+    CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+};
+
+// A periodic timer on page $C0. It raises IRQ every period cycles; reading
+// $C000 acknowledges it. Writing n to $C001 instead raises NMI once, n
+// cycles later.
+class Timer : public IoDevice, public EventHandler {
+public:
+    Timer(CPU65C02& cpu, uint64_t period) : cpu(cpu), period(period), fired(0), late(0), one_shot(false) {
+        cpu.get_memory().map_io(0xC0, 0xC0, this);
+        if (period) {
+            cpu.get_scheduler().schedule(cpu.get_cycles() + period, this);
+        }
+    }
+
+    uint8_t read(uint16_t) override {
+        cpu.release_irq(0x02);
+        return 0;
+    }
+
+    void write(uint16_t, uint8_t value) override {
+        one_shot = true;
+        cpu.get_scheduler().schedule(cpu.get_cycles() + value, this);
+    }
+
+    void fire(uint64_t time) override {
+        fired++;
+        late = max(late, cpu.get_cycles() - time);
+        if (one_shot) {
+            cpu.nmi();
+            return;
+        }
+        cpu.assert_irq(0x02);
+        cpu.get_scheduler().schedule(time + period, this);
+    }
+
+    CPU65C02& cpu;
+    uint64_t period;
+    unsigned fired;
+    uint64_t late; // Most cycles an event fired after its time
+    bool one_shot;
+};
+
+// Load a program at $0200 and a handler at $0300, which both IRQ and NMI
+// vector to
+static void load(CPU65C02& cpu, CPU65C02::Engine engine, const uint8_t* program, size_t size,
+                 const uint8_t* handler, size_t handler_size) {
+    uint8_t vectors[] = { 0x00, 0x03, 0x00, 0x02, 0x00, 0x03 };
+    cpu.set_engine(engine);
+    cpu.load_program(program, size, 0x0200);
+    cpu.load_program(handler, handler_size, 0x0300);
+    cpu.load_program(vectors, sizeof(vectors), 0xFFFA);
+    cpu.reset();
+}
+
+// Test the scheduler itself: earliest first, same-time events in the order
+// scheduled, cancel, and handlers scheduling events that are already due
+void test_scheduler_order() {
+    print_test_header("Scheduler Order");
+
+    struct Recorder : EventHandler {
+        Scheduler* scheduler = nullptr;
+        int id = 0;
+        vector<int>* order = nullptr;
+        void fire(uint64_t time) override {
+            order->push_back(id);
+            if (id == 3) {
+                scheduler->schedule(time, this + 1);  // Already due
+            }
+        }
+    };
+    Scheduler scheduler;
+    vector<int> order;
+    Recorder handlers[5];
+    for (int i = 0; i < 5; i++) {
+        handlers[i].scheduler = &scheduler;
+        handlers[i].id = i;
+        handlers[i].order = &order;
+    }
+    scheduler.schedule(30, &handlers[0]);
+    scheduler.schedule(10, &handlers[1]);
+    scheduler.schedule(10, &handlers[2]);
+    scheduler.schedule(20, &handlers[3]);
+    scheduler.schedule(15, &handlers[0]);
+    scheduler.cancel(&handlers[0]);
+    scheduler.run_due(5);
+    bool ok = order.empty() && scheduler.next_time() == 10;
+    scheduler.run_due(25);
+    print_test_result(ok && order == vector<int>({ 1, 2, 3, 4 }) && scheduler.empty());
+}
+
+// Test a periodic timer interrupt is taken on time while the main loop
+// keeps running, on every core
+void test_timer_irq() {
+    print_test_header("Timer IRQ");
+
+    uint8_t program[] = {
+        0x58,              // $0200 CLI
+        0xE8,              // $0201 INX
+        0x80, 0xFD         //       BRA $0201
+    };
+    uint8_t handler[] = {
+        0xAD, 0x00, 0xC0,  // $0300 LDA $C000    acknowledge
+        0xE6, 0x10,        //       INC $10
+        0x40               //       RTI
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        load(cpu, engine, program, sizeof(program), handler, sizeof(handler));
+        Timer timer(cpu, 100);
+        cpu.run_cycles(10000);
+        print_test_result(timer.fired == 99 && cpu.get_RAM(0x10) == 99 && timer.late < 7 &&
+                          cpu.get_SP() == 0xFF);
+    }
+}
+
+// Test an event scheduled by an I/O write during a run, earlier than the
+// run's deadline, still fires on time
+void test_event_from_write() {
+    print_test_header("Event From Write");
+
+    uint8_t program[] = {
+        0xA9, 0x32,        // $0200 LDA #50
+        0x8D, 0x01, 0xC0,  //       STA $C001
+        0xE8,              // $0205 INX
+        0x80, 0xFD         //       BRA $0205
+    };
+    uint8_t handler[] = {
+        0xDB               // $0300 STP
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        load(cpu, engine, program, sizeof(program), handler, sizeof(handler));
+        Timer timer(cpu, 0);
+        CPU65C02::StopReason reason = cpu.run_cycles(100000);
+        print_test_result(reason == CPU65C02::StopReason::Halt && timer.fired == 1 && timer.late < 3 &&
+                          cpu.get_cycles() >= 2 + 4 + 50 + 7 && cpu.get_cycles() < 2 + 4 + 50 + 3 + 7);
+    }
+}
+
+// Test WAI skips straight to the next event instead of running idle cycles
+void test_wai_skips_to_event() {
+    print_test_header("WAI Until Event");
+
+    uint8_t program[] = {
+        0x58,              // $0200 CLI
+        0xCB,              // $0201 WAI
+        0x80, 0xFD         //       BRA $0201
+    };
+    uint8_t handler[] = {
+        0xAD, 0x00, 0xC0,  // $0300 LDA $C000
+        0xE6, 0x10,        //       INC $10
+        0x40               //       RTI
+    };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        load(cpu, engine, program, sizeof(program), handler, sizeof(handler));
+        Timer timer(cpu, 1000);
+        CPU65C02::StopReason reason = cpu.run_cycles(100500);
+        print_test_result(reason == CPU65C02::StopReason::Budget && cpu.get_RAM(0x10) == 100 &&
+                          cpu.get_cycles() == 100500 && timer.late == 0);
+    }
+}
+
+int main() {
+    cout << "Starting Scheduler Tests\n";
+
+    test_scheduler_order();
+    test_timer_irq();
+    test_event_from_write();
+    test_wai_skips_to_event();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include "CPU65C02.h"
+#include "Disassembler.h"
+#include "TraceRecorder.h"
+#include <cstdio>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+static vector<TraceRecord> read_all(const string& path) {
+    vector<TraceRecord> records;
+    TraceReader reader(path);
+    TraceRecord r;
+    while (reader.next(r)) {
+        records.push_back(r);
+    }
+    return records;
+}
+
+// Test a recorded run reads back with the state before every instruction
+void test_record_program() {
+    print_test_header("Record Program");
+
+    uint8_t program[] = {
+        0xA2, 0x03,        // $0200 LDX #$03
+        0xCA,              // $0202 DEX
+        0xD0, 0xFD,        // $0203 BNE $0202
+        0x8E, 0x00, 0x30,  // $0205 STX $3000
+        0x00               // $0208 BRK
+    };
+    string path = "test_trace.bin";
+    CPU65C02::Engine engines[] = { CPU65C02::Engine::Threaded, CPU65C02::Engine::Jit };
+    for (CPU65C02::Engine engine : engines) {
+        CPU65C02 cpu;
+        cpu.set_engine(engine);
+        cpu.load_program(program, sizeof(program), 0x0200);
+        cpu.set_PC(0x0200);
+        {
+            TraceRecorder recorder(path);
+            cpu.set_recorder(&recorder);
+            cpu.run_cycles(1000);
+            cpu.set_recorder(nullptr);
+            recorder.close();
+        }
+        vector<TraceRecord> records = read_all(path);
+        // LDX, then DEX/BNE three times, then STX; BRK stops without running
+        bool ok = records.size() == 8;
+        uint64_t cycles = 0;
+        for (const TraceRecord& r : records) {
+            cycles += r.cycles;
+        }
+        ok = ok && cycles == cpu.get_cycles();
+        ok = ok && records[0].pc == 0x0200 && records[1].pc == 0x0202 && records[1].X == 3;
+        ok = ok && records[6].pc == 0x0203 && records[6].cycles == 2 && records[4].cycles == 3;
+        ok = ok && records[7].opcode == 0x8E && records[7].X == 0 && (records[7].P & 0x02);
+        print_test_result(ok);
+    }
+    remove(path.c_str());
+}
+
+// Test interrupt entry gets a record of its own, so the cycles add up
+void test_record_interrupt() {
+    print_test_header("Record Interrupt");
+
+    uint8_t program[] = {
+        0xE8,              // $0200 INX
+        0x00               // $0201 BRK
+    };
+    uint8_t handler[] = {
+        0x40               // $0300 RTI
+    };
+    uint8_t nmi_vector[] = { 0x00, 0x03 };
+    string path = "test_trace_nmi.bin";
+    CPU65C02 cpu;
+    cpu.load_program(program, sizeof(program), 0x0200);
+    cpu.load_program(handler, sizeof(handler), 0x0300);
+    cpu.load_program(nmi_vector, sizeof(nmi_vector), 0xFFFA);
+    cpu.set_PC(0x0200);
+    cpu.nmi();
+    {
+        TraceRecorder recorder(path);
+        cpu.set_recorder(&recorder);
+        cpu.run_cycles(1000);
+        cpu.set_recorder(nullptr);
+        recorder.close();
+    }
+    vector<TraceRecord> records = read_all(path);
+    // NMI entry, RTI, INX
+    bool ok = records.size() == 3 && records[0].kind == TRACE_INTERRUPT && records[0].pc == 0x0200 &&
+              records[0].opcode == 0xFA && records[0].operand[0] == 0x00 && records[0].operand[1] == 0x03 &&
+              records[0].cycles == 7 && records[1].kind == TRACE_INSTRUCTION && records[1].pc == 0x0300 &&
+              records[2].pc == 0x0200 &&
+              (uint64_t)(records[0].cycles + records[1].cycles + records[2].cycles) == cpu.get_cycles();
+    print_test_result(ok);
+    remove(path.c_str());
+}
+
+// Test the writer keeps up with a ring far smaller than the trace, losing nothing
+void test_ring_wraps() {
+    print_test_header("Ring Buffer Wrap-Around");
+
+    uint8_t loop_program[] = {
+        0xE8,        // INX
+        0x80, 0xFD   // BRA $0000
+    };
+    string path = "test_trace_wrap.bin";
+    CPU65C02 cpu;
+    cpu.load_program(loop_program, sizeof(loop_program));
+    cpu.reset();
+    {
+        TraceRecorder recorder(path, 16);
+        cpu.set_recorder(&recorder);
+        cpu.run_instructions(100000);
+        recorder.close();
+        cpu.set_recorder(nullptr);
+    }
+    vector<TraceRecord> records = read_all(path);
+    bool ok = records.size() == 100000;
+    for (size_t i = 0; ok && i < records.size(); i++) {
+        ok = records[i].pc == (i % 2 ? 0x0001 : 0x0000) && records[i].X == (uint8_t)((i + 1) / 2);
+    }
+    print_test_result(ok);
+    remove(path.c_str());
+}
+
+// Test the disassembler used by the trace decoder
+void test_disassemble() {
+    print_test_header("Disassembler");
+
+    print_test_result(disassemble(0x0200, 0xBD, 0xF0, 0x02) == "LDA $02F0,X" &&
+                      disassemble(0x0203, 0xD0, 0xFD, 0x00) == "BNE $0202" &&
+                      disassemble(0x0000, 0xB1, 0x20, 0x00) == "LDA ($20),Y" &&
+                      disassemble(0x0000, 0xA9, 0x42, 0x00) == "LDA #$42" &&
+                      disassemble(0x0000, 0x0A, 0x00, 0x00) == "ASL A" &&
+                      disassemble(0x0000, 0xE8, 0x00, 0x00) == "INX" &&
+                      disassemble(0x0000, 0x02, 0x00, 0x00) == "NOP #$00" &&
+                      disassemble(0x0200, 0x8F, 0x10, 0xFD) == "BBS0 $10,$0200" &&
+                      disassemble(0x0000, 0x7C, 0x34, 0x12) == "JMP ($1234,X)" &&
+                      opcode_length(0xBD) == 3 && string(opcode_mnemonic(0x8E)) == "STX");
+}
+
+int main() {
+    cout << "Starting Trace Tests\n";
+
+    test_record_program();
+    test_record_interrupt();
+    test_ring_wraps();
+    test_disassemble();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
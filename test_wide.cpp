@@ -0,0 +1,222 @@
+#include "CPU65C02.h"
+#include "WideCPU.h"
+#include "crc_program.h"
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+void print_test_header(const char* test_name) {
+    cout << "\n=== Testing " << test_name << " ===\n";
+}
+
+void print_test_result(bool passed) {
+    cout << (passed ? "PASSED" : "FAILED") << endl;
+}
+
+static CPU65C02::Engine engines[] = {
+    CPU65C02::Engine::Table, CPU65C02::Engine::Switch, CPU65C02::Engine::Threaded,
+    CPU65C02::Engine::Block, CPU65C02::Engine::Jit
+};
+
+// Whether a lane ended where running it alone leaves it: registers, P,
+// cycles, how it stopped and every page either one wrote
+static bool same_state(CPU65C02& lane, CPU65C02::StopReason lane_stop, CPU65C02& alone,
+                       CPU65C02::StopReason alone_stop) {
+    const CPU65C02::Registers& a = lane.get_registers();
+    const CPU65C02::Registers& b = alone.get_registers();
+    if (lane_stop != alone_stop || a.PC != b.PC || a.A != b.A || a.X != b.X || a.Y != b.Y || a.S != b.S ||
+        a.P() != b.P() || lane.get_cycles() != alone.get_cycles()) {
+        return false;
+    }
+    for (CPU65C02* cpu : { &lane, &alone }) {
+        Memory& memory = cpu->get_memory();
+        for (unsigned i = 0; i < memory.written_page_count(); i++) {
+            uint16_t base = memory.written_page(i) << 8;
+            for (unsigned offset = 0; offset < 256; offset++) {
+                if (lane.get_RAM(base + offset) != alone.get_RAM(base + offset)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Test lanes whose data differs end as they would alone, on every engine
+void test_crc() {
+    print_test_header("Lanes Splitting and Rejoining");
+
+    for (CPU65C02::Engine engine : engines) {
+        WideCPU wide;
+        vector<CPU65C02::StopReason> alone_stops;
+        vector<unique_ptr<CPU65C02>> alone;
+        for (unsigned i = 0; i < wide.get_lanes(); i++) {
+            wide.lane(i).set_engine(engine);
+            load_crc(wide.lane(i), 1, i);
+            alone.emplace_back(new CPU65C02());
+            alone[i]->set_engine(engine);
+            load_crc(*alone[i], 1, i);
+            alone_stops.push_back(alone[i]->run_cycles(1000000));
+        }
+        wide.run_cycles(1000000);
+        bool same = true;
+        for (unsigned i = 0; i < wide.get_lanes(); i++) {
+            same &= same_state(wide.lane(i), wide.get_stop_reason(i), *alone[i], alone_stops[i]);
+        }
+        // Most of the work is shared even though every lane's CRC differs
+        print_test_result(same && alone_stops[0] == CPU65C02::StopReason::Brk &&
+                          wide.lane(0).get_RAM(0xF0) == (crc_expected(1, 0) & 0xFF) &&
+                          wide.lane(0).get_RAM(0xF0) != wide.lane(1).get_RAM(0xF0) &&
+                          wide.get_wide_instructions() > 4 * wide.get_scalar_instructions());
+    }
+}
+
+// Test budgets split across runs stop every lane where one run would
+void test_budgets() {
+    print_test_header("Lane Budgets");
+
+    WideCPU wide(5);
+    CPU65C02 alone[5];
+    CPU65C02::StopReason alone_stops[5];
+    for (unsigned i = 0; i < 5; i++) {
+        load_crc(wide.lane(i), 1, i);
+        load_crc(alone[i], 1, i);
+        alone_stops[i] = alone[i].run_instructions(1234);
+    }
+    wide.run_instructions(1000);
+    wide.run_instructions(234);
+    bool same = true;
+    for (unsigned i = 0; i < 5; i++) {
+        same &= same_state(wide.lane(i), wide.get_stop_reason(i), alone[i], alone_stops[i]);
+    }
+    print_test_result(same && alone_stops[0] == CPU65C02::StopReason::Budget);
+
+    for (unsigned i = 0; i < 5; i++) {
+        alone_stops[i] = alone[i].run_cycles(777);
+    }
+    wide.run_cycles(777);
+    same = true;
+    for (unsigned i = 0; i < 5; i++) {
+        same &= same_state(wide.lane(i), wide.get_stop_reason(i), alone[i], alone_stops[i]);
+    }
+    print_test_result(same);
+
+    // Nothing runs on an empty budget
+    uint64_t cycles = wide.lane(0).get_cycles();
+    wide.run_cycles(0);
+    print_test_result(wide.lane(0).get_cycles() == cycles &&
+                      wide.get_stop_reason(0) == CPU65C02::StopReason::Budget);
+}
+
+class Latch : public IoDevice {
+public:
+    uint8_t value = 0;
+    uint8_t read(uint16_t) override { return value; }
+    void write(uint16_t, uint8_t v) override { value = v; }
+};
+
+// Test a lane with an I/O page runs alone and is still right
+void test_lane_alone() {
+    print_test_header("Lane With I/O");
+
+    Latch latch[2];
+    WideCPU wide(3);
+    CPU65C02 alone;
+    for (unsigned i = 0; i < 3; i++) {
+        load_crc(wide.lane(i), 1, 1);
+    }
+    load_crc(alone, 1, 1);
+    wide.lane(1).get_memory().map_io(0xC0, 0xC0, &latch[0]);
+    alone.get_memory().map_io(0xC0, 0xC0, &latch[1]);
+    CPU65C02::StopReason stop = alone.run_cycles(1000000);
+    wide.run_cycles(1000000);
+    print_test_result(same_state(wide.lane(1), wide.get_stop_reason(1), alone, stop) &&
+                      same_state(wide.lane(0), wide.get_stop_reason(0), alone, stop));
+}
+
+// Random instruction streams, shared by the lanes, from registers and zero
+// page data that are not. Every lane must end where running it alone does.
+void test_random_programs() {
+    print_test_header("Random Programs");
+
+    mt19937 rng(7);
+    vector<uint8_t> image(0x10000);
+    for (uint8_t& b : image) {
+        b = (uint8_t)rng();
+    }
+    MemoryImage shared(image.data(), image.size(), 0);
+    const unsigned TRIALS = 200;
+    unsigned failures = 0;
+    uint64_t wide_instructions = 0;
+    for (unsigned trial = 0; trial < TRIALS; trial++) {
+        uint8_t code[48];
+        for (uint8_t& b : code) {
+            b = (uint8_t)rng();
+            // Fewer stops, so the streams run on
+            if (b == 0x00 || b == 0xDB || b == 0xCB) {
+                b = 0xEA;
+            }
+        }
+        WideCPU wide;
+        for (unsigned i = 0; i < wide.get_lanes(); i++) {
+            uint8_t zero_page[32], regs[5];
+            for (uint8_t& b : zero_page) {
+                // A few lanes share their data, the rest do not
+                b = (uint8_t)(i < 4 ? trial : rng());
+            }
+            for (uint8_t& b : regs) {
+                b = (uint8_t)(i < 4 ? trial * 3 : rng());
+            }
+            uint16_t zero_page_address = (uint16_t)(rng() % 0xE0);
+            CPU65C02& cpu = wide.lane(i);
+            cpu.load_image(shared);
+            cpu.load_program(code, sizeof(code), 0x0400);
+            cpu.load_program(zero_page, sizeof(zero_page), zero_page_address);
+            cpu.set_PC(0x0400);
+            cpu.set_A(regs[0]);
+            cpu.set_X(regs[1]);
+            cpu.set_Y(regs[2]);
+            cpu.set_SP(regs[3]);
+            cpu.set_P(regs[4]);
+        }
+        // Run each lane alone first, from copies of its starting state
+        vector<CPU65C02::Snapshot> starts;
+        for (unsigned i = 0; i < wide.get_lanes(); i++) {
+            starts.push_back(wide.lane(i).snapshot());
+        }
+        bool count = trial % 2 == 0;
+        uint64_t budget = count ? 40 : 160;
+        vector<unique_ptr<CPU65C02>> alone;
+        vector<CPU65C02::StopReason> alone_stops;
+        for (unsigned i = 0; i < wide.get_lanes(); i++) {
+            alone.emplace_back(new CPU65C02());
+            alone[i]->set_engine(CPU65C02::Engine::Table);
+            alone[i]->restore(starts[i]);
+            alone_stops.push_back(count ? alone[i]->run_instructions(budget) : alone[i]->run_cycles(budget));
+        }
+        uint64_t before = wide.get_wide_instructions();
+        count ? wide.run_instructions(budget) : wide.run_cycles(budget);
+        wide_instructions += wide.get_wide_instructions() - before;
+        for (unsigned i = 0; i < wide.get_lanes(); i++) {
+            if (!same_state(wide.lane(i), wide.get_stop_reason(i), *alone[i], alone_stops[i])) {
+                failures++;
+                cout << "trial " << trial << " lane " << i << " differs" << endl;
+            }
+        }
+    }
+    print_test_result(failures == 0 && wide_instructions > TRIALS * 32);
+}
+
+int main() {
+    cout << "Starting Wide CPU Tests\n";
+
+    test_crc();
+    test_budgets();
+    test_lane_alone();
+    test_random_programs();
+
+    cout << "\nAll tests completed.\n";
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "Disassembler.h"
+#include "Profiler.h"
+#include "TraceRecorder.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+static void usage() {
+    cerr << "usage: 6502trace [-n count] [-p | -f] trace" << endl;
+    cerr << "  -p  print a profile of the trace instead of the instructions" << endl;
+    cerr << "  -f  print cycles per call stack in flamegraph folded format" << endl;
+}
+
+int main(int argc, char** argv) {
+    uint64_t limit = UINT64_MAX;
+    const char* trace_path = nullptr;
+    bool profile = false, folded = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            limit = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-p") == 0) {
+            profile = true;
+        } else if (strcmp(argv[i], "-f") == 0) {
+            folded = true;
+        } else if (argv[i][0] != '-' && !trace_path) {
+            trace_path = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!trace_path || (profile && folded)) {
+        usage();
+        return 2;
+    }
+
+    try {
+        TraceReader reader(trace_path);
+        TraceRecord r;
+        if (profile || folded) {
+            Profiler profiler;
+            for (uint64_t n = 0; n < limit && reader.next(r); n++) {
+                if (r.kind == TRACE_INTERRUPT) {
+                    profiler.interrupt(r.pc, r.operand[0] | (r.operand[1] << 8), r.cycles);
+                } else {
+                    profiler.count(r.pc, r.opcode, r.operand[0], r.operand[1], r.cycles);
+                }
+            }
+            if (profile) {
+                profiler.report(cout);
+            } else {
+                profiler.write_folded(cout);
+            }
+            return 0;
+        }
+        uint64_t cycles = 0;
+        // One line per instruction, with the cycle count it started on and
+        // the registers it saw; printf keeps multi-million line dumps quick
+        printf("%-12s %-4s  %-8s  %-16s %-2s %-2s %-2s %-2s %-2s\n",
+               "cycle", "pc", "bytes", "instruction", "a", "x", "y", "s", "p");
+        for (uint64_t n = 0; n < limit && reader.next(r); n++) {
+            if (r.kind == TRACE_INTERRUPT) {
+                char entry[24];
+                snprintf(entry, sizeof(entry), "%s -> $%02X%02X", r.opcode == 0xFA ? "NMI" : "IRQ",
+                         r.operand[1], r.operand[0]);
+                printf("%-12llu %04X  %-8s  %-16s %02X %02X %02X %02X %02X\n",
+                       (unsigned long long)cycles, r.pc, "", entry, r.A, r.X, r.Y, r.S, r.P);
+                cycles += r.cycles;
+                continue;
+            }
+            unsigned length = opcode_length(r.opcode);
+            char bytes[9];
+            snprintf(bytes, sizeof(bytes), "%02X", r.opcode);
+            for (unsigned i = 1; i < length; i++) {
+                snprintf(bytes + 3 * i - 1, sizeof(bytes) - (3 * i - 1), " %02X", r.operand[i - 1]);
+            }
+            printf("%-12llu %04X  %-8s  %-16s %02X %02X %02X %02X %02X\n",
+                   (unsigned long long)cycles, r.pc, bytes,
+                   disassemble(r.pc, r.opcode, r.operand[0], r.operand[1]).c_str(),
+                   r.A, r.X, r.Y, r.S, r.P);
+            cycles += r.cycles;
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}